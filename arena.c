@@ -0,0 +1,188 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include "kernel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+/*
+ * Per-process bump arenas. proc_alloc() hands out memory from the calling
+ * process's current page by moving a pointer; there is no per-object free.
+ * Pages are ARENA_PAGE_SIZE bytes and come from a kernel pool, which takes
+ * a chunk of ARENA_CHUNK_PAGES of them from the kernel heap whenever it runs
+ * dry. A process keeps its pages on a list, newest first, with a pointer to
+ * the oldest, so reapChild() can give them all back by splicing the list
+ * onto the pool in constant time. A process that never calls proc_alloc()
+ * has no pages. Under smpRun() processes on different CPUs allocate and are
+ * reaped at the same time, so the pool has a spinlock, like the kernel heap.
+ */
+
+// a chunk fills a 64 KB heap block, header included
+#define ARENA_CHUNK_BYTES  (64 * 1024 - KHEAP_HEADER)
+#define ARENA_CHUNK_PAGES  (ARENA_CHUNK_BYTES / ARENA_PAGE_SIZE)
+#define ARENA_ALIGN        16
+
+struct ArenaPage {
+    struct ArenaPage *next; // older page of the same process, or next free page
+    int used; // bytes of data handed out
+    char data[] __attribute__((aligned(ARENA_ALIGN)));
+};
+
+_Static_assert(offsetof(struct ArenaPage, data) + ARENA_MAX_ALLOC == ARENA_PAGE_SIZE,
+               "ARENA_MAX_ALLOC does not match the page header");
+
+// unused pages
+static struct ArenaPage *freePages;
+
+int arenaPagesInUse;
+static int arenaPagesFree;
+static int arenaPagesTotal;
+static long arenaAllocs;
+
+#ifdef HOST_SMP
+static volatile char poolLock;
+#define POOL_LOCK()    while (__atomic_test_and_set(&poolLock, __ATOMIC_ACQUIRE)) { }
+#define POOL_UNLOCK()  __atomic_clear(&poolLock, __ATOMIC_RELEASE)
+#else
+#define POOL_LOCK()
+#define POOL_UNLOCK()
+#endif
+
+/*
+ * Function: arenaInit
+ * -------------------
+ * This function empties the page pool; called from phase1_init().
+ */
+void arenaInit(void) {
+    freePages = NULL;
+    arenaPagesInUse = 0;
+    arenaPagesFree = 0;
+    arenaPagesTotal = 0;
+    arenaAllocs = 0;
+}
+
+/*
+ * Function: pageGet
+ * -----------------
+ * This function takes a page from the pool, refilling the pool from the
+ * kernel heap if it is empty.
+ *
+ * @return struct ArenaPage *: the page, or NULL if the heap is exhausted
+ */
+static struct ArenaPage *pageGet(void) {
+    POOL_LOCK();
+    if (freePages == NULL) {
+        char *chunk = kernelAlloc(ARENA_CHUNK_BYTES);
+        int i;
+
+        if (chunk == NULL) {
+            POOL_UNLOCK();
+            return NULL;
+        }
+        for (i = ARENA_CHUNK_PAGES - 1; i >= 0; i--) {
+            struct ArenaPage *page = (struct ArenaPage *) (chunk + i * ARENA_PAGE_SIZE);
+            page->next = freePages;
+            freePages = page;
+        }
+        arenaPagesFree += ARENA_CHUNK_PAGES;
+        arenaPagesTotal += ARENA_CHUNK_PAGES;
+    }
+
+    struct ArenaPage *page = freePages;
+    freePages = page->next;
+    arenaPagesFree--;
+    arenaPagesInUse++;
+    POOL_UNLOCK();
+    return page;
+}
+
+/*
+ * Function: arenaRelease
+ * ----------------------
+ * This function returns all of a process's arena pages to the pool at once;
+ * called from reapChild().
+ */
+void arenaRelease(struct PCB *proc) {
+    if (proc->arena == NULL) {
+        return;
+    }
+    POOL_LOCK();
+    proc->arena_oldest->next = freePages;
+    freePages = proc->arena;
+    arenaPagesFree += proc->arena_pages;
+    arenaPagesInUse -= proc->arena_pages;
+    POOL_UNLOCK();
+
+    proc->arena = NULL;
+    proc->arena_oldest = NULL;
+    proc->arena_pages = 0;
+}
+
+/*
+ * Function: proc_alloc
+ * --------------------
+ * This function allocates 'size' bytes from the current process's arena.
+ * The memory is aligned to 16 bytes, is not zeroed, and stays valid until
+ * the process has quit and been joined. There is no way to free it sooner.
+ *
+ * @param int size: number of bytes, at most ARENA_MAX_ALLOC
+ *
+ * @return void *NULL: returned if size is not in 1..ARENA_MAX_ALLOC, the
+ *                     caller is a micro-task (which has no process to own
+ *                     the memory), or the pool cannot grow
+ *
+ * @return void *: the memory
+ */
+void *proc_alloc(int size) {
+    checkKernelMode("proc_alloc");
+
+    if (size <= 0 || size > ARENA_MAX_ALLOC || curProcess == NULL || curProcess->pid == 0) {
+        return NULL;
+    }
+    int n = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    struct ArenaPage *page = curProcess->arena;
+
+    if (page == NULL || page->used + n > ARENA_MAX_ALLOC) {
+        page = pageGet();
+        if (page == NULL) {
+            return NULL;
+        }
+        page->used = 0;
+        page->next = curProcess->arena;
+        if (curProcess->arena == NULL) {
+            curProcess->arena_oldest = page;
+        }
+        curProcess->arena = page;
+        curProcess->arena_pages++;
+    }
+
+    void *mem = page->data + page->used;
+    page->used += n;
+    ATOMIC_ADD(arenaAllocs, 1);
+    return mem;
+}
+
+/*
+ * Function: arenaStats
+ * --------------------
+ * This function reports on the arena page pool.
+ *
+ * @param struct ArenaStats *stats: out-pointer filled with the counters
+ *
+ * @return int -1: returned if stats is NULL
+ *
+ * @return int 0: success
+ */
+int arenaStats(struct ArenaStats *stats) {
+    checkKernelMode("arenaStats");
+
+    if (stats == NULL) {
+        return -1;
+    }
+    stats->pagesInUse = arenaPagesInUse;
+    stats->pagesFree = arenaPagesFree;
+    stats->pagesTotal = arenaPagesTotal;
+    stats->allocs = arenaAllocs;
+    return 0;
+}
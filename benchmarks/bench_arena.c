@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Allocation-heavy workers with malloc()/free() and with proc_alloc(). Each
+ * worker builds a linked list of ALLOCS small objects of 16 to 128 bytes,
+ * walks it once, and quits; the malloc worker frees every object first,
+ * while the arena worker leaves its pages for join() to give back. The time
+ * covers spork() to join() for WORKERS workers in turn, so it includes the
+ * release. Run after run, the arena workers reuse the pool's pages.
+ */
+
+#define WORKERS  20
+#define ALLOCS   50000
+
+struct Node {
+    struct Node *next;
+    int value;
+};
+
+int Worker(char *);
+
+int tm_pid = -1;
+volatile long sink;
+
+static long long nsSince(struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000000000LL + (now.tv_nsec - start->tv_nsec);
+}
+
+static long long run(char *mode)
+{
+    struct timespec start;
+    int i, pid, status;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < WORKERS; i++) {
+        pid = spork("Worker", Worker, mode, USLOSS_MIN_STACK, 2);
+        TEMP_switchTo(pid);
+        join(&status);
+    }
+    return nsSince(&start);
+}
+
+int testcase_main()
+{
+    struct ArenaStats stats;
+    long long heap, arena;
+
+    tm_pid = getpid();
+
+    // once each to warm up malloc's heap and the page pool
+    run("malloc");
+    run("arena");
+
+    heap = run("malloc");
+    arena = run("arena");
+    arenaStats(&stats);
+
+    USLOSS_Console("%d workers x %d allocations of 16-128 bytes\n", WORKERS, ALLOCS);
+    USLOSS_Console("%-8s %12s  %16s\n", "mode", "time (ms)", "ns per alloc");
+    USLOSS_Console("%-8s %12.2f  %16.1f\n", "malloc", heap / 1e6, (double) heap / (WORKERS * ALLOCS));
+    USLOSS_Console("%-8s %12.2f  %16.1f\n", "arena", arena / 1e6, (double) arena / (WORKERS * ALLOCS));
+    USLOSS_Console("arena %.1fx faster; pool holds %d pages (%d KB), %d in use\n", (double) heap / arena,
+                   stats.pagesTotal, stats.pagesTotal * ARENA_PAGE_SIZE / 1024, stats.pagesInUse);
+    return 0;
+}
+
+int Worker(char *arg)
+{
+    int useArena = strcmp(arg, "arena") == 0;
+    struct Node *head = NULL, *node, *next;
+    unsigned int seed = 1;
+    long sum = 0;
+    int i;
+
+    for (i = 0; i < ALLOCS; i++) {
+        seed = seed * 1103515245 + 12345;
+        int size = 16 + (seed >> 16) % 113;
+
+        node = useArena ? proc_alloc(size) : malloc(size);
+        node->value = i;
+        node->next = head;
+        head = node;
+    }
+    for (node = head; node != NULL; node = node->next) {
+        sum += node->value;
+    }
+    sink = sum;
+
+    if (!useArena) {
+        for (node = head; node != NULL; node = next) {
+            next = node->next;
+            free(node);
+        }
+    }
+    quit_phase_1a(0, tm_pid);
+}
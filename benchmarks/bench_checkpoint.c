@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Cold start against restoring a checkpoint (host harness only). The warm-up
+ * sporks WORKERS processes that each build a prime sieve on their stack,
+ * ROUNDS times, and then block on a semaphore: a stand-in for a test setup
+ * that takes a while to reach its steady state. The benchmark warms up
+ * once, saves a checkpoint, and then times RUNS fresh runs of the binary
+ * each way, from fork() to exit: booting and warming up, and restoring the
+ * checkpoint. Either way the run exits as soon as it is in the steady state.
+ * Run it with USLOSS_HOST_CHECKPOINT=1.
+ */
+
+#define WORKERS  40
+#define ROUNDS   20
+#define SIEVE    60000
+#define RUNS     10
+#define CKPT_FILE  "bench_checkpoint.ckpt"
+
+int Worker(char *);
+
+int tm_pid = -1;
+int sem;
+volatile long sink;
+
+static long long nsSince(struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000000000LL + (now.tv_nsec - start->tv_nsec);
+}
+
+static void warmUp(void)
+{
+    int i;
+
+    sem = SemCreate(0);
+    for (i = 0; i < WORKERS; i++) {
+        TEMP_switchTo(spork("Worker", Worker, NULL, USLOSS_MIN_STACK, 2));
+    }
+}
+
+// one fresh run of this binary, with 'restore' set or not; its output is dropped
+static long long spawn(int restore)
+{
+    struct timespec start;
+    int status;
+
+    fflush(stdout);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pid_t child = fork();
+    if (child == 0) {
+        int devNull = open("/dev/null", O_WRONLY);
+        dup2(devNull, 1);
+        setenv(restore ? "USLOSS_HOST_RESTORE" : "BENCH_COLD", CKPT_FILE, 1);
+        execl("/proc/self/exe", "bench_checkpoint", (char *) NULL);
+        _exit(127);
+    }
+    waitpid(child, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        USLOSS_Console("ERROR: a %s run failed\n", restore ? "restored" : "cold");
+    }
+    return nsSince(&start);
+}
+
+int testcase_main()
+{
+    struct timespec start;
+    struct stat st;
+    long long warm, save, cold = 0, restored = 0;
+    int i, rc;
+
+    tm_pid = getpid();
+
+    if (getenv("BENCH_COLD") != NULL) {
+        warmUp();
+        return 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    warmUp();
+    warm = nsSince(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    rc = checkpointSave(CKPT_FILE);
+    save = nsSince(&start);
+    if (rc == 1) {
+        // a restored run: the steady state is back, so we are done
+        return 0;
+    }
+    if (rc != 0 || stat(CKPT_FILE, &st) != 0) {
+        USLOSS_Console("checkpointSave() returned %d; set USLOSS_HOST_CHECKPOINT, or checkpoints are not available in this build\n", rc);
+        return 0;
+    }
+
+    for (i = 0; i < RUNS; i++) {
+        cold += spawn(0);
+        restored += spawn(1);
+    }
+    unlink(CKPT_FILE);
+
+    USLOSS_Console("%d workers x %d sieves of %d; warm-up %.2f ms in process, checkpoint saved in %.2f ms\n",
+                   WORKERS, ROUNDS, SIEVE, warm / 1e6, save / 1e6);
+    USLOSS_Console("checkpoint file %ld KB, %ld KB on disk\n", (long) st.st_size / 1024, (long) st.st_blocks / 2);
+    USLOSS_Console("%-10s %14s\n", "start", "ms per run");
+    USLOSS_Console("%-10s %14.2f\n", "cold", cold / 1e6 / RUNS);
+    USLOSS_Console("%-10s %14.2f\n", "restored", restored / 1e6 / RUNS);
+    USLOSS_Console("restoring is %.1fx faster than booting and warming up\n", (double) cold / restored);
+    return 0;
+}
+
+int Worker(char *arg)
+{
+    char sieve[SIEVE];
+    long primes = 0;
+    int r, i, j;
+
+    for (r = 0; r < ROUNDS; r++) {
+        memset(sieve, 1, sizeof(sieve));
+        for (i = 2; i < SIEVE; i++) {
+            if (sieve[i]) {
+                primes++;
+                for (j = 2 * i; j < SIEVE; j += i) {
+                    sieve[j] = 0;
+                }
+            }
+        }
+    }
+    sink = primes;
+    SemP(sem);
+    quit_phase_1a(0, tm_pid);
+}
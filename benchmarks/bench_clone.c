@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Cost of starting workers that all need the parent's 1 MB lookup table.
+ * "eager" gives each worker its own copy at start-up, the way a fork without
+ * copy-on-write would; "clone" lets them share the parent's region through
+ * spork_clone() and only read it. Every worker is left alive until the last
+ * one has started so the memory figure covers all of them at once. The
+ * process table caps the run at WORKERS workers.
+ */
+
+#define WORKERS 46
+#define TABLE   (1 << 20)
+
+int Worker(char *);
+
+int tm_pid = -1;
+int table;
+long checksum;
+
+static long long nsSince(struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000000000LL + (now.tv_nsec - start->tv_nsec);
+}
+
+static void run(char *mode)
+{
+    int pids[WORKERS];
+    int i, status;
+    long long elapsed;
+    struct timespec start;
+    struct MemStats st;
+
+    checksum = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < WORKERS; i++) {
+        pids[i] = spork_clone("Worker", Worker, mode, USLOSS_MIN_STACK, 2);
+        TEMP_switchTo(pids[i]);
+    }
+    elapsed = nsSince(&start);
+    getMemStats(0, &st);
+
+    for (i = 0; i < WORKERS; i++) {
+        TEMP_switchTo(pids[i]);
+    }
+    for (i = 0; i < WORKERS; i++) {
+        join(&status);
+    }
+
+    USLOSS_Console("%-6s %d workers: %9.1f us to start  (%6.2f us/worker), region memory %7.2f MB, checksum %ld\n",
+                   mode, WORKERS, elapsed / 1000.0, elapsed / 1000.0 / WORKERS,
+                   st.regionBytes / 1048576.0, checksum);
+}
+
+int testcase_main()
+{
+    tm_pid = getpid();
+
+    table = regionCreate(TABLE);
+    memset(regionWrite(table), 7, TABLE);
+
+    run("eager");
+    run("clone");
+
+    return 0;
+}
+
+int Worker(char *mode)
+{
+    char *p = mode[0] == 'e' ? regionWrite(table) : regionGet(table);
+
+    checksum += p[getpid() % TABLE];
+    TEMP_switchTo(tm_pid);
+    quit_phase_1a(0, tm_pid);
+}
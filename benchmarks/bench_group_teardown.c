@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Fleet teardown: spork a group of workers, stop them all with kill_group(),
+ * and time reaping them with one join_group() call against one join() per
+ * child.  The fleet is bounded by MAXPROC, so each size is repeated ROUNDS
+ * times and the cost is reported per process.
+ */
+
+#define ROUNDS 2000
+
+int Worker(char *);
+
+int tm_pid = -1;
+int gate;
+int pids[MAXPROC];
+int done[MAXPROC];
+
+/* sporks a fleet into gid, lets every worker block on the gate, then kills
+ * the group, which wakes them, and lets each of them quit */
+static void buildAndStop(int gid, int size)
+{
+    int i;
+
+    set_group(tm_pid, gid);
+    for (i = 0; i < size; i++) {
+        done[i] = 0;
+        pids[i] = spork("Worker", Worker, (char *) (long) i, USLOSS_MIN_STACK, 2);
+    }
+    set_group(tm_pid, 0);
+
+    TEMP_switchTo(pids[0]);
+    kill_group(gid);
+
+    // the best woken worker has already run; switch to the rest
+    for (i = 0; i < size; i++) {
+        if (!done[i]) {
+            TEMP_switchTo(pids[i]);
+        }
+    }
+}
+
+int testcase_main()
+{
+    int sizes[] = { 10, 20, 40 };
+    int s, r, i, status, gid, start;
+    long long joinTime, groupTime;
+
+    tm_pid = getpid();
+    gate = SemCreate(0);
+    gid = create_group();
+
+    for (s = 0; s < 3; s++) {
+        joinTime = 0;
+        groupTime = 0;
+        for (r = 0; r < ROUNDS; r++) {
+            buildAndStop(gid, sizes[s]);
+            start = currentTime();
+            for (i = 0; i < sizes[s]; i++) {
+                join(&status);
+            }
+            joinTime += currentTime() - start;
+
+            buildAndStop(gid, sizes[s]);
+            start = currentTime();
+            join_group(gid);
+            groupTime += currentTime() - start;
+        }
+        USLOSS_Console("fleet %3d: join() loop %7.1f ns/process   join_group() %7.1f ns/process\n",
+                       sizes[s], joinTime * 1000.0 / ((long long) ROUNDS * sizes[s]),
+                       groupTime * 1000.0 / ((long long) ROUNDS * sizes[s]));
+    }
+
+    return 0;
+}
+
+int Worker(char *arg)
+{
+    int me = (int) (long) arg;
+
+    if (SemP(gate) != -4 || !isKilled()) {
+        USLOSS_Console("ERROR: worker %d was not killed\n", getpid());
+    }
+    done[me] = 1;
+    quit_phase_1a(0, tm_pid);
+}
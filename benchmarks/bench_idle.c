@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <sys/resource.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Host CPU used by a mostly-blocked workload: a few workers that each sleep
+ * for a tick, do a little work and sleep again. It is run once with the idle
+ * process polling the tick count (IDLE_SPIN, what a kernel without an idle
+ * wait does) and once with it in USLOSS_WaitInt() (IDLE_WAIT). Needs the
+ * clock, so run it without USLOSS_HOST_NOCLOCK.
+ */
+
+#define WORKERS 4
+#define TICKS   25
+
+int Worker(char *);
+
+int tm_pid = -1;
+int done;
+volatile long sink;
+
+static double cpuSeconds(void)
+{
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec +
+           (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+static void run(char *label, int mode)
+{
+    int i, status, idle0, idle1, start, elapsed;
+    double cpu;
+
+    setIdleMode(mode);
+    idleStats(&idle0, NULL);
+    start = currentTime();
+    cpu = cpuSeconds();
+
+    for (i = 0; i < WORKERS; i++) {
+        spork("Worker", Worker, NULL, USLOSS_MIN_STACK, 2);
+    }
+    clockSleep(TICKS + 1);
+
+    cpu = cpuSeconds() - cpu;
+    elapsed = currentTime() - start;
+    idleStats(&idle1, NULL);
+
+    for (i = 0; i < WORKERS; i++) {
+        SemV(done);
+        join(&status);
+    }
+
+    USLOSS_Console("%-10s %6.1f ms wall, %6.1f ms host CPU (%5.1f%%), simulated CPU busy %5.1f%%\n",
+                   label, elapsed / 1000.0, cpu * 1000, 100 * cpu * 1e6 / elapsed,
+                   100 - 100.0 * (idle1 - idle0) / elapsed);
+}
+
+int testcase_main()
+{
+    tm_pid = getpid();
+    done = SemCreate(0);
+
+    run("IDLE_SPIN", IDLE_SPIN);
+    run("IDLE_WAIT", IDLE_WAIT);
+
+    return 0;
+}
+
+int Worker(char *arg)
+{
+    int i, j;
+
+    for (i = 0; i < TICKS; i++) {
+        clockSleep(1);
+        for (j = 0; j < 10000; j++) {
+            sink += j;
+        }
+    }
+
+    SemP(done);
+    quit_phase_1a(0, tm_pid);
+}
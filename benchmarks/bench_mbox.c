@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Mailbox throughput for 1:1, N:1 and 1:N producer/consumer patterns, both
+ * for small messages copied into slots and for large buffers passed through
+ * a zero-copy mailbox.  All workers share one priority, so the ring fills and
+ * drains and blocked processes are woken directly by their peers.
+ */
+
+#define MESSAGES 240000
+#define FANOUT   8
+#define SLOTS    10
+#define MSGSIZE  16
+#define BUFSIZE  (64 * 1024)
+
+int Producer(char *), Consumer(char *);
+
+int tm_pid = -1;
+int mbox, done;
+int zeroCopy;
+int perProducer, perConsumer;
+char bigBuf[BUFSIZE];
+
+static void run(char *label, int producers, int consumers, int zc)
+{
+    int status, i, first, start, elapsed;
+
+    zeroCopy = zc;
+    perProducer = MESSAGES / producers;
+    perConsumer = MESSAGES / consumers;
+    mbox = MboxCreate(SLOTS, zc ? MBOX_ZEROCOPY : MSGSIZE);
+    done = SemCreate(0);
+
+    first = spork("Producer", Producer, NULL, USLOSS_MIN_STACK, 2);
+    for (i = 1; i < producers; i++) {
+        spork("Producer", Producer, NULL, USLOSS_MIN_STACK, 2);
+    }
+    for (i = 0; i < consumers; i++) {
+        spork("Consumer", Consumer, NULL, USLOSS_MIN_STACK, 2);
+    }
+
+    start = currentTime();
+    TEMP_switchTo(first);
+    for (i = 0; i < producers + consumers; i++) {
+        SemP(done);
+    }
+    elapsed = currentTime() - start;
+
+    for (i = 0; i < producers + consumers; i++) {
+        join(&status);
+    }
+    MboxRelease(mbox);
+    SemFree(done);
+
+    USLOSS_Console("%-10s %-4s %8d messages in %8d us  %10.0f messages/s\n",
+                   zc ? "zero-copy" : "copy", label, MESSAGES, elapsed,
+                   elapsed ? MESSAGES * 1e6 / elapsed : 0.0);
+}
+
+int testcase_main()
+{
+    int zc;
+
+    tm_pid = getpid();
+
+    for (zc = 0; zc < 2; zc++) {
+        run("1:1", 1, 1, zc);
+        run("N:1", FANOUT, 1, zc);
+        run("1:N", 1, FANOUT, zc);
+    }
+
+    return 0;
+}
+
+int Producer(char *arg)
+{
+    char msg[MSGSIZE] = "message";
+    int i;
+
+    for (i = 0; i < perProducer; i++) {
+        if (zeroCopy) {
+            MboxSendBuf(mbox, bigBuf, BUFSIZE);
+        }
+        else {
+            MboxSend(mbox, msg, MSGSIZE);
+        }
+    }
+    SemV(done);
+    quit_phase_1a(0, tm_pid);
+}
+
+int Consumer(char *arg)
+{
+    char msg[MSGSIZE];
+    void *buf;
+    int i;
+
+    for (i = 0; i < perConsumer; i++) {
+        if (zeroCopy) {
+            MboxRecvBuf(mbox, &buf);
+        }
+        else {
+            MboxRecv(mbox, msg, MSGSIZE);
+        }
+    }
+    SemV(done);
+    quit_phase_1a(0, tm_pid);
+}
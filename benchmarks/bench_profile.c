@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Profiler demo and overhead check: two processes spin for a fixed amount of
+ * work, one three times longer than the other, under the sampling profiler.
+ * The folded output should split roughly 3:1 between them. On the host
+ * harness, set USLOSS_HOST_CLOCK_US (e.g. 100) for more samples; the lines
+ * can be fed to flamegraph.pl after "grep -v '^[A-Z#]'".
+ */
+
+#define SPINS  200000000L
+
+int Spinner(char *);
+
+int tm_pid = -1;
+
+int testcase_main()
+{
+    int status, pid1, pid2, recorded, dropped, overhead, elapsed;
+
+    tm_pid = getpid();
+
+    profileStart(100000);
+
+    pid1 = spork("hot", Spinner, "3", USLOSS_MIN_STACK, 2);
+    pid2 = spork("cold", Spinner, "1", USLOSS_MIN_STACK, 2);
+    TEMP_switchTo(pid1);
+    TEMP_switchTo(pid2);
+    join(&status);
+    join(&status);
+
+    profileStop();
+    dumpProfile();
+
+    profileStats(&recorded, &dropped, &overhead, &elapsed);
+    USLOSS_Console("# %d samples, %d dropped, %d us in the profiler over %d us (%.4f%%)\n",
+                   recorded, dropped, overhead, elapsed,
+                   elapsed ? overhead * 100.0 / elapsed : 0.0);
+    return 0;
+}
+
+int Spinner(char *arg)
+{
+    volatile long i;
+    long n = SPINS * (arg[0] - '0');
+
+    for (i = 0; i < n; i++) {
+    }
+    quit_phase_1a(0, tm_pid);
+}
@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Group CPU quotas against a runaway spork tree: three CPU-bound Hogs in
+ * one group and a single Worker outside it spin under POLICY_STRIDE with
+ * equal tickets, so left alone the Hogs get three quarters of the CPU.
+ * The run is repeated with the Hogs' group limited to QUOTA microseconds in
+ * every PERIOD, and the shares of work done (loop iterations) are compared
+ * with the quota. Needs the clock, so run it without USLOSS_HOST_NOCLOCK;
+ * USLOSS_HOST_CLOCK_US=1000 makes it quicker and the limit tighter.
+ */
+
+#define HOGS     3
+#define TICKS    200
+#define QUOTA    5000
+#define PERIOD   20000
+
+int Spinner(char *);
+
+int tm_pid = -1;
+volatile long work[HOGS + 1];
+volatile int stop;
+
+static void run(int quota)
+{
+    struct WaitTarget any = { WAIT_CHILD, -1 };
+    struct QuotaStats stats;
+    long hogWork = 0;
+    int gid, pid, status, i;
+
+    for (i = 0; i <= HOGS; i++) {
+        work[i] = 0;
+    }
+    stop = 0;
+
+    gid = create_group();
+    set_group_quota(gid, quota, PERIOD);
+    for (i = 0; i <= HOGS; i++) {
+        pid = spork(i < HOGS ? "Hog" : "Worker", Spinner, (char *) (long) i, USLOSS_MIN_STACK, 3);
+        if (i < HOGS) {
+            set_group(pid, gid);
+        }
+    }
+
+    clockSleep(TICKS);
+    for (i = 0; i < HOGS; i++) {
+        hogWork += work[i];
+    }
+    groupQuotaStats(gid, &stats);
+    USLOSS_Console("%-9s %12.2f%%  %12.2f%%  %9d  %14.1f\n", quota > 0 ? "25%" : "none",
+                   100.0 * hogWork / (hogWork + work[HOGS]), 100.0 * work[HOGS] / (hogWork + work[HOGS]),
+                   stats.throttles, stats.throttledTime / 1000.0);
+
+    stop = 1;
+    for (i = 0; i <= HOGS; i++) {
+        wait_any(&any, 1);
+        join(&status);
+    }
+    free_group(gid);
+}
+
+int testcase_main()
+{
+    tm_pid = getpid();
+    setSchedPolicy(POLICY_STRIDE);
+
+    USLOSS_Console("%d Hogs in one group and one Worker, equal tickets, %d ticks\n", HOGS, TICKS);
+    USLOSS_Console("%-9s %13s  %13s  %9s  %14s\n", "quota", "Hogs' share", "Worker's", "throttles",
+                   "throttled (ms)");
+    run(0);
+    run(QUOTA);
+    return 0;
+}
+
+int Spinner(char *arg)
+{
+    int me = (int) (long) arg;
+    long i;
+
+    while (!stop) {
+        for (i = 0; i < 1000; i++) {
+            work[me]++;
+        }
+
+        // a kernel call is where a clock tick's reschedule, or the group
+        // being throttled, takes effect
+        isKilled();
+    }
+    quit_phase_1a(0, tm_pid);
+}
@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <time.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Cost of handing orphans to init when their parent quits, for a wide tree
+ * (one daemon with many direct children) and a deep one (a daemon at the top
+ * of a long chain).  currentTime() is too coarse for a single quit, so this
+ * uses the host's monotonic clock and subtracts the cost of a quit with no
+ * children.  The orphans stay in the process table, so each shape is
+ * measured once per run.
+ */
+
+#define WIDTH 20
+#define DEPTH 20
+
+int Daemon(char *), Idle(char *), Link(char *);
+
+int tm_pid = -1;
+int daemon_pid = -1;
+struct timespec quitStart;
+
+static long long nsSince(struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000000000LL + (now.tv_nsec - start->tv_nsec);
+}
+
+/* runs one daemon of the given shape and returns how long its quit took */
+static long long measure(char *shape)
+{
+    int status;
+    long long elapsed;
+
+    daemon_pid = spork("Daemon", Daemon, shape, USLOSS_MIN_STACK, 2);
+    TEMP_switchTo(daemon_pid);
+    elapsed = nsSince(&quitStart);
+    join(&status);
+    return elapsed;
+}
+
+int testcase_main()
+{
+    long long base, wide, deep;
+
+    tm_pid = getpid();
+    set_orphan_policy(ORPHANS_REPARENT);
+
+    base = measure("none");
+    wide = measure("wide");
+    deep = measure("deep");
+
+    USLOSS_Console("quit with no children:        %6lld ns\n", base);
+    USLOSS_Console("quit with %d direct children: %6lld ns  (%lld ns reparenting, %.1f ns/child)\n",
+                   WIDTH, wide, wide - base, (wide - base) / (double) WIDTH);
+    USLOSS_Console("quit atop a chain %d deep:    %6lld ns  (%lld ns reparenting)\n",
+                   DEPTH, deep, deep - base);
+
+    return 0;
+}
+
+int Daemon(char *shape)
+{
+    int i;
+
+    if (shape[0] == 'w') {
+        for (i = 0; i < WIDTH; i++) {
+            spork("Idle", Idle, NULL, USLOSS_MIN_STACK, 5);
+        }
+    }
+    else if (shape[0] == 'd') {
+        TEMP_switchTo(spork("Link", Link, (char *) (long) (DEPTH - 1), USLOSS_MIN_STACK, 1));
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &quitStart);
+    quit_phase_1a(0, tm_pid);
+}
+
+int Idle(char *arg)
+{
+    quit_phase_1a(0, tm_pid);
+}
+
+int Link(char *arg)
+{
+    int below = (int) (long) arg;
+
+    if (below > 0) {
+        TEMP_switchTo(spork("Link", Link, (char *) (long) (below - 1), USLOSS_MIN_STACK, 1));
+    }
+    TEMP_switchTo(daemon_pid);
+    quit_phase_1a(0, tm_pid);
+}
@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Mutex convoy: WORKERS processes take turns on one mutex, and every holder
+ * blocks inside its critical section until testcase_main() ticks it along.
+ * Because MutexUnlock() hands ownership straight to the next waiter, the
+ * releaser always has to queue up again behind everyone else, so every
+ * acquisition after the first one waits.
+ */
+
+#define WORKERS 20
+#define ROUNDS  5000
+
+int Worker(char *);
+
+int tm_pid = -1;
+int mutex, tick, done;
+
+int testcase_main()
+{
+    int status, i, start, elapsed, first = -1;
+    struct SyncStats stats;
+
+    tm_pid = getpid();
+
+    mutex = MutexCreate();
+    tick = SemCreate(0);
+    done = SemCreate(0);
+
+    for (i = 0; i < WORKERS; i++) {
+        int pid = spork("Worker", Worker, NULL, USLOSS_MIN_STACK, 2);
+        if (first < 0) {
+            first = pid;
+        }
+    }
+
+    start = currentTime();
+    TEMP_switchTo(first);
+    for (i = 0; i < WORKERS * ROUNDS; i++) {
+        SemV(tick);
+    }
+    for (i = 0; i < WORKERS; i++) {
+        SemP(done);
+    }
+    elapsed = currentTime() - start;
+
+    for (i = 0; i < WORKERS; i++) {
+        join(&status);
+    }
+
+    SemStats(mutex, &stats);
+    USLOSS_Console("convoy: %d workers x %d rounds in %d us  %.0f acquisitions/s\n",
+                   WORKERS, ROUNDS, elapsed, elapsed ? stats.acquisitions * 1e6 / elapsed : 0.0);
+    USLOSS_Console("convoy: acquisitions %d waits %d avg wait %d us max wait %d us\n",
+                   stats.acquisitions, stats.waits, stats.avgWait, stats.maxWait);
+
+    return 0;
+}
+
+int Worker(char *arg)
+{
+    int i;
+
+    for (i = 0; i < ROUNDS; i++) {
+        MutexLock(mutex);
+        SemP(tick);
+        MutexUnlock(mutex);
+    }
+    SemV(done);
+    quit_phase_1a(0, tm_pid);
+}
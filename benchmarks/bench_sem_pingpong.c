@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Semaphore ping-pong: two processes bounce a token back and forth through a
+ * pair of semaphores.  The first run has both at the same priority, so every
+ * hop goes through the ready queue; the second gives the ponger a higher
+ * priority, so every SemV() hands off and switches directly.
+ */
+
+#define ROUNDS 100000
+
+int Pinger(char *), Ponger(char *);
+
+int tm_pid = -1;
+int ping, pong, done;
+
+static void run(char *label, int pongPriority)
+{
+    int status, i, pid1, start, elapsed;
+    struct SyncStats stats;
+
+    ping = SemCreate(0);
+    pong = SemCreate(0);
+    done = SemCreate(0);
+
+    pid1 = spork("Pinger", Pinger, NULL, USLOSS_MIN_STACK, 2);
+    spork("Ponger", Ponger, NULL, USLOSS_MIN_STACK, pongPriority);
+
+    start = currentTime();
+    TEMP_switchTo(pid1);
+    SemP(done);
+    SemP(done);
+    elapsed = currentTime() - start;
+
+    for (i = 0; i < 2; i++) {
+        join(&status);
+    }
+
+    SemStats(ping, &stats);
+    USLOSS_Console("%-22s %8d round trips in %8d us  %10.0f round trips/s  waits %d avg %d us max %d us\n",
+                   label, ROUNDS, elapsed, elapsed ? ROUNDS * 1e6 / elapsed : 0.0,
+                   stats.waits, stats.avgWait, stats.maxWait);
+
+    SemFree(ping);
+    SemFree(pong);
+    SemFree(done);
+}
+
+int testcase_main()
+{
+    tm_pid = getpid();
+
+    run("same priority", 2);
+    run("direct handoff", 1);
+
+    return 0;
+}
+
+int Pinger(char *arg)
+{
+    int i;
+
+    for (i = 0; i < ROUNDS; i++) {
+        SemV(ping);
+        SemP(pong);
+    }
+    SemV(done);
+    quit_phase_1a(0, tm_pid);
+}
+
+int Ponger(char *arg)
+{
+    int i;
+
+    for (i = 0; i < ROUNDS; i++) {
+        SemP(ping);
+        SemV(pong);
+    }
+    SemV(done);
+    quit_phase_1a(0, tm_pid);
+}
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Multi-core scaling of spork/compute/quit. WORKERS processes each spork
+ * and join ROUNDS children in turn; a child does WORK iterations of
+ * arithmetic and quits. The batch runs under smpRun() with 1, 2, 4, ...
+ * CPUs up to the host's core count, and prints the throughput (children
+ * per second) and the speedup over one CPU. Needs "make host-bench SMP=1";
+ * other builds only say that smpRun() is not available.
+ */
+
+#define WORKERS  16
+#define ROUNDS   50
+#define WORK     200000
+
+int Worker(char *), Child(char *);
+
+int tm_pid = -1;
+volatile long sink;
+
+static int runBatch(int cores, struct SmpStats *stats)
+{
+    int i, status, start;
+
+    for (i = 0; i < WORKERS; i++) {
+        spork("Worker", Worker, NULL, USLOSS_MIN_STACK, 3);
+    }
+    start = currentTime();
+    if (smpRun(cores, stats) < 0) {
+        return -1;
+    }
+    int elapsed = currentTime() - start;
+
+    for (i = 0; i < WORKERS; i++) {
+        join(&status);
+    }
+    return elapsed;
+}
+
+int testcase_main()
+{
+    struct SmpStats stats;
+    int hostCores = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    int maxCores = hostCores > 2 ? hostCores : 2;
+    int cores, elapsed, base = 0;
+
+    tm_pid = getpid();
+
+    if (runBatch(1, &stats) < 0) {
+        USLOSS_Console("smpRun() is not available; build with \"make host-bench SMP=1\"\n");
+        return 0;
+    }
+
+    USLOSS_Console("%d workers x %d children, %d iterations each, %d host cores\n",
+                   WORKERS, ROUNDS, WORK, hostCores);
+    USLOSS_Console("%5s  %10s  %12s  %8s  %7s  %7s\n", "cpus", "time (us)", "children/s", "speedup", "steals", "yields");
+    for (cores = 1; ; cores *= 2) {
+        if (cores > maxCores) {
+            cores = maxCores;
+        }
+        elapsed = runBatch(cores, &stats);
+        if (cores == 1) {
+            base = elapsed;
+        }
+        USLOSS_Console("%5d  %10d  %12.0f  %7.2fx  %7d  %7d%s\n", cores, elapsed,
+                       WORKERS * ROUNDS * 1e6 / elapsed, (double) base / elapsed,
+                       stats.steals, stats.yields, cores > hostCores ? "  (more CPUs than host cores)" : "");
+        if (cores == maxCores) {
+            break;
+        }
+    }
+    return 0;
+}
+
+int Worker(char *arg)
+{
+    int i, status;
+
+    for (i = 0; i < ROUNDS; i++) {
+        spork("Child", Child, NULL, USLOSS_MIN_STACK, 2);
+        join(&status);
+    }
+    quit_phase_1a(0, tm_pid);
+}
+
+int Child(char *arg)
+{
+    long i, x = 0;
+
+    for (i = 0; i < WORK; i++) {
+        x = x * 31 + i;
+    }
+    sink = x;
+    quit_phase_1a(0, tm_pid);
+}
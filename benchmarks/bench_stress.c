@@ -0,0 +1,294 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Randomized stress driver for spork/join/quit/switch/dumpProcesses. Every
+ * process runs the same loop: pick a random operation, check its result
+ * against a model of the process tree, then run checkProcessTable() and
+ * compare the kernel's per-state process counts with the model. After
+ * the requested number of operations the tree is torn down bottom-up.
+ *
+ * Environment:
+ *   STRESS_SEED   PRNG seed (default 1); the same seed gives the same run
+ *   STRESS_OPS    number of operations (default 1000000)
+ *   STRESS_INPUT  file whose bytes replace the PRNG, for file-based fuzzers
+ *                 such as AFL; the run drains once the bytes run out
+ *
+ * On a failure it prints the seed and operation number and halts with 1.
+ */
+
+#define MAX_LIVE (MAXPROC - 4) // leave room for init, testcase_main and slack
+
+struct Node {
+    int pid; // 0 if the slot is free
+    int parent;
+    int exited;
+    int status;
+    int kids; // children not yet joined, live or zombie
+};
+
+int Node(char *);
+
+int tm_pid = -1;
+struct Node model[MAXPROC];
+int numNodes;
+int numZombies;
+
+unsigned long long rngState;
+unsigned char *input;
+long inputLen, inputPos;
+
+long ops, targetOps;
+long counts[5]; // spork, join, switch, quit, dump
+int draining;
+unsigned long long seed;
+
+static char *opNames[5] = { "spork", "join", "switch", "quit", "dump" };
+
+/*
+ * Function: rnd
+ * -------------
+ * Returns a random number below n from xorshift64*, or from the input file.
+ */
+static unsigned int rnd(unsigned int n)
+{
+    if (input != NULL) {
+        if (inputPos + 2 > inputLen) {
+            draining = 1;
+            return 0;
+        }
+        unsigned int v = input[inputPos] | (input[inputPos + 1] << 8);
+        inputPos += 2;
+        return v % n;
+    }
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return (unsigned int) ((rngState * 2685821657736338717ULL) >> 32) % n;
+}
+
+static void fail(char *what, int got)
+{
+    USLOSS_Console("STRESS FAILURE: %s (got %d) at op %ld, seed %llu\n", what, got, ops, seed);
+    USLOSS_Halt(1);
+}
+
+static void check(void)
+{
+    if (checkProcessTable() != 0) {
+        fail("checkProcessTable()", -1);
+    }
+
+    if (processCount(PROC_ZOMBIE) != numZombies) {
+        fail("zombie count does not match the model", processCount(PROC_ZOMBIE));
+    }
+
+    // ready: the live nodes (testcase_main included) less the caller, which
+    // is running, plus init, which is always ready
+    if (processCount(PROC_RUNNING) != 1 || processCount(PROC_BLOCKED) != 0 ||
+        processCount(PROC_READY) != numNodes - numZombies) {
+        fail("ready count does not match the model", processCount(PROC_READY));
+    }
+}
+
+/*
+ * Function: pickLive
+ * ------------------
+ * Returns a random live process other than 'me' and init, optionally only
+ * among me's children, or -1 if there is none.
+ */
+static int pickLive(int me, int kidsOnly)
+{
+    int cand[MAXPROC], n = 0, i;
+
+    for (i = 0; i < MAXPROC; i++) {
+        struct Node *m = &model[i];
+        if (m->pid != 0 && !m->exited && m->pid != me && m->pid != 1 &&
+            (!kidsOnly || m->parent == me)) {
+            cand[n++] = m->pid;
+        }
+    }
+    return n == 0 ? -1 : cand[kidsOnly ? 0 : rnd(n)];
+}
+
+static void doSpork(int me)
+{
+    int priority = 1 + rnd(5);
+    int stack = USLOSS_MIN_STACK * (1 + rnd(3));
+    int pid = spork("Node", Node, NULL, stack, priority);
+
+    if (pid <= 0) {
+        fail("spork() with room in the table", pid);
+    }
+    struct Node *m = &model[pid % MAXPROC];
+    if (m->pid != 0) {
+        fail("spork() reused an occupied slot", pid);
+    }
+    m->pid = pid;
+    m->parent = me;
+    m->exited = 0;
+    m->kids = 0;
+    model[me % MAXPROC].kids++;
+    numNodes++;
+    counts[0]++;
+}
+
+static void doJoin(int me)
+{
+    int status, i, zombies = 0;
+
+    for (i = 0; i < MAXPROC; i++) {
+        zombies += model[i].pid != 0 && model[i].parent == me && model[i].exited;
+    }
+
+    int pid = join(&status);
+    if (zombies == 0) {
+        if (pid != -2) {
+            fail("join() with no dead children", pid);
+        }
+    }
+    else {
+        struct Node *m = &model[(pid > 0 ? pid : 0) % MAXPROC];
+        if (pid <= 0 || m->pid != pid || m->parent != me || !m->exited || m->status != status) {
+            fail("join() returned the wrong child or status", pid);
+        }
+        m->pid = 0;
+        model[me % MAXPROC].kids--;
+        numNodes--;
+        numZombies--;
+    }
+    counts[1]++;
+}
+
+static void doSwitch(int target)
+{
+    counts[2]++;
+    TEMP_switchTo(target);
+}
+
+static void doQuit(int me, int target)
+{
+    struct Node *m = &model[me % MAXPROC];
+
+    m->exited = 1;
+    m->status = rnd(1000);
+    counts[3]++;
+    check();
+    numZombies++;
+    quit_phase_1a(m->status, target);
+}
+
+/*
+ * Function: step
+ * --------------
+ * Runs one operation as process 'me'. Returns 0 once testcase_main has
+ * nothing left to tear down.
+ */
+static int step(int me)
+{
+    struct Node *self = &model[me % MAXPROC];
+    int target;
+
+    ops++;
+    if (ops >= targetOps) {
+        draining = 1;
+    }
+
+    if (draining) {
+        if (self->kids == 0) {
+            if (me == tm_pid) {
+                return 0;
+            }
+            doQuit(me, self->parent);
+        }
+        int i;
+        for (i = 0; i < MAXPROC; i++) {
+            if (model[i].pid != 0 && model[i].parent == me && model[i].exited) {
+                doJoin(me);
+                return 1;
+            }
+        }
+        doSwitch(pickLive(me, 1));
+        return 1;
+    }
+
+    unsigned int r = rnd(100);
+    if (r < 30) {
+        if (numNodes < MAX_LIVE) {
+            doSpork(me);
+        }
+    }
+    else if (r < 55) {
+        doJoin(me);
+    }
+    else if (r < 85) {
+        if ((target = pickLive(me, 0)) > 0) {
+            doSwitch(target);
+        }
+    }
+    else if (r < 99) {
+        if (me != tm_pid && self->kids == 0 && (target = pickLive(me, 0)) > 0) {
+            doQuit(me, target);
+        }
+    }
+    else if (rnd(1000) == 0) {
+        counts[4]++;
+        dumpProcesses();
+    }
+    check();
+    return 1;
+}
+
+static void loadInput(char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        USLOSS_Console("stress: cannot open %s\n", path);
+        USLOSS_Halt(1);
+    }
+    fseek(f, 0, SEEK_END);
+    inputLen = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    input = malloc(inputLen + 1);
+    inputLen = fread(input, 1, inputLen, f);
+    fclose(f);
+}
+
+int testcase_main()
+{
+    int start, elapsed, i;
+    char *env;
+
+    tm_pid = getpid();
+    seed = (env = getenv("STRESS_SEED")) ? strtoull(env, NULL, 0) : 1;
+    targetOps = (env = getenv("STRESS_OPS")) ? atol(env) : 1000000;
+    if ((env = getenv("STRESS_INPUT")) != NULL) {
+        loadInput(env);
+    }
+    rngState = seed ? seed : 1;
+
+    model[tm_pid % MAXPROC].pid = tm_pid;
+    model[tm_pid % MAXPROC].parent = 1;
+    numNodes = 1;
+
+    start = currentTime();
+    while (step(tm_pid)) {
+    }
+    elapsed = currentTime() - start;
+
+    USLOSS_Console("stress: seed %llu, %ld ops in %d us, %.0f ops/s\n", seed, ops, elapsed,
+                   elapsed ? ops * 1e6 / elapsed : 0.0);
+    for (i = 0; i < 5; i++) {
+        USLOSS_Console("stress:   %-6s %10ld\n", opNames[i], counts[i]);
+    }
+    return 0;
+}
+
+int Node(char *arg)
+{
+    while (1) {
+        step(getpid());
+    }
+}
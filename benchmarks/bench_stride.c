@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Stride scheduling convergence: three CPU-bound workers with 70, 20 and 10
+ * tickets spin under POLICY_STRIDE while testcase_main sleeps on the clock.
+ * Work done (loop iterations) stands in for CPU received. After each
+ * checkpoint the achieved shares are compared with the ticket shares; the
+ * run passes if the worst error after TICKS ticks is below MAX_ERROR
+ * percentage points. Needs the clock, so run it without
+ * USLOSS_HOST_NOCLOCK; USLOSS_HOST_CLOCK_US=1000 makes it quicker.
+ */
+
+#define WORKERS    3
+#define TICKS      400
+#define MAX_ERROR  2.0
+
+int Worker(char *);
+
+int tm_pid = -1;
+int tickets[WORKERS] = { 70, 20, 10 };
+volatile long work[WORKERS];
+volatile int stop;
+
+int testcase_main()
+{
+    int checkpoints[] = { 10, 25, 50, 100, 200, TICKS };
+    int i, c, slept = 0, status, pid;
+    double worst = 0;
+
+    tm_pid = getpid();
+    setSchedPolicy(POLICY_STRIDE);
+
+    for (i = 0; i < WORKERS; i++) {
+        pid = spork("Worker", Worker, (char *) (long) i, USLOSS_MIN_STACK, 3);
+        setTickets(pid, tickets[i]);
+    }
+
+    USLOSS_Console("%6s  %-24s %s\n", "ticks", "shares (target 70/20/10)", "worst error");
+    for (c = 0; c < sizeof(checkpoints) / sizeof(checkpoints[0]); c++) {
+        long total = 0;
+
+        clockSleep(checkpoints[c] - slept);
+        slept = checkpoints[c];
+
+        for (i = 0; i < WORKERS; i++) {
+            total += work[i];
+        }
+        worst = 0;
+        USLOSS_Console("%6d  ", slept);
+        for (i = 0; i < WORKERS; i++) {
+            double share = 100.0 * work[i] / total;
+            double err = share > tickets[i] ? share - tickets[i] : tickets[i] - share;
+
+            worst = err > worst ? err : worst;
+            USLOSS_Console("%6.2f%%  ", share);
+        }
+        USLOSS_Console("%6.2f\n", worst);
+    }
+    USLOSS_Console("after %d ticks the worst error is %.2f points: %s\n", TICKS, worst,
+                   worst < MAX_ERROR ? "converged" : "NOT converged");
+
+    stop = 1;
+    for (i = 0; i < WORKERS; i++) {
+        join(&status);
+    }
+    return 0;
+}
+
+int Worker(char *arg)
+{
+    int me = (int) (long) arg;
+    long i;
+
+    while (!stop) {
+        for (i = 0; i < 1000; i++) {
+            work[me]++;
+        }
+
+        // a kernel call is where a clock tick's reschedule takes effect
+        isKilled();
+    }
+    quit_phase_1a(0, tm_pid);
+}
@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Context switch ping-pong: two processes switch to each other with
+ * TEMP_switchTo() and nothing else, once with each backend and once with one
+ * process on each side, so every switch goes through the bridge.
+ */
+
+#define ROUNDS 200000
+
+int Ping(char *), Pong(char *);
+
+int tm_pid = -1;
+int ping_pid, pong_pid;
+
+static void run(char *label, int pingBackend, int pongBackend)
+{
+    int status, start, elapsed, switches;
+
+    if (setSwitchBackend(pingBackend) < 0 || setSwitchBackend(SWITCH_USLOSS) < 0 ||
+        setSwitchBackend(pongBackend) < 0) {
+        USLOSS_Console("%-22s not available\n", label);
+        setSwitchBackend(SWITCH_USLOSS);
+        return;
+    }
+
+    setSwitchBackend(pingBackend);
+    ping_pid = spork("Ping", Ping, NULL, USLOSS_MIN_STACK, 2);
+    setSwitchBackend(pongBackend);
+    pong_pid = spork("Pong", Pong, NULL, USLOSS_MIN_STACK, 2);
+    setSwitchBackend(SWITCH_USLOSS);
+
+    start = currentTime();
+    TEMP_switchTo(ping_pid);
+    elapsed = currentTime() - start;
+
+    join(&status);
+    join(&status);
+
+    switches = 2 * ROUNDS;
+    USLOSS_Console("%-22s %8d switches in %8d us  %12.0f switches/s  %6.1f ns/switch\n",
+                   label, switches, elapsed, elapsed ? switches * 1e6 / elapsed : 0.0,
+                   switches ? elapsed * 1e3 / switches : 0.0);
+}
+
+int testcase_main()
+{
+    tm_pid = getpid();
+
+    run("USLOSS", SWITCH_USLOSS, SWITCH_USLOSS);
+    run("native", SWITCH_NATIVE, SWITCH_NATIVE);
+    run("USLOSS <-> native", SWITCH_USLOSS, SWITCH_NATIVE);
+
+    USLOSS_Console("switch counts: USLOSS %d native %d bridged %d\n",
+                   getSwitchCount(SWITCH_USLOSS), getSwitchCount(SWITCH_NATIVE),
+                   getSwitchCount(SWITCH_NATIVE + 1));
+    return 0;
+}
+
+int Ping(char *arg)
+{
+    int i;
+
+    for (i = 0; i < ROUNDS; i++) {
+        TEMP_switchTo(pong_pid);
+    }
+    quit_phase_1a(0, pong_pid);
+}
+
+int Pong(char *arg)
+{
+    int i;
+
+    for (i = 0; i < ROUNDS; i++) {
+        TEMP_switchTo(ping_pid);
+    }
+    quit_phase_1a(0, tm_pid);
+}
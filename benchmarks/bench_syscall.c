@@ -0,0 +1,36 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Cost of entering the kernel through the system call table compared with
+ * calling the kernel function directly, using getpid() as the null call.
+ */
+
+#define CALLS 1000000
+
+int testcase_main()
+{
+    int i, start, direct, trapped, calls, total;
+
+    start = currentTime();
+    for (i = 0; i < CALLS; i++) {
+        getpid();
+    }
+    direct = currentTime() - start;
+
+    start = currentTime();
+    for (i = 0; i < CALLS; i++) {
+        Sys_GetPid();
+    }
+    trapped = currentTime() - start;
+
+    syscallStats(SYS_GETPID, &calls, &total);
+    USLOSS_Console("direct getpid():  %d calls in %8d us  %10.0f calls/s\n",
+                   CALLS, direct, direct ? CALLS * 1e6 / direct : 0.0);
+    USLOSS_Console("Sys_GetPid():     %d calls in %8d us  %10.0f calls/s\n",
+                   CALLS, trapped, trapped ? CALLS * 1e6 / trapped : 0.0);
+    dumpSyscallStats();
+
+    return 0;
+}
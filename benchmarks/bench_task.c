@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <time.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Cost of short-lived work as processes and as micro-tasks. Each round
+ * creates BATCH of them at priority 2, lets them run (a few hundred
+ * iterations of arithmetic each) and joins them all. The processes are run
+ * with TEMP_switchTo() and quit straight back; the tasks run on their
+ * priority's runner once testcase_main blocks in join(). Creation is timed
+ * on its own, then the whole round trip, per item, along with the kernel
+ * memory each one needs while it exists. The process table caps BATCH.
+ */
+
+#define BATCH   40
+#define ROUNDS  250
+#define WORK    200
+
+int Child(char *);
+int Work(void *, int *);
+
+int tm_pid = -1;
+volatile long sink;
+
+static long long nsSince(struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000000000LL + (now.tv_nsec - start->tv_nsec);
+}
+
+static void compute(void)
+{
+    long i, x = 0;
+
+    for (i = 0; i < WORK; i++) {
+        x = x * 31 + i;
+    }
+    sink = x;
+}
+
+static void report(char *mode, long long create, long long total, long bytes)
+{
+    USLOSS_Console("%-9s %10.3f  %14.3f  %14ld\n", mode, create / 1000.0 / (BATCH * ROUNDS),
+                   total / 1000.0 / (BATCH * ROUNDS), bytes);
+}
+
+int testcase_main()
+{
+    struct timespec start, phase;
+    struct MemStats mem;
+    struct TaskStats ts;
+    long long procCreateTime = 0, taskCreateTime = 0, procTotal, taskTotal;
+    int pids[BATCH];
+    int i, round, status;
+    long procBytes = 0;
+
+    tm_pid = getpid();
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (round = 0; round < ROUNDS; round++) {
+        clock_gettime(CLOCK_MONOTONIC, &phase);
+        for (i = 0; i < BATCH; i++) {
+            pids[i] = spork("Child", Child, NULL, USLOSS_MIN_STACK, 2);
+        }
+        procCreateTime += nsSince(&phase);
+        if (round == 0) {
+            getMemStats(tm_pid, &mem);
+            procBytes = mem.stackBytes / BATCH;
+        }
+        for (i = 0; i < BATCH; i++) {
+            TEMP_switchTo(pids[i]);
+        }
+        for (i = 0; i < BATCH; i++) {
+            join(&status);
+        }
+    }
+    procTotal = nsSince(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (round = 0; round < ROUNDS; round++) {
+        clock_gettime(CLOCK_MONOTONIC, &phase);
+        for (i = 0; i < BATCH; i++) {
+            taskCreate(Work, NULL, 2);
+        }
+        taskCreateTime += nsSince(&phase);
+        for (i = 0; i < BATCH; i++) {
+            join(&status);
+        }
+    }
+    taskTotal = nsSince(&start);
+    taskStats(&ts);
+
+    USLOSS_Console("%d rounds of %d, %d iterations of work each\n", ROUNDS, BATCH, WORK);
+    USLOSS_Console("%-9s %10s  %14s  %14s\n", "mode", "create (us)", "round trip (us)", "bytes per item");
+    report("spork", procCreateTime, procTotal, procBytes);
+    report("task", taskCreateTime, taskTotal, ts.taskBytes);
+    USLOSS_Console("creation %.1fx cheaper, round trip %.1fx cheaper; the runner's %d-byte stack is shared by every task at its priority\n",
+                   (double) procCreateTime / taskCreateTime, (double) procTotal / taskTotal, ts.runnerBytes);
+    return 0;
+}
+
+int Child(char *arg)
+{
+    compute();
+    quit_phase_1a(0, tm_pid);
+}
+
+int Work(void *arg, int *step)
+{
+    compute();
+    return 0;
+}
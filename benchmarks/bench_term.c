@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <string.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Terminal output: synchronous (polled) versus the interrupt-driven ring.
+ * The synchronous writer sends each character itself and spins on the
+ * terminal's status until it has gone out, so it is stalled for the whole
+ * transfer and nothing else runs. With termWrite() the writer only waits
+ * while the ring is full, and a CPU-bound process at a lower priority gets
+ * the CPU in between. For a burst that fits in the ring and for a long
+ * stream, the table shows the end-to-end rate, how long the writer was
+ * stalled, and how much of the CPU the other process still got. Needs the
+ * clock, so run it without USLOSS_HOST_NOCLOCK; USLOSS_HOST_TERM_US sets
+ * the time per character (default 100 us).
+ */
+
+#define UNIT    3
+#define BURST   200
+#define STREAM  4096
+
+int Compute(char *);
+
+int tm_pid = -1;
+volatile long work;
+volatile int stop;
+double rate;
+char text[STREAM];
+
+static void report(char *mode, int chars, int elapsed, int stall, long done)
+{
+    USLOSS_Console("%-12s %6d  %9d  %9d  %9.0f  %8.1f%%\n", mode, chars, elapsed, stall,
+                   chars * 1e6 / elapsed, 100.0 * done / (rate * elapsed));
+}
+
+static void polled(int len)
+{
+    int i, status, start = currentTime();
+    long before = work;
+
+    for (i = 0; i < len; i++) {
+        int ctrl = USLOSS_TERM_CTRL_XMIT_CHAR(USLOSS_TERM_CTRL_CHAR(0, text[i]));
+        USLOSS_DeviceOutput(USLOSS_TERM_DEV, UNIT, (void *) (long) ctrl);
+        do {
+            USLOSS_DeviceInput(USLOSS_TERM_DEV, UNIT, &status);
+        } while (USLOSS_TERM_STAT_XMIT(status) == USLOSS_DEV_BUSY);
+    }
+    int elapsed = currentTime() - start;
+    report("polled", len, elapsed, elapsed, work - before);
+}
+
+static void buffered(int len)
+{
+    struct TermStats before, after;
+    int start = currentTime();
+    long workBefore = work;
+
+    termStats(UNIT, &before);
+    termWrite(UNIT, text, len);
+    termFlush(UNIT);
+    termStats(UNIT, &after);
+
+    report("interrupt", len, currentTime() - start, (int) (after.stallTime - before.stallTime),
+           work - workBefore);
+}
+
+int testcase_main()
+{
+    int i, start;
+    long before;
+
+    tm_pid = getpid();
+    for (i = 0; i < STREAM; i++) {
+        text[i] = i % 64 == 63 ? '\n' : 'a' + i % 26;
+    }
+    spork("Compute", Compute, NULL, USLOSS_MIN_STACK, 4);
+
+    // Compute's rate when it has the CPU to itself
+    start = currentTime();
+    before = work;
+    clockSleep(10);
+    rate = (double) (work - before) / (currentTime() - start);
+
+    USLOSS_Console("%-12s %6s  %9s  %9s  %9s  %9s\n", "mode", "chars", "time (us)", "stall (us)",
+                   "chars/s", "CPU left");
+    polled(BURST);
+    buffered(BURST);
+    polled(STREAM);
+    buffered(STREAM);
+
+    // Compute is at a lower priority, so it never runs again
+    stop = 1;
+    return 0;
+}
+
+int Compute(char *arg)
+{
+    long i;
+
+    while (!stop) {
+        for (i = 0; i < 1000; i++) {
+            work++;
+        }
+
+        // a kernel call is where a woken writer gets the CPU back
+        isKilled();
+    }
+    quit_phase_1a(0, tm_pid);
+}
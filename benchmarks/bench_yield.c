@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <time.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Client/server ping-pong at one priority, three ways: a pair of semaphores
+ * (each hop blocks, wakes the peer and goes through the dispatcher), raw
+ * TEMP_switchTo() (no checks and no requeue), and yield_to(). The client and
+ * server are both at priority 2; testcase_main() waits for them with
+ * wait_any().
+ */
+
+#define ROUNDS 200000
+
+int Client(char *), Server(char *);
+
+int tm_pid = -1;
+int clientPid, serverPid;
+int ping, pong;
+char *mode;
+
+static long long nsSince(struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000000000LL + (now.tv_nsec - start->tv_nsec);
+}
+
+static long long run(char *how)
+{
+    struct WaitTarget any = { WAIT_CHILD, -1 };
+    struct timespec start;
+    int status, i;
+
+    mode = how;
+    ping = SemCreate(0);
+    pong = SemCreate(0);
+    serverPid = spork("Server", Server, NULL, USLOSS_MIN_STACK, 2);
+    TEMP_switchTo(serverPid);
+    clientPid = spork("Client", Client, NULL, USLOSS_MIN_STACK, 2);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    TEMP_switchTo(clientPid);
+    for (i = 0; i < 2; i++) {
+        wait_any(&any, 1);
+        join(&status);
+    }
+    SemFree(ping);
+    SemFree(pong);
+    return nsSince(&start);
+}
+
+int testcase_main()
+{
+    char *modes[] = { "semaphores", "TEMP_switchTo", "yield_to" };
+    long long ns[3];
+    int i;
+
+    tm_pid = getpid();
+
+    for (i = 0; i < 3; i++) {
+        run(modes[i]);
+        ns[i] = run(modes[i]);
+    }
+
+    USLOSS_Console("%d round trips between two processes at the same priority\n", ROUNDS);
+    USLOSS_Console("%-14s %12s  %16s\n", "mode", "time (ms)", "ns per round trip");
+    for (i = 0; i < 3; i++) {
+        USLOSS_Console("%-14s %12.2f  %16.1f\n", modes[i], ns[i] / 1e6, (double) ns[i] / ROUNDS);
+    }
+    USLOSS_Console("yield_to %.1fx faster than semaphores\n", (double) ns[0] / ns[2]);
+    return 0;
+}
+
+static void hop(int to, int sendSem, int waitSem)
+{
+    if (mode[0] == 's') {
+        SemV(sendSem);
+        SemP(waitSem);
+    }
+    else if (mode[0] == 'T') {
+        TEMP_switchTo(to);
+    }
+    else {
+        yield_to(to);
+    }
+}
+
+int Client(char *arg)
+{
+    int i;
+
+    for (i = 0; i < ROUNDS; i++) {
+        hop(serverPid, ping, pong);
+    }
+    // let the server finish its last round before quitting
+    hop(serverPid, ping, pong);
+    quit_phase_1a(0, tm_pid);
+}
+
+int Server(char *arg)
+{
+    int i;
+
+    // the first hop only parks the server until the client starts
+    if (mode[0] == 's') {
+        SemP(ping);
+    }
+    else {
+        TEMP_switchTo(tm_pid);
+    }
+    for (i = 0; i < ROUNDS; i++) {
+        hop(clientPid, pong, ping);
+    }
+    if (mode[0] == 's') {
+        SemV(pong);
+    }
+    quit_phase_1a(0, clientPid);
+}
@@ -0,0 +1,291 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include "kernel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+/*
+ * Checkpoints of the whole kernel, for the host harness. The kernel's state
+ * is its globals (the executable's .data and .bss) plus the kernel heap
+ * (kheap.c), which holds every stack and so every suspended process's
+ * frames. A checkpoint file is a header page, an image of the globals and a
+ * page-aligned image of the part of the heap in use. All-zero pages are
+ * left as holes, so the file takes little more disk than the memory that
+ * was actually touched.
+ *
+ * The process that saves is suspended in a context of its own, and a helper
+ * context on a scratch stack writes the file while nothing runs. A restore
+ * maps the heap image straight from the file, so a stack page is read in
+ * only when its process runs again, copies the globals back around the
+ * harness's "hoststate" section, and switches to the saved context, which
+ * returns 1 from checkpointSave().
+ *
+ * A restore only works in the same binary with the same layout; the
+ * harness turns address randomization off for that when
+ * USLOSS_HOST_CHECKPOINT or USLOSS_HOST_RESTORE is set, and the header
+ * records enough addresses to refuse anything else. Code built with the
+ * stack protector also needs the canary to match, which is only done for
+ * x86-64, and AddressSanitizer builds cannot checkpoint at all.
+ */
+
+#define CKPT_MAGIC     "P1CK"
+#define CKPT_VERSION   1
+#define CKPT_PAGE      4096
+#define CKPT_STACK     (64 * 1024)
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+struct CheckpointHeader {
+    char magic[4];
+    int version;
+    unsigned long code; // address of checkpointSave, to check the layout
+    unsigned long dataStart, dataEnd; // globals
+    unsigned long hostStart, hostEnd; // harness state inside them, not restored
+    unsigned long heapBase, heapUsed;
+    unsigned long dataOffset, heapOffset; // in the file
+    unsigned long canary;
+    unsigned long curProc;
+};
+
+// bounds of the globals, from the linker; all NULL outside the host harness
+extern char __data_start[] __attribute__((weak));
+extern char _end[] __attribute__((weak));
+extern char __start_hoststate[] __attribute__((weak));
+extern char __stop_hoststate[] __attribute__((weak));
+
+extern char **environ;
+
+// the saving process, suspended in checkpointSave()
+static USLOSS_Context savedContext;
+static USLOSS_Context writerContext;
+
+// set by a restore just before it switches to savedContext
+static volatile int resumed;
+
+// the file being written and what became of it
+static char *writePath;
+static int writeResult;
+static struct CheckpointHeader header;
+
+#if defined(__SSP__) || defined(__SSP_STRONG__) || defined(__SSP_ALL__) || defined(__SSP_EXPLICIT__)
+#define CKPT_NEED_CANARY  1
+#else
+#define CKPT_NEED_CANARY  0
+#endif
+
+static unsigned long readCanary(void) {
+#if defined(__x86_64__)
+    unsigned long canary;
+    __asm__ volatile("movq %%fs:0x28, %0" : "=r"(canary));
+    return canary;
+#else
+    return 0;
+#endif
+}
+
+static void writeCanary(unsigned long canary) {
+#if defined(__x86_64__)
+    __asm__ volatile("movq %0, %%fs:0x28" : : "r"(canary) : "memory");
+#else
+    (void) canary;
+#endif
+}
+
+/*
+ * Function: writeImage
+ * --------------------
+ * This function writes 'len' bytes of memory at file offset 'off', page by
+ * page, skipping pages that are all zero.
+ *
+ * @return int -1: returned if a write fails
+ *
+ * @return int 0: success
+ */
+static int writeImage(int fd, unsigned long off, char *mem, unsigned long len) {
+    static const char zero[CKPT_PAGE];
+    unsigned long done = 0;
+
+    while (done < len) {
+        unsigned long n = len - done < CKPT_PAGE ? len - done : CKPT_PAGE;
+        if (memcmp(mem + done, zero, n) != 0 && pwrite(fd, mem + done, n, off + done) != (long) n) {
+            return -1;
+        }
+        done += n;
+    }
+    return 0;
+}
+
+/*
+ * Function: checkpointWriter
+ * --------------------------
+ * This function runs on the scratch stack while the saving process is
+ * suspended in savedContext, writes the file and switches back.
+ */
+static void checkpointWriter(void) {
+    int fd = open(writePath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    writeResult = -1;
+    if (fd >= 0) {
+        char *heapBase = (char *) header.heapBase;
+
+        if (pwrite(fd, &header, sizeof(header), 0) == sizeof(header) &&
+            writeImage(fd, header.dataOffset, __data_start, header.dataEnd - header.dataStart) == 0 &&
+            writeImage(fd, header.heapOffset, heapBase, header.heapUsed) == 0 &&
+            ftruncate(fd, header.heapOffset + header.heapUsed) == 0) {
+            writeResult = 0;
+        }
+        if (close(fd) != 0) {
+            writeResult = -1;
+        }
+    }
+    USLOSS_ContextSwitch(NULL, &savedContext);
+}
+
+/*
+ * Function: checkpointSave
+ * ------------------------
+ * This function saves the whole kernel to a file. Later runs can resume
+ * from it any number of times; see checkpointRestore().
+ *
+ * @param char *path: file to write
+ *
+ * @return int -1: returned if path is NULL or cannot be written, the kernel
+ *                 is not running on the host harness, its heap is not at
+ *                 its fixed address, processes are running on several
+ *                 CPUs, a schedule is being recorded or replayed, a
+ *                 terminal has a character out, or the kernel is built
+ *                 with AddressSanitizer
+ *
+ * @return int 0: the file was written
+ *
+ * @return int 1: a restored run is returning from the call that saved it
+ */
+int checkpointSave(char *path) {
+    checkKernelMode("checkpointSave");
+
+    if (path == NULL || __start_hoststate == NULL || __data_start == NULL || !kheapFixed ||
+        smpActive || schedMode != SCHED_LIVE || termBusy()) {
+        return -1;
+    }
+#if !defined(__x86_64__)
+    if (CKPT_NEED_CANARY) {
+        return -1;
+    }
+#endif
+#if defined(__SANITIZE_ADDRESS__)
+    // the globals' redzones cannot be read, and the shadow memory is not saved
+    return -1;
+#endif
+
+    unsigned int oldPsr = USLOSS_PsrGet();
+    char *heapBase;
+    char *stack = malloc(CKPT_STACK);
+
+    if (stack == NULL) {
+        return -1;
+    }
+    USLOSS_PsrSet(oldPsr & ~USLOSS_PSR_CURRENT_INT);
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CKPT_MAGIC, 4);
+    header.version = CKPT_VERSION;
+    header.code = (unsigned long) checkpointSave;
+    header.dataStart = (unsigned long) __data_start;
+    header.dataEnd = (unsigned long) _end;
+    header.hostStart = (unsigned long) __start_hoststate;
+    header.hostEnd = (unsigned long) __stop_hoststate;
+    header.heapUsed = kheapRange(&heapBase);
+    header.heapBase = (unsigned long) heapBase;
+    header.dataOffset = CKPT_PAGE;
+    header.heapOffset = (CKPT_PAGE + header.dataEnd - header.dataStart + CKPT_PAGE - 1) & ~(CKPT_PAGE - 1UL);
+    header.canary = readCanary();
+    header.curProc = (unsigned long) curProcess;
+    writePath = path;
+    resumed = 0;
+
+    USLOSS_ContextInit(&writerContext, stack, CKPT_STACK, NULL, checkpointWriter);
+    USLOSS_ContextSwitch(&savedContext, &writerContext);
+
+    // back from the writer, or in a restored run
+    if (resumed) {
+        resumed = 0;
+        USLOSS_PsrSet(oldPsr);
+        return 1;
+    }
+    free(stack);
+    USLOSS_PsrSet(oldPsr);
+    return writeResult;
+}
+
+/*
+ * Function: checkpointRestore
+ * ---------------------------
+ * This function is called by the host harness instead of startup() when
+ * USLOSS_HOST_RESTORE is set. It maps the checkpoint's heap, copies its
+ * globals back and resumes the process that saved it.
+ *
+ * @param char *path: checkpoint file
+ *
+ * @return int -1: returned if the file cannot be read or was not written by
+ *                 this binary with this layout; on success it does not
+ *                 return
+ */
+int checkpointRestore(char *path) {
+    struct CheckpointHeader h;
+    char **env = environ;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        return -1;
+    }
+    if (pread(fd, &h, sizeof(h), 0) != sizeof(h) || memcmp(h.magic, CKPT_MAGIC, 4) != 0 ||
+        h.version != CKPT_VERSION || h.code != (unsigned long) checkpointSave ||
+        h.dataStart != (unsigned long) __data_start || h.dataEnd != (unsigned long) _end ||
+        h.hostStart != (unsigned long) __start_hoststate || h.hostEnd != (unsigned long) __stop_hoststate ||
+        h.hostStart < h.dataStart || h.hostEnd > h.dataEnd) {
+        USLOSS_Console("checkpointRestore(): %s was not saved by this binary with this layout\n", path);
+        close(fd);
+        return -1;
+    }
+
+    // the heap: the used part from the file, paged in on demand, then the
+    // rest of the reservation
+    char *base = (char *) h.heapBase;
+    unsigned long mapped = (h.heapUsed + CKPT_PAGE - 1) & ~(CKPT_PAGE - 1UL);
+    if (mapped > 0 && mmap(base, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED_NOREPLACE, fd,
+                           h.heapOffset) != base) {
+        USLOSS_Console("checkpointRestore(): cannot map the kernel heap\n");
+        close(fd);
+        return -1;
+    }
+    if (kheapReserve(base + mapped, kheapSize() - mapped) != 0) {
+        USLOSS_Console("checkpointRestore(): cannot reserve the kernel heap\n");
+        close(fd);
+        return -1;
+    }
+
+    // the globals, around the harness's own
+    char *data = (char *) h.dataStart;
+    unsigned long before = h.hostStart - h.dataStart;
+    unsigned long after = h.dataEnd - h.hostEnd;
+    if (pread(fd, data, before, h.dataOffset) != (long) before ||
+        pread(fd, (char *) h.hostEnd, after, h.dataOffset + (h.hostEnd - h.dataStart)) != (long) after) {
+        // the globals are half overwritten, so there is no going back
+        USLOSS_Console("checkpointRestore(): %s is truncated\n", path);
+        USLOSS_Halt(1);
+    }
+    close(fd);
+    environ = env;
+
+    writeCanary(h.canary);
+    curProcess = (struct PCB *) h.curProc;
+    resumed = 1;
+    USLOSS_ContextSwitch(NULL, &savedContext);
+    return -1;
+}
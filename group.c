@@ -0,0 +1,655 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include "kernel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Process groups, and CPU quotas for them. A group with a quota may use
+ * 'quota' microseconds of currentTime() in every 'period'. The clock
+ * handler charges the running process's group for the time since the last
+ * charge, as does every switch, and once the group is over its quota sets
+ * wakePending. Like the other handlers it never touches a queue:
+ * quotaUpdate(), run at the next kernel entry or dispatch, throttles the
+ * group by moving its ready members to the group's parked list, and while
+ * it is throttled enqueueReady() parks any member that becomes ready. When
+ * the period ends they all go back on their ready queues in order.
+ */
+
+struct ProcGroup {
+    int used; // flag to check if group in use
+    int members; // processes in the group, including terminated ones
+    struct PCB *head; // first member
+    int quota; // microseconds of CPU per period; 0 for no limit
+    int period; // length of a period in microseconds
+    int period_start; // currentTime() when the current period began
+    int cpu_used; // CPU charged in the current period
+    int throttled; // members are held off the ready queues
+    int throttled_at; // currentTime() when the group was last throttled
+    int throttles; // times it has been throttled
+    long long throttled_time; // microseconds spent throttled before now
+    struct PCB *parked_head; // ready members held back, threaded through
+    struct PCB *parked_tail; // run_queue_next/run_queue_prev
+};
+
+// process group table; entry 0 stands for "no group" and is never used
+struct ProcGroup groupTable[MAXGROUPS];
+
+// groups with a quota, and how many of them are throttled now
+static int quotaGroups;
+static int throttledGroups;
+
+// currentTime() when the running process's group was last charged
+static int quotaChargeTime;
+
+static void (*chainedClockHandler)(int dev, void *arg);
+
+static void quotaClockHandler(int dev, void *arg);
+
+/*
+ * Function: groupInit
+ * -------------------
+ * This function empties the group table and installs the quota clock
+ * handler.
+ */
+void groupInit(void) {
+    memset(groupTable, 0, sizeof(groupTable));
+    quotaGroups = 0;
+    throttledGroups = 0;
+
+    chainedClockHandler = USLOSS_IntVec[USLOSS_CLOCK_INT];
+    USLOSS_IntVec[USLOSS_CLOCK_INT] = quotaClockHandler;
+}
+
+/*
+ * Function: groupAdd
+ * ------------------
+ * This function puts a process at the front of a group's member list.
+ * 
+ * @param int gid: group to join, or 0 for none
+ */
+void groupAdd(struct PCB *proc, int gid) {
+    proc->group = gid;
+    proc->group_prev = NULL;
+    proc->group_next = NULL;
+    if (gid == 0) {
+        return;
+    }
+
+    struct ProcGroup *group = &groupTable[gid];
+    proc->group_next = group->head;
+    if (group->head != NULL) {
+        group->head->group_prev = proc;
+    }
+    group->head = proc;
+    group->members++;
+}
+
+/*
+ * Function: groupRemove
+ * ---------------------
+ * This function takes a process out of its group, if it is in one.
+ */
+void groupRemove(struct PCB *proc) {
+    if (proc->group == 0) {
+        return;
+    }
+
+    struct ProcGroup *group = &groupTable[proc->group];
+    if (proc->group_prev == NULL) {
+        group->head = proc->group_next;
+    }
+    else {
+        proc->group_prev->group_next = proc->group_next;
+    }
+    if (proc->group_next != NULL) {
+        proc->group_next->group_prev = proc->group_prev;
+    }
+    group->members--;
+    proc->group = 0;
+    proc->group_next = NULL;
+    proc->group_prev = NULL;
+}
+
+/*
+ * Function: getGroup
+ * ------------------
+ * This function looks up a group by ID.
+ * 
+ * @return struct ProcGroup *: the group, or NULL if gid is not a group in use
+ */
+static struct ProcGroup *getGroup(int gid) {
+    if (gid <= 0 || gid >= MAXGROUPS || !groupTable[gid].used) {
+        return NULL;
+    }
+    return &groupTable[gid];
+}
+
+/*
+ * Function: getLiveProcess
+ * ------------------------
+ * This function finds a process that has not terminated.
+ * 
+ * @return struct PCB *: the process, or NULL if pid is not a live process
+ */
+static struct PCB *getLiveProcess(int pid) {
+    struct PCB *proc = pid_lookup(pid);
+
+    if (proc == NULL || proc->run_state == PROC_ZOMBIE) {
+        return NULL;
+    }
+    return proc;
+}
+
+/*
+ * Function: create_group
+ * ----------------------
+ * This function creates an empty process group.
+ * 
+ * @return int -1: returned if the group table is full
+ * 
+ * @return int >0: ID of the new group
+ */
+int create_group(void) {
+    checkKernelMode("create_group");
+
+    int gid;
+    for (gid = 1; gid < MAXGROUPS; gid++) {
+        if (!groupTable[gid].used) {
+            memset(&groupTable[gid], 0, sizeof(struct ProcGroup));
+            groupTable[gid].used = 1;
+            return gid;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Function: free_group
+ * --------------------
+ * This function deletes an empty process group.
+ * 
+ * @return int -1: returned if gid is not a group or it still has members
+ * 
+ * @return int 0: success
+ */
+int free_group(int gid) {
+    checkKernelMode("free_group");
+
+    struct ProcGroup *group = getGroup(gid);
+    if (group == NULL || group->members > 0) {
+        return -1;
+    }
+    if (group->quota > 0) {
+        quotaGroups--;
+    }
+    if (group->throttled) {
+        throttledGroups--;
+    }
+    group->used = 0;
+    group->quota = 0;
+    return 0;
+}
+
+/*
+ * Function: set_group
+ * -------------------
+ * This function moves a live process into a group. Its existing children
+ * stay where they are; children it sporks later start in the new group. A
+ * ready process moving into a throttled group waits for its next period.
+ * 
+ * @param int gid: group to move to, or 0 to leave all groups
+ * 
+ * @return int -1: returned if pid is not a live process or gid is not a group
+ * 
+ * @return int 0: success
+ */
+int set_group(int pid, int gid) {
+    checkKernelMode("set_group");
+
+    struct PCB *proc = getLiveProcess(pid);
+    if (proc == NULL || (gid != 0 && getGroup(gid) == NULL)) {
+        return -1;
+    }
+    // a ready process is requeued, so that it leaves a throttled group's
+    // parked list or joins the new group's
+    int ready = proc->run_state == PROC_READY && !smpActive;
+    if (ready) {
+        unreadyProcess(proc);
+    }
+    groupRemove(proc);
+    groupAdd(proc, gid);
+    if (ready) {
+        requeueProcess(proc);
+    }
+    return 0;
+}
+
+/*
+ * Function: get_group
+ * -------------------
+ * This function reports which group a live process is in.
+ * 
+ * @return int -1: returned if pid is not a live process
+ * 
+ * @return int >=0: group ID, 0 if none
+ */
+int get_group(int pid) {
+    checkKernelMode("get_group");
+
+    struct PCB *proc = getLiveProcess(pid);
+    if (proc == NULL) {
+        return -1;
+    }
+    return proc->group;
+}
+
+/*
+ * Function: kill_group
+ * --------------------
+ * This function marks every live member of a group for termination in a
+ * single pass over the group's member list. Members see the mark through
+ * isKilled() and are expected to quit. A member blocked in SemP(),
+ * MutexLock(), a mailbox call, clockSleep(), wait_any(), join(), or on a
+ * terminal is woken at once, and that call returns -4, so that it can
+ * quit too. The best of the woken members runs right away if it outranks
+ * the caller. During smpRun() members are only marked.
+ * 
+ * @return int -1: returned if gid is not a group
+ * 
+ * @return int >=0: number of processes marked
+ */
+int kill_group(int gid) {
+    checkKernelMode("kill_group");
+
+    struct ProcGroup *group = getGroup(gid);
+    if (group == NULL) {
+        return -1;
+    }
+
+    int count = 0;
+    struct PCB *proc;
+    for (proc = group->head; proc != NULL; proc = proc->group_next) {
+        if (proc->run_state != PROC_ZOMBIE) {
+            proc->killed = 1;
+            count++;
+            if (!smpActive) {
+                cancelWait(proc);
+            }
+        }
+    }
+    if (!smpActive) {
+        preemptIfOutranked();
+    }
+    return count;
+}
+
+/*
+ * Function: join_group
+ * --------------------
+ * This function reaps, in a single pass, every terminated member of a group
+ * that is a child of the current process. Each reap is constant time, so
+ * tearing down a group costs time linear in its size.
+ * 
+ * @return int -1: returned if gid is not a group
+ * 
+ * @return int >=0: number of children reaped
+ */
+int join_group(int gid) {
+    checkKernelMode("join_group");
+
+    struct ProcGroup *group = getGroup(gid);
+    if (group == NULL) {
+        return -1;
+    }
+
+    int count = 0;
+    struct PCB *proc = group->head;
+    while (proc != NULL) {
+        struct PCB *next = proc->group_next;
+        if (proc->run_state == PROC_ZOMBIE && proc->parent == curProcess) {
+            reapChild(proc);
+            count++;
+        }
+        proc = next;
+    }
+    return count;
+}
+
+/*
+ * Function: isKilled
+ * ------------------
+ * This function tells the current process whether kill_group() has asked it
+ * to quit. Long-running processes poll it, so it is also a kernel entry
+ * where a pending reschedule takes effect.
+ * 
+ * @return int 1: the process has been marked for termination
+ * 
+ * @return int 0: it has not
+ */
+int isKilled(void) {
+    checkKernelMode("isKilled");
+
+    if (curProcess == NULL) {
+        return 0;
+    }
+    return curProcess->killed;
+}
+
+/*
+ * Function: rollPeriod
+ * --------------------
+ * This function starts a new period for a group with a quota if the
+ * current one is over, forgiving the CPU it used.
+ */
+static void rollPeriod(struct ProcGroup *group, int now) {
+    if (now - group->period_start >= group->period) {
+        group->period_start += (now - group->period_start) / group->period * group->period;
+        group->cpu_used = 0;
+    }
+}
+
+/*
+ * Function: quotaCharge
+ * ---------------------
+ * This function charges a process's group for the time since the last
+ * charge; called from the clock handler and on every switch. It only
+ * updates counters, so it is safe from the handler.
+ */
+void quotaCharge(struct PCB *proc) {
+    if (quotaGroups == 0 || smpActive) {
+        return;
+    }
+    int now = currentTime();
+
+    if (proc != NULL && proc->group != 0 && groupTable[proc->group].quota > 0) {
+        struct ProcGroup *group = &groupTable[proc->group];
+
+        rollPeriod(group, now);
+        group->cpu_used += now - quotaChargeTime;
+
+        // over quota: quotaUpdate() throttles it at the next kernel entry
+        if (!group->throttled && group->cpu_used >= group->quota) {
+            wakePending = 1;
+        }
+    }
+    quotaChargeTime = now;
+}
+
+static void quotaClockHandler(int dev, void *arg) {
+    quotaCharge(curProcess);
+
+    // a throttled group is released at the first kernel entry or dispatch
+    // after its period ends
+    if (throttledGroups > 0) {
+        wakePending = 1;
+    }
+
+    if (chainedClockHandler != NULL) {
+        chainedClockHandler(dev, arg);
+    }
+}
+
+/*
+ * Function: groupThrottled
+ * ------------------------
+ * This function tells enqueueReady() and the dispatcher whether a group's
+ * members are being held off the ready queues.
+ */
+int groupThrottled(int gid) {
+    return gid != 0 && groupTable[gid].throttled;
+}
+
+/*
+ * Function: groupPark
+ * -------------------
+ * This function puts a ready member of a throttled group at the tail of the
+ * group's parked list, in place of a ready queue.
+ */
+void groupPark(struct PCB *proc) {
+    struct ProcGroup *group = &groupTable[proc->group];
+
+    proc->parked = 1;
+    proc->run_queue_next = NULL;
+    proc->run_queue_prev = group->parked_tail;
+    if (group->parked_tail == NULL) {
+        group->parked_head = proc;
+    }
+    else {
+        group->parked_tail->run_queue_next = proc;
+    }
+    group->parked_tail = proc;
+}
+
+/*
+ * Function: groupUnpark
+ * ---------------------
+ * This function takes a process off its group's parked list.
+ */
+void groupUnpark(struct PCB *proc) {
+    struct ProcGroup *group = &groupTable[proc->group];
+
+    if (proc->run_queue_prev == NULL) {
+        group->parked_head = proc->run_queue_next;
+    }
+    else {
+        proc->run_queue_prev->run_queue_next = proc->run_queue_next;
+    }
+    if (proc->run_queue_next == NULL) {
+        group->parked_tail = proc->run_queue_prev;
+    }
+    else {
+        proc->run_queue_next->run_queue_prev = proc->run_queue_prev;
+    }
+    proc->run_queue_next = NULL;
+    proc->run_queue_prev = NULL;
+    proc->parked = 0;
+}
+
+/*
+ * Function: unthrottle
+ * --------------------
+ * This function lets a throttled group run again, putting its parked
+ * members back on their ready queues in the order they were parked.
+ */
+static void unthrottle(struct ProcGroup *group, int now) {
+    group->throttled = 0;
+    group->throttled_time += now - group->throttled_at;
+    throttledGroups--;
+
+    while (group->parked_head != NULL) {
+        struct PCB *proc = group->parked_head;
+
+        groupUnpark(proc);
+        requeueProcess(proc);
+    }
+}
+
+/*
+ * Function: quotaUpdate
+ * ---------------------
+ * This function throttles the groups that have used up their quota and
+ * releases those whose period is over; called with the other wake-ups at
+ * kernel entries and in the dispatcher. A throttled group's ready members
+ * move to its parked list; if the current process is one of them, it
+ * gives up the CPU in preemptIfOutranked() or the dispatcher.
+ */
+void quotaUpdate(void) {
+    int gid, now;
+
+    if (quotaGroups == 0 || smpActive) {
+        return;
+    }
+    quotaCharge(curProcess);
+    now = currentTime();
+
+    for (gid = 1; gid < MAXGROUPS; gid++) {
+        struct ProcGroup *group = &groupTable[gid];
+
+        if (!group->used || group->quota == 0) {
+            continue;
+        }
+        rollPeriod(group, now);
+        if (group->throttled && group->cpu_used < group->quota) {
+            unthrottle(group, now);
+        }
+        else if (!group->throttled && group->cpu_used >= group->quota) {
+            struct PCB *proc;
+
+            group->throttled = 1;
+            group->throttled_at = now;
+            group->throttles++;
+            throttledGroups++;
+            for (proc = group->head; proc != NULL; proc = proc->group_next) {
+                if (proc->run_state == PROC_READY) {
+                    unreadyProcess(proc);
+                    requeueProcess(proc);
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Function: quotaWaiting
+ * ----------------------
+ * This function tells the deadlock checks whether some group is throttled,
+ * so that its parked members will be ready again when its period ends.
+ */
+int quotaWaiting(void) {
+    return throttledGroups > 0;
+}
+
+/*
+ * Function: groupParked
+ * ---------------------
+ * This function counts the processes on parked lists, for
+ * checkProcessTable().
+ *
+ * @return int -1: returned if a parked list is inconsistent
+ *
+ * @return int >=0: number of parked processes
+ */
+int groupParked(void) {
+    int gid, n = 0;
+
+    for (gid = 1; gid < MAXGROUPS; gid++) {
+        struct PCB *proc;
+
+        for (proc = groupTable[gid].parked_head; proc != NULL; proc = proc->run_queue_next) {
+            if (++n > MAXPROC || !groupTable[gid].throttled || !proc->parked || proc->group != gid ||
+                proc->run_state != PROC_READY) {
+                return -1;
+            }
+        }
+    }
+    return n;
+}
+
+/*
+ * Function: set_group_quota
+ * -------------------------
+ * This function limits a group to 'quota' microseconds of CPU in every
+ * 'period' microseconds, starting a new period now, or with a quota of 0
+ * lifts the limit and releases the group if it is throttled. The limit is
+ * enforced at kernel entries: a member that runs over its group's quota is
+ * switched out at its next one.
+ *
+ * @param int gid: group ID
+ *
+ * @param int quota: CPU per period in microseconds, or 0 for no limit
+ *
+ * @param int period: length of a period in microseconds
+ *
+ * @return int -1: returned if gid is not a group, quota is negative, or
+ *                 quota is positive and period is not
+ *
+ * @return int 0: success
+ */
+int set_group_quota(int gid, int quota, int period) {
+    checkKernelMode("set_group_quota");
+
+    struct ProcGroup *group = getGroup(gid);
+    if (group == NULL || quota < 0 || (quota > 0 && period <= 0)) {
+        return -1;
+    }
+    int now = currentTime();
+
+    if (group->throttled) {
+        unthrottle(group, now);
+    }
+    if (quotaGroups == 0) {
+        quotaChargeTime = now;
+    }
+    quotaGroups += (quota > 0) - (group->quota > 0);
+    group->quota = quota;
+    group->period = quota > 0 ? period : 0;
+    group->period_start = now;
+    group->cpu_used = 0;
+    return 0;
+}
+
+/*
+ * Function: groupQuotaStats
+ * -------------------------
+ * This function reports on a group's quota and its throttling so far.
+ *
+ * @param struct QuotaStats *stats: out-pointer filled with the counters
+ *
+ * @return int -1: returned if gid is not a group or stats is NULL
+ *
+ * @return int 0: success
+ */
+int groupQuotaStats(int gid, struct QuotaStats *stats) {
+    checkKernelMode("groupQuotaStats");
+
+    struct ProcGroup *group = getGroup(gid);
+    if (group == NULL || stats == NULL) {
+        return -1;
+    }
+    quotaCharge(curProcess);
+
+    stats->quota = group->quota;
+    stats->period = group->period;
+    stats->used = group->cpu_used;
+    stats->throttled = group->throttled;
+    stats->throttles = group->throttles;
+    stats->throttledTime = group->throttled_time;
+    if (group->throttled) {
+        stats->throttledTime += currentTime() - group->throttled_at;
+    }
+    return 0;
+}
+
+/*
+ * Function: dumpGroups
+ * --------------------
+ * This function prints every group in use with its quota and throttling,
+ * one line each; dumpProcesses() adds it while any group has a quota.
+ */
+void dumpGroups(void) {
+    checkKernelMode("dumpGroups");
+
+    struct QuotaStats stats;
+    int gid;
+
+    USLOSS_Console("%4s  %7s  %9s  %9s  %9s  %-10s %9s  %12s\n", "GID", "MEMBERS", "QUOTA", "PERIOD", "USED",
+                   "STATE", "THROTTLES", "THROTTLED_US");
+    for (gid = 1; gid < MAXGROUPS; gid++) {
+        if (groupQuotaStats(gid, &stats) == 0) {
+            USLOSS_Console("%4d  %7d  %9d  %9d  %9d  %-10s %9d  %12lld\n", gid, groupTable[gid].members,
+                           stats.quota, stats.period, stats.used, stats.throttled ? "Throttled" : "Running",
+                           stats.throttles, stats.throttledTime);
+        }
+    }
+}
+
+/*
+ * Function: quotaActive
+ * ---------------------
+ * This function tells dumpProcesses() whether any group has a quota.
+ */
+int quotaActive(void) {
+    return quotaGroups > 0;
+}
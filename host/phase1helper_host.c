@@ -0,0 +1,95 @@
+/*
+ * Host-side stand-in for libphase1helper.a.
+ *
+ * Provides russ_ContextInit(), currentTime() and the init/testcase trampolines
+ * the same way the shipped helper library does, with the same messages, so
+ * that a testcase prints the same output whether it is linked against USLOSS
+ * or against the host stand-in in host/usloss_host.c. The library's asserts
+ * and its checks for a corrupted launch record or a bad getpid() are left
+ * out.
+ */
+
+#include <usloss.h>
+#include <phase1.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+struct launch_delegate {
+    int (*func)(char *);
+    char *arg;
+};
+
+static struct launch_delegate launch_delegates[MAXPROC];
+
+static int testcase_main_wrapper(char *arg) {
+    int rc = testcase_main();
+    if (rc != 0) {
+        USLOSS_Console("ERROR: testcase_main() returned nonzero: status=%d\n", rc);
+    } else {
+        USLOSS_Console("TESTCASE ENDED\n");
+    }
+    USLOSS_Halt(rc);
+}
+
+// kernel mode, interrupts off, with the old mode and interrupt bits saved
+static void disable_interrupts(void) {
+    USLOSS_PsrSet(((USLOSS_PsrGet() & 0x3) << 2) | USLOSS_PSR_CURRENT_MODE);
+}
+
+static void russ_launchTrampoline(void) {
+    struct launch_delegate *d = &launch_delegates[getpid() % MAXPROC];
+
+    // processes start in kernel mode with interrupts enabled
+    USLOSS_PsrSet(USLOSS_PsrGet() | USLOSS_PSR_CURRENT_INT);
+
+    d->func(d->arg);
+    USLOSS_Console("phase1helper: russ_launchTrampoline(): (pid=%d) You returned to the phase1helper, which is illegal.  "
+                   "Use a trampoline function \"wrap\" the process-main function, and call quit() on its behalf if it "
+                   "returns to you.\n", getpid());
+    USLOSS_Halt(1);
+}
+
+void russ_ContextInit(int pid, USLOSS_Context *state, char *stack, int stackSize,
+                      int (*func)(char *), char *arg) {
+    launch_delegates[pid % MAXPROC].func = func;
+    launch_delegates[pid % MAXPROC].arg  = arg;
+    USLOSS_ContextInit(state, stack, stackSize, NULL, russ_launchTrampoline);
+}
+
+int currentTime(void) {
+    int now;
+    USLOSS_DeviceInput(USLOSS_CLOCK_DEV, 0, &now);
+    return now;
+}
+
+void phase1helper_init(void) {
+}
+
+void startProcesses(void) {
+    phase1_dispatcher_wrapper(1);
+}
+
+int init_main(char *arg) {
+    int status;
+
+    phase2_start_service_processes();
+    phase3_start_service_processes();
+    phase4_start_service_processes();
+
+    int pid = spork("testcase_main", testcase_main_wrapper, NULL, USLOSS_MIN_STACK, 3);
+    if (pid <= 0) {
+        USLOSS_Console("ERROR: Could not create the testcase_init process, rc=%d\n", pid);
+        USLOSS_Halt(1);
+    }
+    disable_interrupts();
+    phase1_dispatcher_wrapper(pid);
+
+    // init reaps whatever ends up as its child, forever
+    while (1) {
+        if (join(&status) == -2) {
+            USLOSS_Console("ERROR: All of the children of init have died.  This should never occcur, "
+                           "since testcase_main() is supposed to Halt() the system!!!\n");
+            USLOSS_Halt(1);
+        }
+    }
+}
@@ -0,0 +1,114 @@
+/*
+ * Host-side stand-in for the USLOSS header.
+ *
+ * This declares only the subset of the USLOSS 4.7 interface that the phase1
+ * kernel and the testcases use, so that the same sources can be compiled into
+ * a normal Linux binary (see host/usloss_host.c).  It is picked up instead of
+ * the real <usloss.h> by putting host/ on the include path.
+ */
+
+#ifndef _USLOSS_H
+#define _USLOSS_H
+
+#include <ucontext.h>
+
+/*
+ * Processor status register bits.
+ */
+
+#define USLOSS_PSR_CURRENT_MODE  0x1
+#define USLOSS_PSR_CURRENT_INT   0x2
+#define USLOSS_PSR_PREV_MODE     0x4
+#define USLOSS_PSR_PREV_INT      0x8
+#define USLOSS_PSR_MASK          0xf
+
+/*
+ * Interrupt vector indices, which double as device types.
+ */
+
+#define USLOSS_CLOCK_INT    0
+#define USLOSS_ALARM_INT    1
+#define USLOSS_TERM_INT     2
+#define USLOSS_SYSCALL_INT  3
+#define USLOSS_DISK_INT     4
+#define USLOSS_MMU_INT      5
+#define USLOSS_ILLEGAL_INT  6
+#define USLOSS_NUM_INTS     7
+
+#define USLOSS_CLOCK_DEV    USLOSS_CLOCK_INT
+#define USLOSS_ALARM_DEV    USLOSS_ALARM_INT
+#define USLOSS_TERM_DEV     USLOSS_TERM_INT
+#define USLOSS_DISK_DEV     USLOSS_DISK_INT
+
+#define USLOSS_CLOCK_UNITS  1
+#define USLOSS_TERM_UNITS   4
+#define USLOSS_CLOCK_MS     20
+
+/*
+ * Device status and return codes.
+ */
+
+#define USLOSS_DEV_OK       0
+#define USLOSS_DEV_INVALID  1
+
+#define USLOSS_DEV_READY    0
+#define USLOSS_DEV_BUSY     1
+#define USLOSS_DEV_ERROR    2
+
+/*
+ * Terminal status and control register layout.
+ */
+
+#define USLOSS_TERM_STAT_CHAR(status)   (((status) >> 8) & 0xff)
+#define USLOSS_TERM_STAT_XMIT(status)   (((status) >> 2) & 0x3)
+#define USLOSS_TERM_STAT_RECV(status)   ((status) & 0x3)
+
+#define USLOSS_TERM_CTRL_CHAR(ctrl, ch) ((ctrl) | (((ch) & 0xff) << 8))
+#define USLOSS_TERM_CTRL_XMIT_INT(ctrl) ((ctrl) | 0x4)
+#define USLOSS_TERM_CTRL_RECV_INT(ctrl) ((ctrl) | 0x2)
+#define USLOSS_TERM_CTRL_XMIT_CHAR(ctrl) ((ctrl) | 0x1)
+
+#define USLOSS_MIN_STACK    (80 * 1024)
+
+typedef struct USLOSS_PTE USLOSS_PTE;
+
+typedef struct USLOSS_Context {
+    void (*start)(void);
+    int initial_psr;
+    ucontext_t context;
+} USLOSS_Context;
+
+typedef struct USLOSS_Sysargs {
+    int number;
+    void *arg1;
+    void *arg2;
+    void *arg3;
+    void *arg4;
+    void *arg5;
+} USLOSS_Sysargs;
+
+extern void (*USLOSS_IntVec[USLOSS_NUM_INTS])(int dev, void *arg);
+
+extern void USLOSS_Console(char *format, ...);
+extern void USLOSS_Halt(int status) __attribute__((__noreturn__));
+extern unsigned int USLOSS_PsrGet(void);
+extern int  USLOSS_PsrSet(unsigned int psr);
+extern void USLOSS_ContextInit(USLOSS_Context *context, void *stack, int stackSize,
+                               USLOSS_PTE *pageTable, void (*func)(void));
+extern void USLOSS_ContextSwitch(USLOSS_Context *old, USLOSS_Context *new);
+extern void USLOSS_WaitInt(void);
+extern int  USLOSS_DeviceInput(int dev, int unit, int *status);
+extern int  USLOSS_DeviceOutput(int dev, int unit, void *arg);
+extern void USLOSS_Syscall(void *arg);
+extern int  USLOSS_Clock(void);
+
+/*
+ * Provided by the simulated program.
+ */
+
+extern void startup(int argc, char **argv);
+extern void finish(int argc, char **argv);
+extern void test_setup(int argc, char **argv);
+extern void test_cleanup(int argc, char **argv);
+
+#endif /* _USLOSS_H */
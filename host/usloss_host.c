@@ -0,0 +1,433 @@
+/*
+ * Host-side stand-in for the USLOSS simulator.
+ *
+ * Implements the USLOSS calls used by the phase1 kernel on top of ucontext
+ * and POSIX signals, so the kernel and the testcases link into an ordinary
+ * Linux binary that can be run under perf, the sanitizers or a fuzzer.  The
+ * clock interrupt is driven by SIGALRM every USLOSS_CLOCK_MS milliseconds
+ * (set USLOSS_HOST_NOCLOCK in the environment to turn it off, or
+ * USLOSS_HOST_CLOCK_US to a tick length in microseconds).  With the clock
+ * off, USLOSS_WaitInt() delivers a tick at once, so sleeping processes still
+ * wake up in a deterministic order.
+ *
+ * The four terminals write what they are sent to term<unit>.out. Each
+ * character keeps the transmitter busy for USLOSS_HOST_TERM_US microseconds
+ * (default 100), timed with a POSIX timer on SIGUSR1, and then raises
+ * USLOSS_TERM_INT if transmit interrupts are enabled. With the clock off, a
+ * character instead finishes when the terminal's status is read or at the
+ * next USLOSS_WaitInt(), again so that runs are deterministic.
+ *
+ * Checkpoints are only set up when asked for, so that perf, sanitizer and
+ * fuzzer runs see the usual process. With USLOSS_HOST_CHECKPOINT or
+ * USLOSS_HOST_RESTORE in the environment, the binary re-executes itself
+ * once at start with address randomization off, so that every such run has
+ * the same layout. If USLOSS_HOST_RESTORE names a checkpoint file, the
+ * kernel's checkpointRestore() is called instead of startup(). The
+ * harness's own state is kept in the "hoststate" section, which a restore
+ * leaves alone.
+ */
+
+#define _GNU_SOURCE  // for REG_RIP in ucontext.h
+
+#include <usloss.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <signal.h>
+#include <ucontext.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/personality.h>
+#include <unistd.h>
+
+// the harness's variables, which a restore must not overwrite
+#define HOST_STATE  __attribute__((section("hoststate")))
+
+void (*USLOSS_IntVec[USLOSS_NUM_INTS])(int dev, void *arg);
+
+// the simulated processor status register; we start in kernel mode with
+// interrupts disabled, like USLOSS does. In HOST_SMP builds every host
+// thread is a CPU with its own PSR, so there it is thread-local (which also
+// keeps it out of the hoststate section)
+#ifdef HOST_SMP
+static __thread volatile unsigned int psr = USLOSS_PSR_CURRENT_MODE;
+#else
+static volatile unsigned int psr HOST_STATE = USLOSS_PSR_CURRENT_MODE;
+#endif
+
+// set by the SIGALRM handler when a tick arrives while interrupts are off
+static volatile sig_atomic_t clockPending HOST_STATE = 0;
+
+// whether SIGALRM ticks are being generated at all
+static int clockRunning HOST_STATE = 0;
+
+// PC the last clock signal interrupted, for the profiler
+static volatile unsigned long lastPc HOST_STATE = 0;
+
+static struct timespec bootTime HOST_STATE;
+
+struct HostTerm {
+    FILE *out;            // term<unit>.out, opened on the first character
+    int ctrl;             // last control word written
+    int busy;             // a character is being sent
+    int intPending;       // its interrupt has not been delivered yet
+    long long due;        // when it is done, in ns (clock running only)
+};
+
+static struct HostTerm terms[USLOSS_TERM_UNITS] HOST_STATE;
+
+// set when some terminal has an interrupt waiting for interrupts to be on
+static volatile sig_atomic_t termPending HOST_STATE = 0;
+
+static timer_t termTimer HOST_STATE;
+static int termCharUs HOST_STATE = 100;
+
+static int    savedArgc HOST_STATE;
+static char **savedArgv HOST_STATE;
+
+/*
+ * Function: deliverClock
+ * ----------------------
+ * Runs the clock handler with interrupts disabled, the way the hardware
+ * would, and restores the interrupted PSR afterwards.
+ */
+static void deliverClock(void) {
+    unsigned int old = psr;
+    clockPending = 0;
+    psr = (psr & ~USLOSS_PSR_CURRENT_INT) | USLOSS_PSR_CURRENT_MODE;
+    if (USLOSS_IntVec[USLOSS_CLOCK_INT] != NULL) {
+        USLOSS_IntVec[USLOSS_CLOCK_INT](USLOSS_CLOCK_DEV, NULL);
+    }
+    psr = old;
+}
+
+static void clockSignal(int sig, siginfo_t *info, void *uc) {
+    mcontext_t *mc = &((ucontext_t *) uc)->uc_mcontext;
+#if defined(__x86_64__)
+    lastPc = mc->gregs[REG_RIP];
+#elif defined(__aarch64__)
+    lastPc = mc->pc;
+#endif
+    if (psr & USLOSS_PSR_CURRENT_INT) {
+        deliverClock();
+    } else {
+        clockPending = 1;
+    }
+}
+
+static long long nowNs(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/*
+ * Function: finishTerm
+ * --------------------
+ * Ends the character in flight on a terminal and, if transmit interrupts
+ * are enabled, marks its interrupt pending.
+ */
+static void finishTerm(int unit) {
+    terms[unit].busy = 0;
+    if (terms[unit].ctrl & USLOSS_TERM_CTRL_XMIT_INT(0)) {
+        terms[unit].intPending = 1;
+        termPending = 1;
+    }
+}
+
+/*
+ * Function: deliverTerms
+ * ----------------------
+ * Runs the terminal handler once for each pending terminal interrupt, with
+ * interrupts disabled, like deliverClock().
+ */
+static void deliverTerms(void) {
+    unsigned int old = psr;
+    int unit;
+
+    termPending = 0;
+    psr = (psr & ~USLOSS_PSR_CURRENT_INT) | USLOSS_PSR_CURRENT_MODE;
+    for (unit = 0; unit < USLOSS_TERM_UNITS; unit++) {
+        if (terms[unit].intPending) {
+            terms[unit].intPending = 0;
+            if (USLOSS_IntVec[USLOSS_TERM_INT] != NULL) {
+                USLOSS_IntVec[USLOSS_TERM_INT](USLOSS_TERM_DEV, (void *) (long) unit);
+            }
+        }
+    }
+    psr = old;
+}
+
+/*
+ * Function: armTermTimer
+ * ----------------------
+ * Sets the terminal timer for the earliest busy terminal, or stops it.
+ */
+static void armTermTimer(void) {
+    struct itimerspec when;
+    long long first = 0, now = nowNs();
+    int unit;
+
+    for (unit = 0; unit < USLOSS_TERM_UNITS; unit++) {
+        if (terms[unit].busy && (first == 0 || terms[unit].due < first)) {
+            first = terms[unit].due;
+        }
+    }
+    memset(&when, 0, sizeof(when));
+    if (first != 0) {
+        long long wait = first > now ? first - now : 1;
+        when.it_value.tv_sec = wait / 1000000000LL;
+        when.it_value.tv_nsec = wait % 1000000000LL;
+    }
+    timer_settime(termTimer, 0, &when, NULL);
+}
+
+static void termSignal(int sig) {
+    long long now = nowNs();
+    int unit;
+
+    for (unit = 0; unit < USLOSS_TERM_UNITS; unit++) {
+        if (terms[unit].busy && terms[unit].due <= now) {
+            finishTerm(unit);
+        }
+    }
+    armTermTimer();
+    if (termPending && (psr & USLOSS_PSR_CURRENT_INT)) {
+        deliverTerms();
+    }
+}
+
+/*
+ * Function: hostInterruptedPc
+ * ---------------------------
+ * Returns the PC of the code the most recent clock tick interrupted, or 0 if
+ * there has been no tick.  The kernel's profiler looks this up as a weak
+ * symbol, so it is only used on the host.
+ */
+unsigned long hostInterruptedPc(void) {
+    return lastPc;
+}
+
+void USLOSS_Console(char *format, ...) {
+    va_list ap;
+    va_start(ap, format);
+    vfprintf(stdout, format, ap);
+    va_end(ap);
+}
+
+void USLOSS_Halt(int status) {
+    finish(savedArgc, savedArgv);
+    test_cleanup(savedArgc, savedArgv);
+    fflush(stdout);
+    exit(status);
+}
+
+unsigned int USLOSS_PsrGet(void) {
+    return psr;
+}
+
+int USLOSS_PsrSet(unsigned int newPsr) {
+    if (newPsr & ~USLOSS_PSR_MASK) {
+        return USLOSS_DEV_INVALID;
+    }
+    psr = newPsr;
+    if ((psr & USLOSS_PSR_CURRENT_INT) && clockPending) {
+        deliverClock();
+    }
+    if ((psr & USLOSS_PSR_CURRENT_INT) && termPending) {
+        deliverTerms();
+    }
+    return USLOSS_DEV_OK;
+}
+
+void USLOSS_ContextInit(USLOSS_Context *context, void *stack, int stackSize,
+                        USLOSS_PTE *pageTable, void (*func)(void)) {
+    memset(context, 0, sizeof(*context));
+    context->start = func;
+    context->initial_psr = psr;
+    getcontext(&context->context);
+    context->context.uc_stack.ss_sp = stack;
+    context->context.uc_stack.ss_size = stackSize;
+    context->context.uc_link = NULL;
+    makecontext(&context->context, func, 0);
+}
+
+void USLOSS_ContextSwitch(USLOSS_Context *old, USLOSS_Context *new) {
+    if (old == NULL) {
+        setcontext(&new->context);
+    } else {
+        swapcontext(&old->context, &new->context);
+    }
+}
+
+void USLOSS_WaitInt(void) {
+    sigset_t none;
+    int unit, busy = 0;
+
+    // with no clock running, waiting would never end; let the terminals
+    // finish their characters or, if none is busy, let a tick go by instead
+    if (!clockRunning) {
+        for (unit = 0; unit < USLOSS_TERM_UNITS; unit++) {
+            if (terms[unit].busy) {
+                finishTerm(unit);
+                busy = 1;
+            }
+        }
+        if (busy) {
+            deliverTerms();
+        }
+        else {
+            deliverClock();
+        }
+        return;
+    }
+
+    sigemptyset(&none);
+    if (!clockPending && !termPending) {
+        sigsuspend(&none);
+    }
+    if (clockPending) {
+        deliverClock();
+    }
+    if (termPending) {
+        deliverTerms();
+    }
+}
+
+int USLOSS_Clock(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int) ((now.tv_sec - bootTime.tv_sec) * 1000000 +
+                  (now.tv_nsec - bootTime.tv_nsec) / 1000);
+}
+
+int USLOSS_DeviceInput(int dev, int unit, int *status) {
+    if (dev == USLOSS_CLOCK_DEV && unit == 0) {
+        *status = USLOSS_Clock();
+        return USLOSS_DEV_OK;
+    }
+    if (dev == USLOSS_TERM_DEV && unit >= 0 && unit < USLOSS_TERM_UNITS) {
+        if (!clockRunning && terms[unit].busy) {
+            finishTerm(unit);
+        }
+        *status = (terms[unit].busy ? USLOSS_DEV_BUSY : USLOSS_DEV_READY) << 2;
+        return USLOSS_DEV_OK;
+    }
+    return USLOSS_DEV_INVALID;
+}
+
+int USLOSS_DeviceOutput(int dev, int unit, void *arg) {
+    struct HostTerm *term;
+    int ctrl = (int) (long) arg;
+    sigset_t usr1, old;
+
+    if (dev != USLOSS_TERM_DEV || unit < 0 || unit >= USLOSS_TERM_UNITS) {
+        return USLOSS_DEV_INVALID;
+    }
+    term = &terms[unit];
+
+    // the terminal timer's handler looks at the same fields
+    sigemptyset(&usr1);
+    sigaddset(&usr1, SIGUSR1);
+    sigprocmask(SIG_BLOCK, &usr1, &old);
+
+    term->ctrl = ctrl;
+    if ((ctrl & USLOSS_TERM_CTRL_XMIT_CHAR(0)) && term->busy) {
+        sigprocmask(SIG_SETMASK, &old, NULL);
+        return USLOSS_DEV_INVALID;
+    }
+    if (ctrl & USLOSS_TERM_CTRL_XMIT_CHAR(0)) {
+        if (term->out == NULL) {
+            char name[16];
+            snprintf(name, sizeof(name), "term%d.out", unit);
+            term->out = fopen(name, "w");
+        }
+        if (term->out != NULL) {
+            fputc((ctrl >> 8) & 0xff, term->out);
+            fflush(term->out);
+        }
+        term->busy = 1;
+        if (clockRunning) {
+            term->due = nowNs() + termCharUs * 1000LL;
+            armTermTimer();
+        }
+    }
+
+    sigprocmask(SIG_SETMASK, &old, NULL);
+    return USLOSS_DEV_OK;
+}
+
+void USLOSS_Syscall(void *arg) {
+    unsigned int old = psr;
+    psr = (psr & ~USLOSS_PSR_CURRENT_INT) | USLOSS_PSR_CURRENT_MODE;
+    if (USLOSS_IntVec[USLOSS_SYSCALL_INT] != NULL) {
+        USLOSS_IntVec[USLOSS_SYSCALL_INT](USLOSS_SYSCALL_INT, arg);
+    }
+    psr = old;
+}
+
+// provided by kernels that support checkpoints; returns only on failure
+extern int checkpointRestore(char *path) __attribute__((weak));
+
+int main(int argc, char **argv) {
+    if (getenv("USLOSS_HOST_CHECKPOINT") != NULL || getenv("USLOSS_HOST_RESTORE") != NULL) {
+        int persona = personality(0xffffffff);
+        if (persona != -1 && !(persona & ADDR_NO_RANDOMIZE) && personality(persona | ADDR_NO_RANDOMIZE) != -1) {
+            execv("/proc/self/exe", argv);
+            // carry on with randomization; restoring checkpoints will not work
+        }
+    }
+
+    savedArgc = argc;
+    savedArgv = argv;
+    clock_gettime(CLOCK_MONOTONIC, &bootTime);
+
+    if (getenv("USLOSS_HOST_NOCLOCK") == NULL) {
+        struct sigaction sa;
+        struct itimerval tick;
+
+        char *tickUs = getenv("USLOSS_HOST_CLOCK_US");
+        int us = (tickUs != NULL && atoi(tickUs) > 0) ? atoi(tickUs) : USLOSS_CLOCK_MS * 1000;
+
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_sigaction = clockSignal;
+        sa.sa_flags = SA_RESTART | SA_NODEFER | SA_SIGINFO;
+        sigaction(SIGALRM, &sa, NULL);
+
+        tick.it_interval.tv_sec = us / 1000000;
+        tick.it_interval.tv_usec = us % 1000000;
+        tick.it_value = tick.it_interval;
+        setitimer(ITIMER_REAL, &tick, NULL);
+        clockRunning = 1;
+
+        struct sigevent ev;
+        char *termUs = getenv("USLOSS_HOST_TERM_US");
+        termCharUs = (termUs != NULL && atoi(termUs) > 0) ? atoi(termUs) : termCharUs;
+
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = termSignal;
+        sa.sa_flags = SA_RESTART;
+        sigaction(SIGUSR1, &sa, NULL);
+
+        memset(&ev, 0, sizeof(ev));
+        ev.sigev_notify = SIGEV_SIGNAL;
+        ev.sigev_signo = SIGUSR1;
+        timer_create(CLOCK_MONOTONIC, &ev, &termTimer);
+    }
+
+    test_setup(argc, argv);
+
+    char *restore = getenv("USLOSS_HOST_RESTORE");
+    if (restore != NULL) {
+        if (checkpointRestore != NULL) {
+            checkpointRestore(restore);
+        }
+        fprintf(stderr, "usloss_host: cannot restore checkpoint %s\n", restore);
+        exit(1);
+    }
+    startup(argc, argv);
+
+    // startup() only returns if no process was ever switched to
+    USLOSS_Halt(0);
+}
@@ -0,0 +1,274 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include "kernel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * The idle process and clock sleeps. The idle process lives outside the
+ * process table, at priority 7 on queue[6], so the dispatcher only picks it
+ * when nothing at priority 1-5 can run. It waits for the next interrupt with
+ * USLOSS_WaitInt() (or, in IDLE_SPIN mode, by polling the tick count) and
+ * then wakes any sleepers that are due. The clock handler itself only counts
+ * ticks, since it can interrupt the kernel in the middle of a queue update;
+ * sleepers are moved to the ready queues at the next kernel entry or by the
+ * dispatcher.
+ */
+
+// the idle process; pid 0, never in pTable
+struct PCB idleProcess;
+
+// process the idle process hands the CPU to when the simulation starts
+struct PCB *bootTarget;
+
+// clock interrupts since phase1_init()
+static volatile int clockTicks;
+
+// processes in clockSleep(), threaded through wait_next
+static struct WaitQueue sleepers;
+
+// WAIT_TICKS nodes of processes in wait_any(), each with its wake-up tick
+static struct WaitNode *tickWatchers;
+
+// IDLE_WAIT or IDLE_SPIN
+static int idleMode = IDLE_WAIT;
+
+// currentTime() at phase1_init(), and time spent waiting since then
+static int bootTime;
+static long long idleTime;
+static int idleWakeups;
+
+static void (*chainedClockHandler)(int dev, void *arg);
+
+static void idleClockHandler(int dev, void *arg) {
+    clockTicks++;
+    if (sleepers.head != NULL || tickWatchers != NULL) {
+        wakePending = 1;
+    }
+
+    if (chainedClockHandler != NULL) {
+        chainedClockHandler(dev, arg);
+    }
+}
+
+/*
+ * Function: waitForTick
+ * ---------------------
+ * This function waits until at least one clock interrupt has arrived, or a
+ * terminal interrupt has let a waiting process go on, and adds the time it
+ * took to idleTime.
+ */
+static void waitForTick(void) {
+    int start = currentTime();
+    int seen = clockTicks;
+
+    if (idleMode == IDLE_WAIT) {
+        while (clockTicks == seen && !wakePending) {
+            USLOSS_WaitInt();
+        }
+    }
+    else {
+        while (clockTicks == seen && !wakePending) {
+        }
+    }
+    idleTime += currentTime() - start;
+    idleWakeups++;
+}
+
+/*
+ * Function: idleMain
+ * ------------------
+ * This function is the idle process. It runs first, hands the CPU to the
+ * process the simulation was started with, and from then on only runs when
+ * every other process is blocked.
+ */
+static int idleMain(char *arg) {
+    TEMP_switchTo(bootTarget->pid);
+
+    while (1) {
+        if (!sleepersWaiting() && !termWaiting() && !quotaWaiting()) {
+            USLOSS_Console("ERROR: All processes are blocked and none is waiting for the clock.\n");
+            USLOSS_Halt(1);
+        }
+        waitForTick();
+        dispatch();
+    }
+}
+
+/*
+ * Function: idleInit
+ * ------------------
+ * This function creates the idle process and installs the clock handler;
+ * called from phase1_init().
+ */
+void idleInit(void) {
+    memset(&idleProcess, 0, sizeof(idleProcess));
+    strcpy(idleProcess.name, "idle");
+    idleProcess.priority = 7;
+    idleProcess.stack = kernelAlloc(USLOSS_MIN_STACK);
+    idleProcess.stack_size = USLOSS_MIN_STACK;
+    contextInit(&idleProcess, idleMain, NULL, USLOSS_MIN_STACK);
+    readyProcess(&idleProcess);
+
+    memset(&sleepers, 0, sizeof(sleepers));
+    tickWatchers = NULL;
+    bootTarget = NULL;
+    clockTicks = 0;
+    idleMode = IDLE_WAIT;
+    bootTime = currentTime();
+    idleTime = 0;
+    idleWakeups = 0;
+
+    chainedClockHandler = USLOSS_IntVec[USLOSS_CLOCK_INT];
+    USLOSS_IntVec[USLOSS_CLOCK_INT] = idleClockHandler;
+}
+
+/*
+ * Function: wakeSleepers
+ * ----------------------
+ * This function puts every sleeper whose wake-up tick has passed back on its
+ * ready queue, and wakes the wait_any() callers whose timeout has passed. It
+ * does not switch; the dispatcher calls it just before choosing the next
+ * process.
+ */
+void wakeSleepers(void) {
+    struct PCB *proc = sleepers.head, *prev = NULL;
+    int now = clockTicks;
+
+    while (proc != NULL) {
+        struct PCB *next = proc->wait_next;
+
+        if (now - proc->wake_tick >= 0) {
+            if (prev == NULL) {
+                sleepers.head = next;
+            }
+            else {
+                prev->wait_next = next;
+            }
+            if (sleepers.tail == proc) {
+                sleepers.tail = prev;
+            }
+            proc->wait_next = NULL;
+            proc->wait_queue = NULL;
+            readyProcess(proc);
+        }
+        else {
+            prev = proc;
+        }
+        proc = next;
+    }
+    // firing a node unlinks all of its process's nodes, which may include
+    // the next one, so start over after each
+    struct WaitNode *node = tickWatchers;
+    while (node != NULL) {
+        if (now - node->id >= 0) {
+            watchFire(node);
+            node = tickWatchers;
+        }
+        else {
+            node = node->next;
+        }
+    }
+}
+
+/*
+ * Function: sleepersWaiting
+ * -------------------------
+ * This function tells the dispatcher whether some process will be woken by
+ * the clock, so that blocking with nothing else runnable is not a deadlock.
+ */
+int sleepersWaiting(void) {
+    return sleepers.head != NULL || tickWatchers != NULL;
+}
+
+/*
+ * Function: tickWatch
+ * -------------------
+ * This function sets a WAIT_TICKS node for wait_any() to fire 'ticks' clock
+ * interrupts from now; wakeSleepers() fires it.
+ */
+void tickWatch(struct WaitNode *node, int ticks) {
+    node->id = clockTicks + ticks;
+    watchAdd(&tickWatchers, node);
+}
+
+/*
+ * Function: clockSleep
+ * --------------------
+ * This function blocks the current process until 'ticks' more clock
+ * interrupts have arrived. Other processes run in the meantime, or the idle
+ * process if there are none.
+ *
+ * @param int ticks: number of clock interrupts to sleep for
+ *
+ * @return int -1: returned if ticks is negative
+ *
+ * @return int -4: returned if kill_group() woke it while blocked
+ *
+ * @return int 0: success
+ */
+int clockSleep(int ticks) {
+    checkKernelMode("clockSleep");
+
+    if (ticks < 0) {
+        return -1;
+    }
+    if (ticks == 0) {
+        return 0;
+    }
+
+    curProcess->wake_tick = clockTicks + ticks;
+    curProcess->wait_result = 0;
+    waitQueueAppend(&sleepers, curProcess);
+    blockMe();
+    return curProcess->wait_result;
+}
+
+/*
+ * Function: setIdleMode
+ * ---------------------
+ * This function chooses how the idle process waits for the next interrupt:
+ * USLOSS_WaitInt() (IDLE_WAIT, the default), which lets the host CPU sleep,
+ * or polling the tick count (IDLE_SPIN), which keeps it busy.
+ *
+ * @param int mode: IDLE_WAIT or IDLE_SPIN
+ *
+ * @return int -1: returned if mode is not one of the above
+ *
+ * @return int >=0: the previous mode
+ */
+int setIdleMode(int mode) {
+    checkKernelMode("setIdleMode");
+
+    if (mode != IDLE_WAIT && mode != IDLE_SPIN) {
+        return -1;
+    }
+    int old = idleMode;
+    idleMode = mode;
+    return old;
+}
+
+/*
+ * Function: idleStats
+ * -------------------
+ * This function reports how much of the run the CPU had nothing to do.
+ * Utilization is 1 - idle / elapsed.
+ *
+ * @param int *idle: out-pointer for the time the idle process spent waiting,
+ *                   in microseconds; may be NULL
+ *
+ * @param int *elapsed: out-pointer for the time since phase1_init(), in
+ *                      microseconds; may be NULL
+ *
+ * @return int: number of times the idle process has waited for a tick
+ */
+int idleStats(int *idle, int *elapsed) {
+    if (idle != NULL) {
+        *idle = (int) idleTime;
+    }
+    if (elapsed != NULL) {
+        *elapsed = currentTime() - bootTime;
+    }
+    return idleWakeups;
+}
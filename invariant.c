@@ -0,0 +1,184 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include "kernel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Function: invariantFailed
+ * -------------------------
+ * This function reports a broken invariant.
+ *
+ * @return int -1: always
+ */
+static int invariantFailed(char *what, int pid) {
+    USLOSS_Console("ERROR: process table invariant broken: %s (pid %d).\n", what, pid);
+    return -1;
+}
+
+/*
+ * Function: checkChildren
+ * -----------------------
+ * This function walks one process's child list, checking the links in both
+ * directions. The walk gives up after MAXPROC steps, so a cycle is reported
+ * instead of looping forever.
+ *
+ * @return int -1: returned if the list is broken
+ *
+ * @return int >=0: number of children
+ */
+static int checkChildren(struct PCB *proc) {
+    struct PCB *child, *prev = NULL;
+    int n = 0;
+
+    for (child = proc->first_child; child != NULL; child = child->next_sibling) {
+        if (++n > MAXPROC) {
+            return invariantFailed("child list has a cycle", proc->pid);
+        }
+        if (child->pid == 0) {
+            return invariantFailed("child list holds a free slot", proc->pid);
+        }
+        if (child->parent != proc) {
+            return invariantFailed("child's parent pointer is wrong", child->pid);
+        }
+        if (child->prev_sibling != prev) {
+            return invariantFailed("child's prev_sibling is wrong", child->pid);
+        }
+        prev = child;
+    }
+    if (proc->last_child != prev) {
+        return invariantFailed("last_child is not the end of the child list", proc->pid);
+    }
+    return n;
+}
+
+/*
+ * Function: checkProcessTable
+ * ---------------------------
+ * This function checks the process table's structural invariants:
+ *
+ *   - 'processes' equals the number of occupied slots, counting zombies;
+ *   - every occupied slot sits at PID_SLOT(pid) and every non-init process
+ *     has an occupied parent;
+ *   - every child list is acyclic, doubly linked correctly and ends at
+ *     last_child;
+ *   - every process, zombies included, is on its parent's child list, so the
+ *     child lists together hold every process except init exactly once;
+ *   - the ready queues (and, under POLICY_STRIDE, the stride heap, which
+ *     must be a valid min-heap) hold exactly the processes in the ready
+ *     state, and only the current process is running;
+ *   - the per-state counts match the table;
+ *   - the memory counters match the stacks of the processes in the table,
+ *     and the arena pages in use match the pages they hold.
+ *
+ * It prints the first violation it finds. It takes time linear in MAXPROC.
+ *
+ * @return int -1: returned if an invariant is broken
+ *
+ * @return int 0: all invariants hold
+ */
+int checkProcessTable(void) {
+    int i, n, occupied = 0, linked = 0, ready;
+    int counts[PROC_NUM_STATES] = { 0 };
+    long bytes = 0, zombies = 0;
+    int pages = 0;
+
+    for (i = 0; i < MAXPROC; i++) {
+        struct PCB *proc = &pTable[i];
+
+        counts[proc->run_state]++;
+        if (proc->pid == 0) {
+            if (proc->run_state != PROC_FREE) {
+                return invariantFailed("slot with no pid is not free", i);
+            }
+            continue;
+        }
+        occupied++;
+        if (PID_SLOT(proc->pid) != i) {
+            return invariantFailed("process is in the wrong slot", proc->pid);
+        }
+        if (proc->pid != 1 && (proc->parent == NULL || proc->parent->pid == 0)) {
+            return invariantFailed("process has no parent", proc->pid);
+        }
+        if (proc->run_state == PROC_FREE) {
+            return invariantFailed("process is in a free slot", proc->pid);
+        }
+        if ((proc->run_state == PROC_RUNNING) != (proc == curProcess)) {
+            return invariantFailed("running state does not match the current process", proc->pid);
+        }
+        bytes += proc->stack_size;
+        pages += proc->arena_pages;
+        zombies += proc->run_state == PROC_ZOMBIE ? proc->stack_size : 0;
+
+        int n = checkChildren(proc);
+        if (n < 0) {
+            return -1;
+        }
+        if (n != proc->num_children) {
+            return invariantFailed("child count does not match the child list", proc->pid);
+        }
+        linked += n;
+    }
+
+    if (occupied != processes) {
+        return invariantFailed("process count does not match the table", processes);
+    }
+    if (linked != occupied - 1) {
+        return invariantFailed("a process is missing from its parent's child list", linked);
+    }
+    if (bytes != stackBytes || zombies != zombieBytes) {
+        return invariantFailed("memory counters do not match the table", (int) bytes);
+    }
+    if (pages != arenaPagesInUse) {
+        return invariantFailed("arena pages in use do not match the table", pages);
+    }
+    for (i = 0; i < PROC_NUM_STATES; i++) {
+        if (counts[i] != stateCounts[i]) {
+            return invariantFailed("per-state count does not match the table", i);
+        }
+    }
+
+    // the idle process sits on queue[6] whenever it is not running, and a
+    // task runner on its priority's queue while it has tasks, but neither is
+    // in the table
+    ready = counts[PROC_READY] + (idleProcess.run_state == PROC_READY) + taskRunnersReady();
+
+    for (i = 0; i < 7; i++) {
+        struct PCB *proc;
+        int n = 0;
+
+        for (proc = queue[i].head; proc != NULL; proc = proc->run_queue_next) {
+            if (++n > MAXPROC || proc->run_state != PROC_READY || proc->priority != i + 1) {
+                return invariantFailed("ready queue is inconsistent", proc->pid);
+            }
+        }
+        ready -= n;
+    }
+
+    // under POLICY_STRIDE, priority 1-5 processes are in the heap instead
+    for (i = 0; i < strideCount; i++) {
+        struct PCB *proc = strideHeap[i];
+
+        if (proc->run_state != PROC_READY || proc->heap_index != i || proc->priority > 5 ||
+            (i > 0 && strideHeap[(i - 1) / 2]->pass > proc->pass)) {
+            return invariantFailed("stride heap is inconsistent", proc->pid);
+        }
+    }
+    if (strideCount > 0 && schedPolicy != POLICY_STRIDE) {
+        return invariantFailed("stride heap is in use under priority scheduling", strideCount);
+    }
+    ready -= strideCount;
+
+    // members of a throttled group wait on its parked list instead
+    n = groupParked();
+    if (n < 0) {
+        return invariantFailed("a throttled group's parked list is inconsistent", 0);
+    }
+    ready -= n;
+
+    if (ready != 0) {
+        return invariantFailed("a ready process is not on a ready queue", ready);
+    }
+    return 0;
+}
@@ -0,0 +1,383 @@
+/*
+ * Kernel-internal definitions shared by the phase1 source files.  Nothing in
+ * here is visible to the testcases; they only see phase1.h.
+ */
+
+#ifndef _KERNEL_H
+#define _KERNEL_H
+
+#include "phase1.h"
+
+struct Region;
+struct Task;
+struct ArenaPage;
+struct WaitNode;
+
+/*
+ * Builds with -DHOST_SMP (host only, see smp.c) run processes on several
+ * host threads at once. There, curProcess is per thread and the counters
+ * that processes on different CPUs share are updated with these macros;
+ * in every other build they are plain accesses.
+ */
+#ifdef HOST_SMP
+#define CPU_LOCAL               __thread
+#define ATOMIC_ADD(var, n)      __atomic_add_fetch(&(var), (n), __ATOMIC_RELAXED)
+#define ATOMIC_LOAD(var)        __atomic_load_n(&(var), __ATOMIC_ACQUIRE)
+#define ATOMIC_STORE(var, val)  __atomic_store_n(&(var), (val), __ATOMIC_RELEASE)
+#else
+#define CPU_LOCAL
+#define ATOMIC_ADD(var, n)      ((var) += (n))
+#define ATOMIC_LOAD(var)        (var)
+#define ATOMIC_STORE(var, val)  ((var) = (val))
+#endif
+
+struct PCB {
+    char name[MAXNAME+1]; // name of process
+    int pid; // process ID 
+    int priority; // priority 
+    USLOSS_Context state; // saved context for the USLOSS backend
+    int backend; // SWITCH_USLOSS or SWITCH_NATIVE, fixed at creation
+    void *native_sp; // saved stack pointer for the native backend
+    int (*start_func)(char *); // main function, started by the native backend
+    char *start_arg; // its argument
+    void *stack; // pointer to process stack
+    int stack_size; // its size in bytes
+    enum ProcState run_state; // free, ready, running, blocked or zombie; set with setState()
+    int exit_status; // status passed to quit, for join()
+    int killed; // flag set by kill_group() asking the process to quit
+    int mutexes_held; // mutexes it owns, released by mutexQuit() at quit
+    int group; // process group ID, 0 if in no group
+    struct PCB *parent; 
+    struct PCB *first_child; // pointer to its children
+    struct PCB *last_child; // pointer to its last child, for O(1) splicing
+    struct PCB *next_sibling;  // pointer to next sibling
+    struct PCB *prev_sibling; // pointer to previous sibling
+    struct PCB *group_next; // next member of the same process group
+    struct PCB *group_prev; // previous member of the same process group
+    int parked; // ready, but on a throttled group's parked list
+    struct PCB *run_queue_next; // next process on the same ready queue
+    struct PCB *run_queue_prev; // previous process on the same ready queue
+    struct PCB *wait_next; // next process on the same wait queue
+    struct WaitQueue *wait_queue; // the wait queue it is on, else NULL
+    int wait_start; // currentTime() when the process started waiting
+    int wake_tick; // clock tick a process in clockSleep() is due at
+    int tickets; // share of the CPU under POLICY_STRIDE; 0 for init
+    long long pass; // stride scheduling virtual time; lowest runs next
+    int heap_index; // position in strideHeap while ready under POLICY_STRIDE
+    void *wait_msg; // message buffer of a process blocked on a mailbox
+    int wait_size; // its message size (sender) or buffer size (receiver)
+    int wait_result; // value a blocking call returns once woken; -4 if killed
+    int quit_time; // currentTime() at quit, for the quit->reap histogram
+    int num_children; // unjoined children, live or zombie
+    long child_bytes; // stack bytes held by those children
+    long zombie_bytes; // part of child_bytes held by zombie children
+    long peak_child_bytes; // highest child_bytes so far
+    struct Region *regions[MAXREGIONS]; // copy-on-write region buffers, by ID
+    struct Task *done_tasks; // finished micro-tasks waiting for join()
+    int live_tasks; // micro-tasks created and not yet finished
+    int task_join; // blocked in join() until one of them finishes
+    struct ArenaPage *arena; // proc_alloc() pages, newest (the one in use) first
+    struct ArenaPage *arena_oldest; // last page on that list
+    int arena_pages; // number of pages on it
+    struct WaitNode *wait_nodes; // wait_any() targets while blocked in it, else NULL
+    int wait_count; // number of them
+    int wait_hit; // index of the target that woke it
+    struct WaitNode *child_watch; // wait_any() nodes watching its children
+    int yields_given; // successful yield_to() calls
+    int yields_received; // yield_to() calls that named it
+    int yields_refused; // yield_to() calls that failed
+};
+
+// FIFO of processes threaded through run_queue_next/run_queue_prev
+struct PQ {
+    struct PCB *head;
+    struct PCB *tail;
+};
+
+// FIFO of processes threaded through wait_next
+struct WaitQueue {
+    struct PCB *head;
+    struct PCB *tail;
+};
+
+// one target of a process in wait_any(), on that target's watch list; a
+// process can be on many of these lists at once, unlike wait queues
+struct WaitNode {
+    struct PCB *proc;
+    struct WaitNode *next;
+    struct WaitNode **pprev; // the pointer to this node, for O(1) unlinking
+    int id; // WAIT_CHILD: child pid or -1; WAIT_TICKS: wake-up tick
+};
+
+// one ready queue per priority level; priority p lives in queue[p-1]
+extern struct PQ queue[7];
+
+extern CPU_LOCAL struct PCB *curProcess;
+extern int processes;
+extern struct PCB pTable[MAXPROC];
+
+/*
+ * A pid is its process table slot plus MAXPROC times the slot's generation.
+ * The PID counter only grows, so every reuse of a slot has a higher
+ * generation than the last, and the pid stored in the slot tells which
+ * generation holds it now. pid_lookup() checks that in constant time and
+ * returns NULL for a stale pid; pidRequire() halts instead, for calls with
+ * no error return (main.c).
+ */
+#define PID_SLOT(pid)  ((pid) % MAXPROC)
+#define PID_GEN(pid)   ((pid) / MAXPROC)
+
+extern struct PCB *pid_lookup(int pid);
+extern struct PCB *pidRequire(char *func, int pid);
+
+/*
+ * Halts with the standard error message unless running in kernel mode
+ * (main.c).
+ */
+extern void checkKernelMode(char *func);
+
+/*
+ * Scheduling helpers (main.c).  readyProcess() appends a process to the tail
+ * of its ready queue and unreadyProcess() takes it off again;
+ * requeueProcess() puts a process taken off that way back without touching
+ * its state, for group.c's parked lists.  blockMe() parks the current
+ * process and runs the best ready one, and wakeProcess() makes a blocked
+ * process runnable again, switching to it at once if it outranks the
+ * current process.  dispatch() runs the best ready process, falling back to
+ * the idle process, and yieldCpu() lets the ready processes at the current
+ * priority or better go first.  setState() is the only place run_state
+ * changes, and keeps stateCounts (processes in the table, per state) up to
+ * date.
+ */
+extern void readyProcess(struct PCB *proc);
+extern void unreadyProcess(struct PCB *proc);
+extern void requeueProcess(struct PCB *proc);
+extern void setState(struct PCB *proc, enum ProcState state);
+extern int  stateCounts[PROC_NUM_STATES];
+extern void dispatch(void);
+extern void yieldCpu(void);
+extern void blockMe(void);
+extern void wakeProcess(struct PCB *proc);
+
+/*
+ * The idle process and clock sleepers (idle.c).  idleInit() is called from
+ * phase1_init(); the idle process runs first and switches to bootTarget.
+ */
+extern struct PCB idleProcess;
+extern struct PCB *bootTarget;
+extern void idleInit(void);
+extern void wakeSleepers(void);
+extern int  sleepersWaiting(void);
+
+/*
+ * Terminal output (term.c). termInit() is called from phase1_init();
+ * termWakeWriters() readies the writers that can go on.
+ */
+extern void termInit(void);
+extern void termWakeWriters(void);
+extern int  termWaiting(void);
+extern int  termBusy(void);
+
+/*
+ * Interrupt handlers do not wake processes themselves, since they can
+ * interrupt a queue update. They set wakePending, and the next kernel entry
+ * (checkKernelMode()) or dispatch wakes whoever is due (main.c).
+ */
+extern volatile int wakePending;
+
+/*
+ * Stride scheduling (stride.c).  Under POLICY_STRIDE, enqueueing a ready
+ * process at priority 1-5 puts it in strideHeap; the dispatcher charges the
+ * outgoing process with strideCharge() and tells strideDispatched() who runs
+ * next.  The clock handler sets reschedPending, which checkKernelMode() acts
+ * on.
+ */
+extern int schedPolicy;
+extern struct PCB *strideHeap[MAXPROC];
+extern int strideCount;
+extern volatile int reschedPending;
+extern void strideInit(void);
+extern void strideInsert(struct PCB *proc);
+extern void strideRemove(struct PCB *proc);
+extern struct PCB *strideMin(void);
+extern void strideCharge(struct PCB *proc);
+extern void strideDispatched(struct PCB *proc);
+
+/*
+ * Micro-tasks (task.c). taskInit() is called from phase1_init(). join()
+ * collects finished tasks with taskReap(), and quit_phase_1a() hands the
+ * tasks of a quitting process to init with taskAdopt(). The runners live
+ * outside the process table, like the idle process.
+ */
+extern void taskInit(void);
+extern int  taskReap(struct PCB *proc, int *status);
+extern void taskAdopt(struct PCB *proc, struct PCB *to);
+extern int  taskRunnersReady(void);
+
+/*
+ * Per-process arenas (arena.c). arenaInit() is called from phase1_init(),
+ * and reapChild() gives a process's pages back with arenaRelease().
+ */
+extern int  arenaPagesInUse;
+extern void arenaInit(void);
+extern void arenaRelease(struct PCB *proc);
+
+/*
+ * The kernel heap (kheap.c). Process stacks and every other kernel buffer
+ * come from kernelAlloc(), so that checkpoints (checkpoint.c) can save them.
+ * kheapInit() is called first in phase1_init(). kheapFixed is 0 when the
+ * heap is malloc(): checkpoints were not asked for, or the heap's fixed
+ * address was taken. Each block starts with a KHEAP_HEADER-byte header, so
+ * a request that is a size class less the header fills its block exactly.
+ */
+#define KHEAP_HEADER  16
+
+extern int   kheapFixed;
+extern void  kheapInit(void);
+extern int   kheapReserve(char *at, unsigned long size);
+extern unsigned long kheapRange(char **base);
+extern unsigned long kheapSize(void);
+extern void *kernelAlloc(unsigned long size);
+extern void  kernelFree(void *mem);
+extern void *kernelRealloc(void *mem, unsigned long size);
+
+/*
+ * Multi-core host runs (smp.c). While smpActive is set, readyProcess() hands
+ * new processes to smpPush() instead of the ready queues, and a process
+ * gives up its CPU with smpSwitchOut(), to yield (SMP_YIELD) or for good
+ * (SMP_QUIT). smpActive is always 0 in builds without HOST_SMP.
+ */
+#define SMP_YIELD  0
+#define SMP_QUIT   1
+
+extern volatile int smpActive;
+extern void smpPush(struct PCB *proc);
+extern void smpSwitchOut(int reason);
+
+/*
+ * Unlinks and frees a terminated child (main.c).
+ */
+extern void reapChild(struct PCB *child);
+
+/*
+ * Process group membership (group.c).  groupAdd() does nothing for group 0.
+ */
+extern void groupAdd(struct PCB *proc, int gid);
+extern void groupRemove(struct PCB *proc);
+extern void groupInit(void);
+
+/*
+ * Group CPU quotas (group.c).  Every switch and clock tick charges the
+ * outgoing or running process's group with quotaCharge(); quotaUpdate(), run
+ * with the other wake-ups, throttles and releases groups.  While a group is
+ * throttled, enqueueReady() hands its members to groupPark() and
+ * dequeueReady() takes them back with groupUnpark().
+ */
+extern void quotaCharge(struct PCB *proc);
+extern void quotaUpdate(void);
+extern int  quotaWaiting(void);
+extern int  quotaActive(void);
+extern int  groupThrottled(int gid);
+extern void groupPark(struct PCB *proc);
+extern void groupUnpark(struct PCB *proc);
+extern int  groupParked(void);
+
+/*
+ * Wait queue helpers (main.c).
+ */
+extern void waitQueueAppend(struct WaitQueue *wq, struct PCB *proc);
+extern struct PCB *waitQueuePop(struct WaitQueue *wq);
+extern int  cancelWait(struct PCB *proc);
+extern void preemptIfOutranked(void);
+
+/*
+ * wait_any() watch lists (waitany.c). A target's owner calls watchWake()
+ * when it becomes ready: each process watching it is unlinked from all its
+ * lists and readied, and with 'preempt' the best of them runs at once if it
+ * outranks the caller. quit_phase_1a() calls waitAnyChildQuit(), and
+ * cancelWait() calls waitAnyCancel() to unlink a killed process.
+ * mboxWatch() (mbox.c) and tickWatch() (idle.c) register mailbox and timer
+ * targets.
+ */
+extern void watchAdd(struct WaitNode **list, struct WaitNode *node);
+extern void watchFire(struct WaitNode *node);
+extern void watchWake(struct WaitNode **list, int preempt);
+extern void waitAnyChildQuit(struct PCB *child);
+extern void waitAnyCancel(struct PCB *proc);
+extern int  mboxWatch(int mbox, struct WaitNode *node);
+extern void tickWatch(struct WaitNode *node, int ticks);
+
+/*
+ * Mailbox setup (mbox.c), called from phase1_init().
+ */
+extern void mboxInit(void);
+
+/*
+ * Syscall table setup (syscall.c), called from phase1_init().
+ */
+extern void syscallInit(void);
+
+/*
+ * Context creation and switching through the per-process backend (switch.c).
+ * switchInit() is called from phase1_init().
+ */
+extern void contextInit(struct PCB *proc, int (*func)(char *), char *arg, int stackSize);
+extern void contextSwitch(struct PCB *from, struct PCB *to);
+extern void switchInit(void);
+extern int  switchBackend;
+
+/*
+ * Stack accounting and limits (memory.c). memAdmit() checks the limits for
+ * a spork(); the others track a stack from spork() through quit to reap.
+ */
+extern int  memAdmit(struct PCB *parent, int stackSize);
+extern void memCharge(struct PCB *proc);
+extern void memZombie(struct PCB *proc);
+extern void memRelease(struct PCB *proc);
+extern void memMove(struct PCB *child, struct PCB *to);
+extern void memInit(void);
+extern long stackBytes;
+extern long zombieBytes;
+
+/*
+ * Kernel mutexes (sync.c). mutexQuit() runs at quit and passes on any
+ * mutex the process still holds.
+ */
+extern void mutexQuit(struct PCB *proc);
+
+/*
+ * Copy-on-write regions (region.c). regionRelease() runs at quit.
+ */
+extern long regionBytes;
+extern void regionShare(struct PCB *parent, struct PCB *child);
+extern void regionRelease(struct PCB *proc);
+extern long regionAttachedBytes(struct PCB *proc);
+
+/*
+ * Scheduling record/replay (replay.c). checkKernelMode() counts kernel
+ * entries, logs the ticks a recording has counted with schedLogInterrupts()
+ * and raises replayed interrupts; every switch goes through schedDecision()
+ * unless schedMode is SCHED_LIVE.
+ */
+extern int PID;
+extern unsigned int kernelEntries;
+extern int schedMode;
+extern struct PCB *schedDecision(struct PCB *next, int chosen);
+extern void schedReplayInterrupts(void);
+extern void schedLogInterrupts(void);
+
+/*
+ * Latency histogram hooks (latency.c). They compile to nothing unless the
+ * kernel is built with -DLATENCY_HIST.
+ */
+extern void latencyInit(void);
+
+#ifdef LATENCY_HIST
+#define LAT_START(var)          int var = currentTime()
+#define LAT_RECORD(which, var)  latencyRecord(which, currentTime() - (var))
+#else
+#define LAT_START(var)
+#define LAT_RECORD(which, var)
+#endif
+
+#endif /* _KERNEL_H */
@@ -0,0 +1,210 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include "kernel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+/*
+ * The kernel heap. Everything the kernel allocates for processes (stacks,
+ * arena pages, region buffers, the profiler's and the schedule log's
+ * buffers) comes from here, so that a checkpoint (checkpoint.c) can save it
+ * and a restore can map it back at the same address. The heap is a
+ * KHEAP_SIZE reservation at KHEAP_BASE, paged in as it is touched. Blocks
+ * come in size classes of 2^k and 1.5 * 2^k bytes, so that no more than a
+ * third of a block is ever wasted, each with a free list, and are carved
+ * from the front of the reservation when their list is empty; a 16-byte
+ * header holds the class. The reservation is only made when checkpoints
+ * are asked for (USLOSS_HOST_CHECKPOINT or USLOSS_HOST_RESTORE set);
+ * otherwise, or if the address cannot be had, the heap is malloc() and
+ * checkpoints are not available.
+ */
+
+#define KHEAP_BASE      ((char *) 0x200000000000UL)
+#define KHEAP_SIZE      (1UL << 32)
+#define KHEAP_MINCLASS  6
+#define KHEAP_CLASSES   53
+
+// bytes in a block of class c, header included: 2^6, 1.5 * 2^6, 2^7, ...
+#define CLASS_BYTES(c)  ((((c) & 1) ? 3UL : 2UL) << (KHEAP_MINCLASS - 1 + (c) / 2))
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+struct KFree {
+    struct KFree *next;
+};
+
+// 1 if the heap is at KHEAP_BASE, 0 if it is malloc()
+int kheapFixed;
+
+// first byte never handed out
+static char *heapNext;
+
+// free blocks of each class
+static struct KFree *freeLists[KHEAP_CLASSES];
+
+#ifdef HOST_SMP
+static volatile char heapLock;
+#define HEAP_LOCK()    while (__atomic_test_and_set(&heapLock, __ATOMIC_ACQUIRE)) { }
+#define HEAP_UNLOCK()  __atomic_clear(&heapLock, __ATOMIC_RELEASE)
+#else
+#define HEAP_LOCK()
+#define HEAP_UNLOCK()
+#endif
+
+/*
+ * Function: kheapReserve
+ * ----------------------
+ * This function maps 'size' bytes of anonymous memory at exactly 'at',
+ * without replacing anything already mapped there.
+ *
+ * @return int -1: returned if the range is not free
+ *
+ * @return int 0: success
+ */
+int kheapReserve(char *at, unsigned long size) {
+    void *p = mmap(at, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE, -1, 0);
+
+    if (p == MAP_FAILED) {
+        return -1;
+    }
+    if (p != at) {
+        // an old kernel took the address as a hint only
+        munmap(p, size);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Function: kheapInit
+ * -------------------
+ * This function reserves the heap if checkpoints are wanted; called first
+ * thing in phase1_init().
+ */
+void kheapInit(void) {
+    memset(freeLists, 0, sizeof(freeLists));
+    heapNext = KHEAP_BASE;
+    if (!kheapFixed && (getenv("USLOSS_HOST_CHECKPOINT") != NULL || getenv("USLOSS_HOST_RESTORE") != NULL)) {
+        kheapFixed = kheapReserve(KHEAP_BASE, KHEAP_SIZE) == 0;
+    }
+}
+
+/*
+ * Function: kheapRange
+ * --------------------
+ * This function reports the part of the heap that has been handed out so
+ * far, for checkpoints.
+ *
+ * @param char **base: out-pointer for the start of the heap
+ *
+ * @return unsigned long: bytes from base that have ever been allocated
+ */
+unsigned long kheapRange(char **base) {
+    *base = KHEAP_BASE;
+    return heapNext - KHEAP_BASE;
+}
+
+unsigned long kheapSize(void) {
+    return KHEAP_SIZE;
+}
+
+/*
+ * Function: kernelAlloc
+ * ---------------------
+ * This function allocates 'size' bytes from the kernel heap, aligned to 16
+ * bytes and not zeroed.
+ *
+ * @return void *: the memory, or NULL if the heap is exhausted
+ */
+void *kernelAlloc(unsigned long size) {
+    int cls = 0;
+    char *block;
+
+    if (!kheapFixed) {
+        return malloc(size);
+    }
+    while (cls < KHEAP_CLASSES && CLASS_BYTES(cls) < size + KHEAP_HEADER) {
+        cls++;
+    }
+    if (cls == KHEAP_CLASSES) {
+        return NULL;
+    }
+
+    HEAP_LOCK();
+    if (freeLists[cls] != NULL) {
+        block = (char *) freeLists[cls];
+        freeLists[cls] = freeLists[cls]->next;
+    }
+    else if (heapNext + CLASS_BYTES(cls) <= KHEAP_BASE + KHEAP_SIZE) {
+        block = heapNext;
+        heapNext += CLASS_BYTES(cls);
+    }
+    else {
+        block = NULL;
+    }
+    HEAP_UNLOCK();
+
+    if (block == NULL) {
+        return NULL;
+    }
+    *(int *) block = cls;
+    return block + KHEAP_HEADER;
+}
+
+/*
+ * Function: kernelFree
+ * --------------------
+ * This function returns a block from kernelAlloc() to its class's free
+ * list. NULL is ignored.
+ */
+void kernelFree(void *mem) {
+    if (!kheapFixed) {
+        free(mem);
+        return;
+    }
+    if (mem == NULL) {
+        return;
+    }
+    char *block = (char *) mem - KHEAP_HEADER;
+    struct KFree *f = (struct KFree *) block;
+    int cls = *(int *) block;
+
+    HEAP_LOCK();
+    f->next = freeLists[cls];
+    freeLists[cls] = f;
+    HEAP_UNLOCK();
+}
+
+/*
+ * Function: kernelRealloc
+ * -----------------------
+ * This function is realloc() for the kernel heap. The block is only moved
+ * when the new size does not fit its class.
+ *
+ * @return void *: the memory, or NULL (leaving mem alone) if the heap is
+ *                 exhausted
+ */
+void *kernelRealloc(void *mem, unsigned long size) {
+    if (!kheapFixed) {
+        return realloc(mem, size);
+    }
+    if (mem == NULL) {
+        return kernelAlloc(size);
+    }
+
+    unsigned long room = CLASS_BYTES(*(int *) ((char *) mem - KHEAP_HEADER)) - KHEAP_HEADER;
+    if (size <= room) {
+        return mem;
+    }
+    void *bigger = kernelAlloc(size);
+    if (bigger != NULL) {
+        memcpy(bigger, mem, room);
+        kernelFree(mem);
+    }
+    return bigger;
+}
@@ -0,0 +1,184 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include "kernel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Latency histograms. Each histogram is a fixed array of log-linear buckets
+ * in the style of HdrHistogram: values below 16 us get a bucket each, and
+ * every power of two above that is split into 8 buckets, so a reported value
+ * is never more than 12.5% above the true one. Recording is a couple of
+ * shifts and an increment, and nothing is allocated.
+ *
+ * The kernel records into these only when built with -DLATENCY_HIST (see
+ * LAT_START/LAT_RECORD in kernel.h); otherwise the hooks compile to nothing
+ * and only latencyRecord() calls from outside the kernel add samples.
+ */
+
+#define LAT_LINEAR   16 // values recorded exactly
+#define LAT_SUB_BITS 3 // log2 of the buckets per power of two
+#define LAT_BUCKETS  (LAT_LINEAR + (31 - 4) * (1 << LAT_SUB_BITS))
+
+struct LatencyHist {
+    int counts[LAT_BUCKETS];
+    int total; // samples recorded
+    int max; // largest sample, exact
+};
+
+static struct LatencyHist latHists[LAT_NUM];
+
+static char *latNames[LAT_NUM] = { "spork", "join", "switch", "quit->reap" };
+
+/*
+ * Function: bucketOf
+ * ------------------
+ * This function maps a latency in microseconds to its bucket.
+ */
+static int bucketOf(int us) {
+    if (us < LAT_LINEAR) {
+        return us;
+    }
+    int exp = 31 - __builtin_clz(us); // at least 4
+    int sub = (us >> (exp - LAT_SUB_BITS)) & ((1 << LAT_SUB_BITS) - 1);
+    return LAT_LINEAR + ((exp - 4) << LAT_SUB_BITS) + sub;
+}
+
+/*
+ * Function: bucketHigh
+ * --------------------
+ * This function returns the largest latency that falls into a bucket.
+ */
+static int bucketHigh(int bucket) {
+    if (bucket < LAT_LINEAR) {
+        return bucket;
+    }
+    int exp = (bucket - LAT_LINEAR) / (1 << LAT_SUB_BITS) + 4;
+    long long sub = (bucket - LAT_LINEAR) % (1 << LAT_SUB_BITS);
+    return (int) ((((1 << LAT_SUB_BITS) + sub + 1) << (exp - LAT_SUB_BITS)) - 1);
+}
+
+/*
+ * Function: latencyRecord
+ * -----------------------
+ * This function adds one sample to a histogram. Negative values count as 0.
+ *
+ * @param int which: LAT_SPORK, LAT_JOIN, LAT_SWITCH or LAT_REAP
+ *
+ * @param int us: latency in microseconds
+ */
+void latencyRecord(int which, int us) {
+    if (which < 0 || which >= LAT_NUM) {
+        return;
+    }
+    if (us < 0) {
+        us = 0;
+    }
+
+    struct LatencyHist *h = &latHists[which];
+    h->counts[bucketOf(us)]++;
+    h->total++;
+    if (us > h->max) {
+        h->max = us;
+    }
+}
+
+/*
+ * Function: latencyPercentile
+ * ---------------------------
+ * This function reports a percentile of a histogram: the highest latency in
+ * the bucket holding that rank, capped at the exact maximum.
+ *
+ * @param int which: LAT_SPORK, LAT_JOIN, LAT_SWITCH or LAT_REAP
+ *
+ * @param int pct: percentile, 0-100; 100 gives the maximum
+ *
+ * @return int -1: returned if which or pct is out of range or the histogram
+ *                 is empty
+ *
+ * @return int >=0: latency in microseconds
+ */
+int latencyPercentile(int which, int pct) {
+    int i, seen = 0;
+
+    if (which < 0 || which >= LAT_NUM || pct < 0 || pct > 100 || latHists[which].total == 0) {
+        return -1;
+    }
+
+    struct LatencyHist *h = &latHists[which];
+    long long rank = ((long long) h->total * pct + 99) / 100;
+    if (rank < 1) {
+        rank = 1;
+    }
+    for (i = 0; i < LAT_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            break;
+        }
+    }
+    int high = bucketHigh(i);
+    return high < h->max ? high : h->max;
+}
+
+/*
+ * Function: latencyCount
+ * ----------------------
+ * This function reports how many samples a histogram holds.
+ *
+ * @return int -1: returned if which is out of range
+ *
+ * @return int >=0: number of samples
+ */
+int latencyCount(int which) {
+    if (which < 0 || which >= LAT_NUM) {
+        return -1;
+    }
+    return latHists[which].total;
+}
+
+/*
+ * Function: latencyReset
+ * ----------------------
+ * This function empties every histogram.
+ */
+void latencyReset(void) {
+    memset(latHists, 0, sizeof(latHists));
+}
+
+/*
+ * Function: dumpLatency
+ * ---------------------
+ * This function prints the sample count, p50, p90, p99 and maximum of each
+ * histogram that has samples.
+ */
+void dumpLatency(void) {
+    int i;
+
+    USLOSS_Console("%-11s %9s %7s %7s %7s %7s  (us)\n", "LATENCY", "COUNT", "P50", "P90", "P99", "MAX");
+    for (i = 0; i < LAT_NUM; i++) {
+        if (latHists[i].total == 0) {
+            continue;
+        }
+        USLOSS_Console("%-11s %9d %7d %7d %7d %7d\n", latNames[i], latHists[i].total,
+                       latencyPercentile(i, 50), latencyPercentile(i, 90),
+                       latencyPercentile(i, 99), latHists[i].max);
+    }
+}
+
+/*
+ * Function: latencyInit
+ * ---------------------
+ * This function clears the histograms. In LATENCY_HIST builds it also
+ * arranges for dumpLatency() to run when the simulation halts.
+ */
+void latencyInit(void) {
+    latencyReset();
+#ifdef LATENCY_HIST
+    static int registered = 0;
+    if (!registered) {
+        atexit(dumpLatency);
+        registered = 1;
+    }
+#endif
+}
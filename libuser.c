@@ -0,0 +1,82 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * User-mode wrappers around the system call table. Each one packs its
+ * arguments into a USLOSS_Sysargs, traps with USLOSS_Syscall(), and returns
+ * what the kernel left in arg1.
+ */
+
+static void *doSyscall(int number, void *arg1, void *arg2, void *arg3, void *arg4, void *arg5) {
+    USLOSS_Sysargs args;
+
+    args.number = number;
+    args.arg1 = arg1;
+    args.arg2 = arg2;
+    args.arg3 = arg3;
+    args.arg4 = arg4;
+    args.arg5 = arg5;
+    USLOSS_Syscall(&args);
+    return args.arg1;
+}
+
+int Sys_Spork(char *name, int(*func)(char *), char *arg, int stacksize, int priority) {
+    return (int) (long) doSyscall(SYS_SPORK, name, (void *) func, arg,
+                                  (void *) (long) stacksize, (void *) (long) priority);
+}
+
+int Sys_Join(int *status) {
+    return (int) (long) doSyscall(SYS_JOIN, status, NULL, NULL, NULL, NULL);
+}
+
+void Sys_Quit(int status, int switchToPid) {
+    doSyscall(SYS_QUIT_PHASE_1A, (void *) (long) status, (void *) (long) switchToPid, NULL, NULL, NULL);
+    USLOSS_Console("ERROR: Sys_Quit() returned.\n");
+    USLOSS_Halt(1);
+}
+
+int Sys_GetPid(void) {
+    return (int) (long) doSyscall(SYS_GETPID, NULL, NULL, NULL, NULL, NULL);
+}
+
+void Sys_DumpProcesses(void) {
+    doSyscall(SYS_DUMPPROCESSES, NULL, NULL, NULL, NULL, NULL);
+}
+
+int Sys_SemCreate(int value) {
+    return (int) (long) doSyscall(SYS_SEMCREATE, (void *) (long) value, NULL, NULL, NULL, NULL);
+}
+
+int Sys_SemP(int sem) {
+    return (int) (long) doSyscall(SYS_SEMP, (void *) (long) sem, NULL, NULL, NULL, NULL);
+}
+
+int Sys_SemV(int sem) {
+    return (int) (long) doSyscall(SYS_SEMV, (void *) (long) sem, NULL, NULL, NULL, NULL);
+}
+
+int Sys_SemFree(int sem) {
+    return (int) (long) doSyscall(SYS_SEMFREE, (void *) (long) sem, NULL, NULL, NULL, NULL);
+}
+
+int Sys_MboxCreate(int numSlots, int slotSize) {
+    return (int) (long) doSyscall(SYS_MBOXCREATE, (void *) (long) numSlots, (void *) (long) slotSize,
+                                  NULL, NULL, NULL);
+}
+
+int Sys_MboxRelease(int mbox) {
+    return (int) (long) doSyscall(SYS_MBOXRELEASE, (void *) (long) mbox, NULL, NULL, NULL, NULL);
+}
+
+int Sys_MboxSend(int mbox, void *msg, int msgSize) {
+    return (int) (long) doSyscall(SYS_MBOXSEND, (void *) (long) mbox, msg, (void *) (long) msgSize,
+                                  NULL, NULL);
+}
+
+int Sys_MboxRecv(int mbox, void *msg, int maxMsgSize) {
+    return (int) (long) doSyscall(SYS_MBOXRECV, (void *) (long) mbox, msg, (void *) (long) maxMsgSize,
+                                  NULL, NULL);
+}
@@ -1,34 +1,16 @@
 #include "phase1helper.h"
 #include "phase1.h"
+#include "kernel.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
-
-struct PCB {
-    char name[MAXNAME+1]; // name of process
-    int pid; // process ID 
-    int priority; // priority 
-    USLOSS_Context state;
-    void *stack; // pointer to process stack
-    int status; // process status: running, ready, or blocked
-    int hasExited; // flag to check if process has terminated
-    int used; // flag to check if process in use
-    struct PCB *parent; 
-    struct PCB *first_child; // pointer to its children
-    struct PCB *next_sibling;  // pointer to next sibling
-};
-
-//backbone for subsequent priority queue
-struct PQ {
-    struct PCB *process;
-    struct PQ *run_queue_next;
-};
+#include <stddef.h>
 
 // priority queue
-struct PQ *queue[7];
+struct PQ queue[7];
 
-// current process running
-struct PCB *curProcess;
+// current process running; one per CPU in HOST_SMP builds
+CPU_LOCAL struct PCB *curProcess;
 
 // number of processes in process table
 int processes = 1;
@@ -39,6 +21,95 @@ struct PCB pTable[MAXPROC];
 // increments PID value every time new process is created
 int PID = 2;
 
+// processes in the table in each state; the idle process is not counted
+int stateCounts[PROC_NUM_STATES];
+
+#ifndef NDEBUG
+// legalTransition[from][to] is 1 if setState() may move a process from one
+// state to the other
+static const char legalTransition[PROC_NUM_STATES][PROC_NUM_STATES] = {
+    //              FREE READY RUNNING BLOCKED ZOMBIE
+    /* FREE    */ {  0,   1,    0,      0,      0 },  // spork()
+    /* READY   */ {  0,   0,    1,      0,      0 },  // dispatched
+    /* RUNNING */ {  0,   1,    0,      1,      1 },  // switched away, blocked, quit
+    /* BLOCKED */ {  0,   1,    0,      0,      0 },  // woken
+    /* ZOMBIE  */ {  1,   0,    0,      0,      0 },  // joined
+};
+
+static const char *stateNames[PROC_NUM_STATES] = {
+    "free", "ready", "running", "blocked", "zombie"
+};
+#endif
+
+// POLICY_PRIORITY or POLICY_STRIDE; see stride.c
+int schedPolicy = POLICY_PRIORITY;
+
+// what quit_phase_1a() does with the children of a quitting process
+int orphanPolicy = ORPHANS_HALT;
+
+// set by interrupt handlers when a sleeping or waiting process may be due
+volatile int wakePending;
+
+#ifdef LATENCY_HIST
+// currentTime() when the last context switch began
+int switchStartTime;
+#endif
+
+static struct PCB *bestReady(void);
+static void switchProcess(struct PCB *next, int chosen);
+
+/*
+ * Function: wakeWaiters
+ * ---------------------
+ * This function readies every process an interrupt has made due: clock
+ * sleepers and terminal writers. It also throttles and releases groups with
+ * a CPU quota (group.c). It does not switch.
+ */
+static void wakeWaiters(void) {
+    wakePending = 0;
+    wakeSleepers();
+    termWakeWriters();
+    quotaUpdate();
+}
+
+/*
+ * Function: checkKernelMode
+ * -------------------------
+ * This function halts the simulation if the caller is running in user mode.
+ * Every kernel entry point calls it first.
+ * 
+ * @param char *func: name of the kernel function being called
+ */
+void checkKernelMode(char *func) {
+    if ((USLOSS_PsrGet() & USLOSS_PSR_CURRENT_MODE) == 0) {
+        USLOSS_Console("ERROR: Someone attempted to call %s while in user mode!\n", func);
+        USLOSS_Halt(1);
+    }
+
+    // kernel entries are the clock that replayed interrupts are placed by;
+    // a recording logs the ticks since the last entry before counting it
+    if (schedMode == SCHED_RECORD) {
+        schedLogInterrupts();
+    }
+    kernelEntries++;
+    if (schedMode == SCHED_REPLAY) {
+        schedReplayInterrupts();
+    }
+
+    // and where processes woken by an interrupt get to run, if they
+    // outrank the current one
+    if (wakePending && curProcess != NULL && !smpActive) {
+        wakeWaiters();
+        preemptIfOutranked();
+    }
+
+    // kernel entries are also where a clock tick's reschedule takes effect
+    if (reschedPending && curProcess != NULL) {
+        reschedPending = 0;
+        dispatch();
+    }
+}
+
 /*
  * Function: phase1_init
  * ---------------------
@@ -46,16 +117,31 @@ int PID = 2;
  * and init process. It has no parameters does not return.
  */
 void phase1_init(void) {
-    if ((USLOSS_PsrGet() & USLOSS_PSR_CURRENT_MODE) == 0) {
-        USLOSS_Console("ERROR: Someone attempted to call phase1_init while in user mode!\n");
-        USLOSS_Halt(1);
-    }
+    checkKernelMode("phase1_init");
 
     // intitilizes table and queue
     memset(pTable, 0, sizeof(pTable));
     memset(queue, 0, sizeof(queue));
+    memset(stateCounts, 0, sizeof(stateCounts));
+    stateCounts[PROC_FREE] = MAXPROC;
 
     curProcess = NULL;
+    wakePending = 0;
+    orphanPolicy = ORPHANS_HALT;
+    schedPolicy = POLICY_PRIORITY;
+
+    kheapInit();
+    mboxInit();
+    syscallInit();
+    groupInit();
+    switchInit();
+    latencyInit();
+    memInit();
+    idleInit();
+    strideInit();
+    termInit();
+    taskInit();
+    arenaInit();
 
     struct PCB *initProcess = &pTable[1];
     
@@ -63,44 +149,692 @@ void phase1_init(void) {
     strcpy(initProcess->name, "init"); 
     initProcess->pid = 1;                     
     initProcess->priority = 6; 
-    initProcess->status = 0;
-    initProcess->hasExited = 0;
     initProcess->parent = NULL;
     initProcess->first_child = NULL;
     initProcess->next_sibling = NULL;
-    initProcess->used = 1;
-    initProcess->stack = (char *) malloc(USLOSS_MIN_STACK);
+    initProcess->stack = kernelAlloc(USLOSS_MIN_STACK);
+    initProcess->stack_size = USLOSS_MIN_STACK;
+    memCharge(initProcess);
 
-    russ_ContextInit(initProcess->pid, &initProcess->state, initProcess->stack, USLOSS_MIN_STACK, init_main, initProcess->name);
+    contextInit(initProcess, init_main, initProcess->name, USLOSS_MIN_STACK);
+    readyProcess(initProcess);
 }
 
 /*
- * Function: TEMP_switchTo
+ * Function: setState
+ * ------------------
+ * This function moves a process to a new state and updates the per-state
+ * counts. Unless built with NDEBUG, it halts if the kernel's state machine
+ * does not allow the move.
+ * 
+ * @param struct PCB *proc: process whose state changes
+ * 
+ * @param enum ProcState state: its new state
+ */
+void setState(struct PCB *proc, enum ProcState state) {
+#ifndef NDEBUG
+    if (!legalTransition[proc->run_state][state]) {
+        USLOSS_Console("ERROR: Process pid %d cannot go from %s to %s.\n", proc->pid,
+                       stateNames[proc->run_state], stateNames[state]);
+        USLOSS_Halt(1);
+    }
+#endif
+    // the idle process and the task runners, outside the table, have pid 0
+    if (proc->pid != 0) {
+        ATOMIC_ADD(stateCounts[proc->run_state], -1);
+        ATOMIC_ADD(stateCounts[state], 1);
+    }
+
+    // a release store: a parent on another CPU that sees PROC_ZOMBIE also
+    // sees the exit status, and that the child is off its stack
+    ATOMIC_STORE(proc->run_state, state);
+}
+
+/*
+ * Function: processCount
+ * ----------------------
+ * This function returns how many process table slots are in a state. It
+ * takes constant time.
+ * 
+ * @param int state: one of the PROC_ states
+ * 
+ * @return int -1: returned if state is out of range
+ * 
+ * @return int >=0: number of processes in that state
+ */
+int processCount(int state) {
+    if (state < 0 || state >= PROC_NUM_STATES) {
+        return -1;
+    }
+    return stateCounts[state];
+}
+
+/*
+ * Function: enqueueReady
+ * ----------------------
+ * This function puts a process at the tail of the ready queue for its
+ * priority or, under POLICY_STRIDE, into the stride heap. A member of a
+ * throttled group goes on its group's parked list instead.
+ */
+static void enqueueReady(struct PCB *proc) {
+    struct PQ *pq = &queue[proc->priority - 1];
+
+    if (groupThrottled(proc->group)) {
+        groupPark(proc);
+        return;
+    }
+    if (schedPolicy == POLICY_STRIDE && proc->priority <= 5) {
+        strideInsert(proc);
+        return;
+    }
+    proc->run_queue_next = NULL;
+    proc->run_queue_prev = pq->tail;
+    if (pq->tail == NULL) {
+        pq->head = proc;
+    }
+    else {
+        pq->tail->run_queue_next = proc;
+    }
+    pq->tail = proc;
+}
+
+/*
+ * Function: dequeueReady
+ * ----------------------
+ * This function undoes enqueueReady().
+ */
+static void dequeueReady(struct PCB *proc) {
+    struct PQ *pq = &queue[proc->priority - 1];
+
+    if (proc->parked) {
+        groupUnpark(proc);
+        return;
+    }
+    if (schedPolicy == POLICY_STRIDE && proc->priority <= 5) {
+        strideRemove(proc);
+        return;
+    }
+    if (proc->run_queue_prev == NULL) {
+        pq->head = proc->run_queue_next;
+    }
+    else {
+        proc->run_queue_prev->run_queue_next = proc->run_queue_next;
+    }
+    if (proc->run_queue_next == NULL) {
+        pq->tail = proc->run_queue_prev;
+    }
+    else {
+        proc->run_queue_next->run_queue_prev = proc->run_queue_prev;
+    }
+    proc->run_queue_next = NULL;
+    proc->run_queue_prev = NULL;
+}
+
+/*
+ * Function: readyProcess
+ * ----------------------
+ * This function appends a process to the tail of the ready queue for its
+ * priority (or adds it to the stride heap, or during smpRun() pushes it on
+ * the current CPU's deque).
+ * 
+ * @param struct PCB *proc: process that is now runnable
+ */
+void readyProcess(struct PCB *proc) {
+    setState(proc, PROC_READY);
+    if (smpActive) {
+        smpPush(proc);
+        return;
+    }
+    enqueueReady(proc);
+}
+
+/*
+ * Function: requeueProcess
+ * ------------------------
+ * This function puts a ready process that unreadyProcess() took off its
+ * queue back on one, without changing its state; group.c uses it to move
+ * processes between the ready queues and a group's parked list.
+ *
+ * @param struct PCB *proc: process in PROC_READY
+ */
+void requeueProcess(struct PCB *proc) {
+    enqueueReady(proc);
+}
+
+/*
+ * Function: unreadyProcess
+ * ------------------------
+ * This function takes a process off its ready queue, if it is on one. The
+ * caller sets its new state.
+ * 
+ * @param struct PCB *proc: process that is about to run
+ */
+void unreadyProcess(struct PCB *proc) {
+    if (proc->run_state == PROC_READY) {
+        dequeueReady(proc);
+    }
+}
+
+/*
+ * Function: bestReady
+ * -------------------
+ * This function returns the ready process the dispatcher would pick at
+ * priority 1-5: the head of the first non-empty queue, or under
+ * POLICY_STRIDE the process with the lowest pass. NULL if there is none.
+ */
+static struct PCB *bestReady(void) {
+    int i;
+
+    if (schedPolicy == POLICY_STRIDE) {
+        return strideMin();
+    }
+    for (i = 0; i < 5; i++) {
+        if (queue[i].head != NULL) {
+            return queue[i].head;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Function: setSchedPolicy
+ * ------------------------
+ * This function chooses how the dispatcher picks among processes at
+ * priority 1-5: strictly by priority (POLICY_PRIORITY, the default) or in
+ * proportion to their tickets (POLICY_STRIDE, see setTickets()). Ready
+ * processes are moved over at once. Init and the idle process are not
+ * affected.
+ * 
+ * @param int policy: POLICY_PRIORITY or POLICY_STRIDE
+ * 
+ * @return int -1: returned if policy is not one of the above
+ * 
+ * @return int >=0: the previous policy
+ */
+int setSchedPolicy(int policy) {
+    checkKernelMode("setSchedPolicy");
+
+    int i, old = schedPolicy;
+
+    if (policy != POLICY_PRIORITY && policy != POLICY_STRIDE) {
+        return -1;
+    }
+    for (i = 0; i < MAXPROC; i++) {
+        if (pTable[i].run_state == PROC_READY) {
+            dequeueReady(&pTable[i]);
+        }
+    }
+    schedPolicy = policy;
+    for (i = 0; i < MAXPROC; i++) {
+        if (pTable[i].run_state == PROC_READY) {
+            enqueueReady(&pTable[i]);
+        }
+    }
+    if (policy == POLICY_STRIDE) {
+        strideDispatched(curProcess);
+    }
+    return old;
+}
+
+/*
+ * Function: switchProcess
  * -----------------------
- * This function performs context switches from one process to another, saving
- * the old process's state.
+ * This function makes 'next' the running process. The outgoing process goes
+ * back on its ready queue unless it has exited or blocked.
  * 
- * @param int pid: process ID
+ * @param struct PCB *next: process to run
+ * 
+ * @param int chosen: 1 if the dispatcher picked 'next', 0 if the caller named
+ *                    it; only the former may be overridden by a replay
  */
-void TEMP_switchTo(int pid) {
-    if ((USLOSS_PsrGet() & USLOSS_PSR_CURRENT_MODE) == 0) {
-        USLOSS_Console("ERROR: Someone attempted to call TEMP_switchTo while in user mode!\n");
+static void switchProcess(struct PCB *next, int chosen) {
+    if (next == curProcess) {
+        return;
+    }
+    if (smpActive) {
+        USLOSS_Console("ERROR: Process pid %d tried to block or switch processes during smpRun().\n", getpid());
         USLOSS_Halt(1);
     }
+    if (schedMode != SCHED_LIVE) {
+        next = schedDecision(next, chosen);
+    }
+
+    if (curProcess == NULL) {
+        // the idle process runs first and hands the CPU to 'next' (idle.c)
+        bootTarget = next;
+        next = &idleProcess;
+    }
 
-    // finds the slot where the new prcoess being context switched to is 
-    int slot = pid % MAXPROC;
+    unreadyProcess(next);
+    setState(next, PROC_RUNNING);
 
     if (curProcess == NULL) {
-        curProcess = &pTable[slot];
-        USLOSS_ContextSwitch(NULL, &pTable[slot].state);
+        curProcess = next;
+        contextSwitch(NULL, next);
     } else {
         struct PCB *oldProc = curProcess;
-        curProcess = &pTable[slot];
-        USLOSS_ContextSwitch(&oldProc->state, &pTable[slot].state);
+        if (schedPolicy == POLICY_STRIDE) {
+            strideCharge(oldProc);
+        }
+        quotaCharge(oldProc);
+        if (oldProc->run_state == PROC_RUNNING) {
+            readyProcess(oldProc);
+        }
+        if (schedPolicy == POLICY_STRIDE) {
+            strideDispatched(next);
+        }
+        curProcess = next;
+#ifdef LATENCY_HIST
+        switchStartTime = currentTime();
+#endif
+        contextSwitch(oldProc, next);
+
+        // back in oldProc: whoever switched to it set switchStartTime
+        LAT_RECORD(LAT_SWITCH, switchStartTime);
     }
 }
 
+/*
+ * Function: dispatch
+ * ------------------
+ * This function wakes any sleepers that are due and terminal writers that
+ * can go on, and runs the best ready process (see bestReady()), or the idle
+ * process (priority 7) if none is ready. Init (priority 6) is never picked
+ * here, since in phase 1a it only runs when switched to by hand. If the
+ * current process is still runnable, it keeps the CPU when nothing else is
+ * ready or, under POLICY_STRIDE, when its pass is still the lowest;
+ * otherwise it goes back on its ready queue. A member of a throttled group
+ * never keeps the CPU.
+ */
+void dispatch(void) {
+    struct PCB *next;
+
+    wakeWaiters();
+    next = bestReady();
+
+    // a process that was blocking can be woken again before it switches
+    // away, if its interrupt came in while it was queueing
+    if (next == curProcess) {
+        unreadyProcess(curProcess);
+        setState(curProcess, PROC_RUNNING);
+        return;
+    }
+
+    if (curProcess->run_state == PROC_RUNNING && !groupThrottled(curProcess->group)) {
+        if (next == NULL) {
+            return;
+        }
+        if (schedPolicy == POLICY_STRIDE && curProcess->priority <= 5) {
+            strideCharge(curProcess);
+            if (curProcess->pass <= next->pass) {
+                return;
+            }
+        }
+    }
+    if (next == NULL) {
+        next = queue[6].head;
+    }
+    if (next != NULL) {
+        switchProcess(next, 1);
+    }
+}
+
+/*
+ * Function: yieldCpu
+ * ------------------
+ * This function wakes whoever an interrupt has made due and, if a ready
+ * process at the current process's priority or better is waiting (under
+ * POLICY_STRIDE, if one has a lower pass), runs it; the current process goes
+ * to the tail of its ready queue. Otherwise the current process keeps the
+ * CPU, unless its group has just been throttled.
+ */
+void yieldCpu(void) {
+    struct PCB *next;
+
+    wakeWaiters();
+    next = bestReady();
+    if (groupThrottled(curProcess->group) ||
+        (next != NULL && (schedPolicy == POLICY_STRIDE || next->priority <= curProcess->priority))) {
+        dispatch();
+    }
+}
+
+/*
+ * Function: blockMe
+ * -----------------
+ * This function blocks the current process and runs the highest priority
+ * ready process instead. The caller must already have put the current
+ * process on whatever wait queue will wake it. If nothing else is ready but
+ * some process is sleeping on the clock or waiting on a terminal, or is
+ * held back by its group's quota, the idle process runs until it wakes; if
+ * nobody is sleeping either, the simulation is deadlocked.
+ */
+void blockMe(void) {
+    setState(curProcess, PROC_BLOCKED);
+
+    if (bestReady() == NULL && !sleepersWaiting() && !termWaiting() && !quotaWaiting()) {
+        USLOSS_Console("ERROR: Process pid %d blocked, but no other process is runnable.\n", getpid());
+        USLOSS_Halt(1);
+    }
+
+    dispatch();
+}
+
+/*
+ * Function: wakeProcess
+ * ---------------------
+ * This function makes a blocked process runnable again. Under
+ * POLICY_PRIORITY, if it has a higher priority than the current process it
+ * runs right away; otherwise it waits its turn on its ready queue. Either
+ * way it passes through the ready state.
+ * 
+ * @param struct PCB *proc: blocked process to wake
+ */
+void wakeProcess(struct PCB *proc) {
+    readyProcess(proc);
+
+    if (schedPolicy == POLICY_PRIORITY && proc->priority < curProcess->priority) {
+        switchProcess(proc, 1);
+    }
+}
+
+/*
+ * Function: preemptIfOutranked
+ * ----------------------------
+ * This function runs the best ready process right away if, under
+ * POLICY_PRIORITY, it has a higher priority than the current process; for
+ * callers that have readied several processes at once, and for kernel
+ * entries after an interrupt. A current process whose group quotaUpdate()
+ * has just throttled gives up the CPU here too.
+ */
+void preemptIfOutranked(void) {
+    struct PCB *best;
+
+    if (curProcess->run_state == PROC_RUNNING && groupThrottled(curProcess->group)) {
+        dispatch();
+        return;
+    }
+    best = bestReady();
+    if (schedPolicy == POLICY_PRIORITY && best != NULL && best->priority < curProcess->priority) {
+        switchProcess(best, 1);
+    }
+}
+
+/*
+ * Function: waitQueueAppend
+ * -------------------------
+ * This function appends a process to the tail of a wait queue.
+ * 
+ * @param struct WaitQueue *wq: wait queue to add to
+ * 
+ * @param struct PCB *proc: process that is going to wait
+ */
+void waitQueueAppend(struct WaitQueue *wq, struct PCB *proc) {
+    proc->wait_next = NULL;
+    proc->wait_queue = wq;
+    if (wq->tail == NULL) {
+        wq->head = proc;
+    }
+    else {
+        wq->tail->wait_next = proc;
+    }
+    wq->tail = proc;
+}
+
+/*
+ * Function: waitQueuePop
+ * ----------------------
+ * This function removes the process at the head of a wait queue.
+ * 
+ * @param struct WaitQueue *wq: wait queue to take from
+ * 
+ * @return struct PCB *: first waiting process, or NULL if nobody is waiting
+ */
+struct PCB *waitQueuePop(struct WaitQueue *wq) {
+    struct PCB *proc = wq->head;
+
+    if (proc != NULL) {
+        wq->head = proc->wait_next;
+        if (wq->head == NULL) {
+            wq->tail = NULL;
+        }
+        proc->wait_next = NULL;
+        proc->wait_queue = NULL;
+    }
+    return proc;
+}
+
+/*
+ * Function: waitQueueRemove
+ * -------------------------
+ * This function takes a process out of the middle of a wait queue.
+ */
+static void waitQueueRemove(struct WaitQueue *wq, struct PCB *proc) {
+    struct PCB *prev = NULL, *p;
+
+    for (p = wq->head; p != NULL && p != proc; p = p->wait_next) {
+        prev = p;
+    }
+    if (p == NULL) {
+        return;
+    }
+    if (prev == NULL) {
+        wq->head = proc->wait_next;
+    }
+    else {
+        prev->wait_next = proc->wait_next;
+    }
+    if (wq->tail == proc) {
+        wq->tail = prev;
+    }
+    proc->wait_next = NULL;
+    proc->wait_queue = NULL;
+}
+
+/*
+ * Function: cancelWait
+ * --------------------
+ * This function wakes a blocked process early, for kill_group(): it takes
+ * the process off the wait queue, wait_any() targets or task join it is
+ * blocked on and readies it, and the blocking call returns -4. It does not
+ * switch.
+ *
+ * @param struct PCB *proc: blocked process
+ *
+ * @return int 1: returned if it was woken
+ *
+ * @return int 0: returned if it is not blocked, or not on anything that
+ *                can be cancelled
+ */
+int cancelWait(struct PCB *proc) {
+    if (proc->run_state != PROC_BLOCKED) {
+        return 0;
+    }
+    if (proc->wait_queue != NULL) {
+        waitQueueRemove(proc->wait_queue, proc);
+    }
+    else if (proc->wait_nodes != NULL) {
+        waitAnyCancel(proc);
+    }
+    else if (proc->task_join) {
+        proc->task_join = 0;
+    }
+    else {
+        return 0;
+    }
+    proc->wait_result = -4;
+    readyProcess(proc);
+    return 1;
+}
+
+/*
+ * Function: pid_lookup
+ * --------------------
+ * This function finds the process a pid names, in constant time: the slot
+ * is PID_SLOT(pid), and the pid stored there carries the generation that
+ * holds the slot now, so one comparison rejects a pid whose process has
+ * been joined, even if a later process has taken its slot. Zombies are
+ * found, since they can still be joined. Every kernel call that takes a pid
+ * goes through here.
+ * 
+ * @param int pid: process ID
+ * 
+ * @return struct PCB *: the process, or NULL if pid names no process in the
+ *                       table
+ */
+struct PCB *pid_lookup(int pid) {
+    if (pid <= 0) {
+        return NULL;
+    }
+    struct PCB *proc = &pTable[PID_SLOT(pid)];
+
+    if (ATOMIC_LOAD(proc->pid) != pid) {
+        return NULL;
+    }
+    return proc;
+}
+
+/*
+ * Function: pidRequire
+ * --------------------
+ * This function is pid_lookup() for kernel calls that have no way to
+ * report a bad pid: it halts, saying whether the pid is stale (a later
+ * generation holds its slot) or never named a process.
+ * 
+ * @param char *func: name of the kernel call, for the message
+ * 
+ * @param int pid: process ID
+ * 
+ * @return struct PCB *: the process
+ */
+struct PCB *pidRequire(char *func, int pid) {
+    struct PCB *proc = pid_lookup(pid);
+
+    if (proc == NULL) {
+        int holder = pid > 0 ? pTable[PID_SLOT(pid)].pid : 0;
+
+        if (holder != 0 && PID_GEN(holder) > PID_GEN(pid)) {
+            USLOSS_Console("ERROR: Process pid %d called %s() with pid %d, whose slot now holds pid %d.\n",
+                           getpid(), func, pid, holder);
+        }
+        else {
+            USLOSS_Console("ERROR: Process pid %d called %s() with pid %d, which is not a process.\n",
+                           getpid(), func, pid);
+        }
+        USLOSS_Halt(1);
+    }
+    return proc;
+}
+
+/*
+ * Function: TEMP_switchTo
+ * -----------------------
+ * This function performs context switches from one process to another, saving
+ * the old process's state. It halts if pid is stale or not a process.
+ * 
+ * @param int pid: process ID
+ */
+void TEMP_switchTo(int pid) {
+    checkKernelMode("TEMP_switchTo");
+
+    switchProcess(pidRequire("TEMP_switchTo", pid), 0);
+}
+
+/*
+ * Function: yield_to
+ * ------------------
+ * This function hands the CPU straight to a ready process: the caller goes
+ * to the tail of its ready queue, as with any preemption, and the target
+ * runs next without the dispatcher choosing. The pid is checked with
+ * pid_lookup(), so the whole call takes constant time. Under POLICY_STRIDE
+ * the caller is charged for its time and the target pays for its own, so
+ * handoffs do not buy either side extra CPU; under POLICY_PRIORITY the
+ * target may be of lower priority, and then runs until the next reschedule
+ * or kernel entry lets the dispatcher in.
+ * 
+ * @param int pid: process to run
+ * 
+ * @return int -1: returned if pid is stale or not a process, or during
+ *                 smpRun()
+ * 
+ * @return int -2: returned if the process is the caller, is not ready
+ *                 (blocked, a zombie, or not yet switched to), or is held
+ *                 back by its group's CPU quota
+ * 
+ * @return int 0: success, once the caller runs again
+ */
+int yield_to(int pid) {
+    checkKernelMode("yield_to");
+
+    struct PCB *target = pid_lookup(pid);
+
+    if (target == NULL || smpActive) {
+        curProcess->yields_refused++;
+        return -1;
+    }
+    if (target == curProcess || target->run_state != PROC_READY || target->parked) {
+        curProcess->yields_refused++;
+        return -2;
+    }
+
+    curProcess->yields_given++;
+    target->yields_received++;
+    switchProcess(target, 0);
+    return 0;
+}
+
+/*
+ * Function: yieldStats
+ * --------------------
+ * This function reports a process's yield_to() counters.
+ * 
+ * @param int pid: process ID
+ * 
+ * @param struct YieldStats *stats: out-pointer filled with the counters
+ * 
+ * @return int -1: returned if pid is stale or not a process, or stats is
+ *                 NULL
+ * 
+ * @return int 0: success
+ */
+int yieldStats(int pid, struct YieldStats *stats) {
+    checkKernelMode("yieldStats");
+
+    struct PCB *proc = pid_lookup(pid);
+
+    if (proc == NULL || stats == NULL) {
+        return -1;
+    }
+    stats->given = proc->yields_given;
+    stats->received = proc->yields_received;
+    stats->refused = proc->yields_refused;
+    return 0;
+}
+
+/*
+ * Function: claimSlot
+ * -------------------
+ * This function takes a free process table slot for a new process by
+ * setting its pid. During smpRun() several CPUs may spork at once, so in
+ * HOST_SMP builds this is a compare-and-swap from 0.
+ * 
+ * @return int 1: the slot is now 'pid''s
+ * 
+ * @return int 0: the slot was in use
+ */
+static int claimSlot(struct PCB *slot, int pid) {
+#ifdef HOST_SMP
+    int free = 0;
+    return __atomic_compare_exchange_n(&slot->pid, &free, pid, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+#else
+    if (slot->pid != 0) {
+        return 0;
+    }
+    slot->pid = pid;
+    return 1;
+#endif
+}
+
 /*
  * Function: spork
  * ---------------
@@ -118,6 +852,10 @@ void TEMP_switchTo(int pid) {
  * 
  * @param int priority: priority of this process in range of 1-5 (inclusive)
  * 
+ * @return int -3: returned if the stack would exceed the memory limit, the
+ *                 parent already has the maximum number of children (see
+ *                 setMemLimits()), or the stack cannot be allocated
+ * 
  * @return int -2: returned if stackSize is less than USLOSS_MIN_STACK
  * 
  * @return int -1: returned if there are no empty slots in the process table,
@@ -127,10 +865,8 @@ void TEMP_switchTo(int pid) {
  * @return int >0: PID of child process
  */
 int  spork(char *name, int(*startFunc)(char *), char *arg, int stacksize, int priority) {
-    if ((USLOSS_PsrGet() & USLOSS_PSR_CURRENT_MODE) == 0) {
-        USLOSS_Console("ERROR: Someone attempted to call spork while in user mode!\n");
-        USLOSS_Halt(1);
-    }
+    checkKernelMode("spork");
+    LAT_START(start);
 
     if ((processes >= MAXPROC) || (priority < 1) || (priority > 5) || 
     (name == NULL) || (strlen(name) > MAXNAME) || (startFunc == NULL))  {
@@ -139,45 +875,62 @@ int  spork(char *name, int(*startFunc)(char *), char *arg, int stacksize, int pr
     else if (stacksize < USLOSS_MIN_STACK) {
         return -2;
     }
+    else if (memAdmit(curProcess, stacksize) < 0) {
+        return -3;
+    }
     
-    // finds the next open slot in the process table to put new process
-    int slot = PID % MAXPROC;
-    int count = 1;
-    while (count <= MAXPROC && pTable[slot].used == 1) {
-        PID++;
-        slot = PID % MAXPROC;
-        count += 1;
-
-        // checks if process table is full
-        if (count == MAXPROC) {
-            return -1;
+    // allocate the stack before touching the slot, so failure leaves no trace
+    char *stack = kernelAlloc(stacksize);
+    if (stack == NULL) {
+        return -3;
+    }
+
+    // takes the next PID whose slot is open
+    struct PCB *newProcess = NULL;
+    int count;
+    for (count = 0; count < MAXPROC && newProcess == NULL; count++) {
+        int pid = ATOMIC_ADD(PID, 1) - 1;
+        if (claimSlot(&pTable[PID_SLOT(pid)], pid)) {
+            newProcess = &pTable[PID_SLOT(pid)];
         }
     }
 
-    struct PCB *newProcess = &pTable[slot];  
+    // checks if process table is full
+    if (newProcess == NULL) {
+        kernelFree(stack);
+        return -1;
+    }
 
     // increment number of process in process table 
-    processes += 1;
+    ATOMIC_ADD(processes, 1);
 
     // set new process properties
     strcpy(newProcess->name, name);
     newProcess->priority = priority;
-    newProcess->pid = PID; 
-    newProcess->status = 0;
-    newProcess->hasExited = 0;
-    newProcess->used = 1;
+    newProcess->tickets = DEFAULT_TICKETS;
+    newProcess->pass = 0;
+    newProcess->killed = 0;
     newProcess->parent = curProcess;
     newProcess->first_child = NULL;
-    newProcess->next_sibling = NULL;
+    newProcess->last_child = NULL;
+    newProcess->prev_sibling = NULL;
     newProcess->next_sibling = curProcess->first_child;
+    if (curProcess->first_child != NULL) {
+        curProcess->first_child->prev_sibling = newProcess;
+    }
+    else {
+        curProcess->last_child = newProcess;
+    }
     curProcess->first_child = newProcess;
-    newProcess->stack = (char *) malloc(stacksize);
+    groupAdd(newProcess, curProcess->group);
+    newProcess->stack = stack;
+    newProcess->stack_size = stacksize;
+    memCharge(newProcess);
 
-    russ_ContextInit(newProcess->pid, &newProcess->state, newProcess->stack, USLOSS_MIN_STACK, startFunc, arg);
-
-    // PID for new proces
-    PID += 1;
+    contextInit(newProcess, startFunc, arg, stacksize);
+    readyProcess(newProcess);
 
+    LAT_RECORD(LAT_SPORK, start);
     return newProcess->pid;
 }
 
@@ -186,7 +939,10 @@ int  spork(char *name, int(*startFunc)(char *), char *arg, int stacksize, int pr
  * --------------
  * This function delivers the 'status' of the child (the parameter that the child passed
  * to quit()) back to the parent. If the current process has a dead child, join() reports
- * its status.
+ * its status. During smpRun(), a process whose children are all still running yields
+ * its CPU until one of them quits, since the children may be running on other CPUs.
+ * Finished micro-tasks (see taskCreate()) are joined the same way; a process whose
+ * tasks are still running blocks until one of them finishes.
  * 
  * @param int *status: out-pointer that must point to an int; join fills this with
  *                     the status of the process joined-to
@@ -196,49 +952,160 @@ int  spork(char *name, int(*startFunc)(char *), char *arg, int stacksize, int pr
  * @return int -2: returned if the process doesn't have any children or all children have
  *                 already been joined
  * 
- * @return int >0: PID of child joined-to
+ * @return int -4: returned if kill_group() woke it while it waited for a task
+ *
+ * @return int >0: PID of child joined-to, or ID of the task
  */
 int  join(int *status) {
-    if ((USLOSS_PsrGet() & USLOSS_PSR_CURRENT_MODE) == 0) {
-        USLOSS_Console("ERROR: Someone attempted to call join while in user mode!\n");
-        USLOSS_Halt(1);
-    }
+    checkKernelMode("join");
 
     if (status == NULL) {
         return -3;
     } 
     
     struct PCB *child;
-    struct PCB *prevChild = NULL;
-
+    LAT_START(start);
 
-    // iterates through all of current process's children to determine if they have all
-    // been terminated 
-    for (child = curProcess->first_child; child != NULL; child = child->next_sibling) {
-        if (child->hasExited) {
+    while (1) {
 
-            // fix pointers to child processes 
-            if (prevChild == NULL) {
-                curProcess->first_child = child->next_sibling;
-            }
-            else {
-                prevChild->next_sibling = child->next_sibling;
+        // iterates through all of current process's children to determine if they have all
+        // been terminated 
+        for (child = curProcess->first_child; child != NULL; child = child->next_sibling) {
+            if (ATOMIC_LOAD(child->run_state) == PROC_ZOMBIE) {
+                int temp = child->pid;
+                *status = child->exit_status; // set the exit status of the child
+                reapChild(child);
+                
+                LAT_RECORD(LAT_JOIN, start);
+                return temp; // return the PID of the joined child
             }
+        }
 
-            // find slot where child is located in process table
-            int slot = child->pid % MAXPROC;
-            processes--;
-            int temp = child->pid;
-            *status = child->status; // set the exit status of the child
-            free(child->stack); // free child's memory
-            memset(&pTable[slot], 0, sizeof(struct PCB)); // reset memory at the slot
-            pTable[slot].used = 0;
-            
-            return temp; // return the PID of the joined child
+        // then finished micro-tasks; unfinished ones are worth waiting for,
+        // since they run as soon as this process lets them
+        int id = taskReap(curProcess, status);
+        if (id > 0) {
+            LAT_RECORD(LAT_JOIN, start);
+            return id;
+        }
+        if (curProcess->live_tasks > 0 && !smpActive) {
+            curProcess->task_join = 1;
+            curProcess->wait_result = 0;
+            blockMe();
+            if (curProcess->wait_result < 0) {
+                return curProcess->wait_result;
+            }
+            continue;
         }
-        prevChild = child;
+        if (!smpActive || curProcess->first_child == NULL) {
+            return -2;
+        }
+        smpSwitchOut(SMP_YIELD);
     }
-    return -2;
+}
+
+/*
+ * Function: reapChild
+ * -------------------
+ * This function removes a terminated child from its parent's child list and
+ * its group, frees its stack, returns its arena pages to the pool and clears
+ * its process table slot. The sibling list is doubly linked, so this takes
+ * constant time.
+ * 
+ * @param struct PCB *child: terminated child to reap
+ */
+void reapChild(struct PCB *child) {
+
+    // fix pointers to child processes 
+    if (child->prev_sibling == NULL) {
+        child->parent->first_child = child->next_sibling;
+    }
+    else {
+        child->prev_sibling->next_sibling = child->next_sibling;
+    }
+    if (child->next_sibling != NULL) {
+        child->next_sibling->prev_sibling = child->prev_sibling;
+    }
+    else {
+        child->parent->last_child = child->prev_sibling;
+    }
+    groupRemove(child);
+    memRelease(child);
+    LAT_RECORD(LAT_REAP, child->quit_time);
+
+    ATOMIC_ADD(processes, -1);
+    setState(child, PROC_FREE);
+    kernelFree(child->stack); // free child's memory
+    arenaRelease(child);
+
+    // reset memory at the slot; the pid goes last, since spork() on another
+    // CPU may claim the slot as soon as it is 0
+    char *bytes = (char *) child;
+    int pidAt = offsetof(struct PCB, pid);
+    memset(bytes, 0, pidAt);
+    memset(bytes + pidAt + sizeof(int), 0, sizeof(struct PCB) - pidAt - sizeof(int));
+    ATOMIC_STORE(child->pid, 0);
+}
+
+/*
+ * Function: adoptOrphans
+ * ----------------------
+ * This function hands all children of a quitting process, and its
+ * micro-tasks (see taskAdopt()), to init. The whole child list is spliced
+ * onto the tail of init's list in constant time; the only per-child work is
+ * one pass to point each direct child's parent at init. Grandchildren are
+ * untouched, so deep trees cost no more than their top level.
+ * 
+ * @param struct PCB *proc: process that is quitting with children
+ */
+static void adoptOrphans(struct PCB *proc) {
+    struct PCB *init = &pTable[1];
+    struct PCB *child;
+
+    taskAdopt(proc, init);
+    if (proc->first_child == NULL) {
+        return;
+    }
+    for (child = proc->first_child; child != NULL; child = child->next_sibling) {
+        memMove(child, init);
+        child->parent = init;
+    }
+
+    proc->first_child->prev_sibling = init->last_child;
+    if (init->last_child == NULL) {
+        init->first_child = proc->first_child;
+    }
+    else {
+        init->last_child->next_sibling = proc->first_child;
+    }
+    init->last_child = proc->last_child;
+
+    proc->first_child = NULL;
+    proc->last_child = NULL;
+}
+
+/*
+ * Function: set_orphan_policy
+ * ---------------------------
+ * This function chooses what quit_phase_1a() does when the quitting process
+ * still has children: halt the simulation (ORPHANS_HALT, the default) or
+ * give them to init (ORPHANS_REPARENT), whose join loop reaps them.
+ * 
+ * @param int policy: ORPHANS_HALT or ORPHANS_REPARENT
+ * 
+ * @return int -1: returned if policy is not one of the above
+ * 
+ * @return int >=0: the previous policy
+ */
+int set_orphan_policy(int policy) {
+    checkKernelMode("set_orphan_policy");
+
+    if (policy != ORPHANS_HALT && policy != ORPHANS_REPARENT) {
+        return -1;
+    }
+    int old = orphanPolicy;
+    orphanPolicy = policy;
+    return old;
 }
 
 /*
@@ -251,29 +1118,56 @@ int  join(int *status) {
  * @param int status: out-pointer that must point to an int; join fills this with
  *                    the status of the process joined-to
  * 
- * @param int switchToPid: PID of process to run next
+ * @param int switchToPid: PID of process to run next; halts if it is stale or
+ *                         not a process
  */
 void quit_phase_1a(int status, int switchToPid) {
-    if ((USLOSS_PsrGet() & USLOSS_PSR_CURRENT_MODE) == 0) {
-        USLOSS_Console("ERROR: Someone attempted to call quit_phase_1a while in user mode!\n");
-        USLOSS_Halt(1);
-    }
+    checkKernelMode("quit_phase_1a");
 
-    if (curProcess->first_child != 0) {
-        USLOSS_Console("ERROR: Process pid %d called quit() while it still had children.\n", getpid());
-        USLOSS_Halt(1);
+    if (curProcess->first_child != 0 || curProcess->done_tasks != NULL || curProcess->live_tasks > 0) {
+        if (orphanPolicy != ORPHANS_REPARENT || curProcess->pid == 1 || smpActive) {
+            USLOSS_Console("ERROR: Process pid %d called quit() while it still had children.\n", getpid());
+            USLOSS_Halt(1);
+        }
+        adoptOrphans(curProcess);
     }
 
     // set to exited and status (for join)
     if (curProcess->pid != 1) {
-        curProcess->hasExited = 1;
-        curProcess->used = 0;
-        curProcess->status = status;   
+        struct PCB *next = pidRequire("quit_phase_1a", switchToPid);
+
+        curProcess->exit_status = status;
+        memZombie(curProcess);
+        regionRelease(curProcess);
+        mutexQuit(curProcess);
+        quotaCharge(curProcess);
+
+        // under smpRun() the CPU makes the process a zombie once it is off
+        // its stack, so that a parent on another CPU cannot free it too soon
+        if (smpActive) {
+            smpSwitchOut(SMP_QUIT);
+        }
+        setState(curProcess, PROC_ZOMBIE);
+        waitAnyChildQuit(curProcess);
     
-        int slot = switchToPid % MAXPROC;
-        curProcess = &pTable[slot];
+        // the dying process is passed along so that a switch to a process
+        // of the other backend can go through the bridge
+        struct PCB *dying = curProcess;
+        curProcess = next;
+        if (schedMode != SCHED_LIVE) {
+            curProcess = schedDecision(curProcess, 0);
+        }
+        unreadyProcess(curProcess);
+        setState(curProcess, PROC_RUNNING);
+        if (schedPolicy == POLICY_STRIDE) {
+            strideDispatched(curProcess);
+        }
+#ifdef LATENCY_HIST
+        dying->quit_time = currentTime();
+        switchStartTime = dying->quit_time;
+#endif
         
-        USLOSS_ContextSwitch(NULL, &curProcess->state);
+        contextSwitch(dying, curProcess);
     }
 
     exit(status);
@@ -300,10 +1194,7 @@ int  getpid(void) {
  * This function prints information about all processes in the process table. 
  */
 void dumpProcesses() {
-    if ((USLOSS_PsrGet() && USLOSS_PSR_CURRENT_MODE) == 0) {
-        USLOSS_Console("ERROR: Someone attempted to call dumpProcesses while in user mode!\n");
-        USLOSS_Halt(1);
-    }
+    checkKernelMode("dumpProcesses");
 
     int i = 0;
     struct PCB *temp = &pTable[i];
@@ -326,16 +1217,27 @@ void dumpProcesses() {
             USLOSS_Console("%4d  %4d  %-17s %-10d", temp->pid, ppid, temp->name, temp->priority);
 
             // prints process status
-            if (temp->status == 0 && temp->pid == curProcess->pid) {
+            if (temp->run_state == PROC_RUNNING) {
                 USLOSS_Console("Running\n");
             }
-            else if (temp->status == 0) {
+            else if (temp->run_state == PROC_READY && temp->parked) {
+                USLOSS_Console("Throttled\n");
+            }
+            else if (temp->run_state == PROC_READY) {
                 USLOSS_Console("Runnable\n");
             }
+            else if (temp->run_state == PROC_BLOCKED) {
+                USLOSS_Console("Blocked\n");
+            }
             else {
-                USLOSS_Console("Terminated(%d)\n", temp->status);
+                USLOSS_Console("Terminated(%d)\n", temp->exit_status);
             }
         }
         i += 1;
     }
+
+    // CPU quotas, and how often and how long each group has been throttled
+    if (quotaActive()) {
+        dumpGroups();
+    }
 }
\ No newline at end of file
@@ -0,0 +1,529 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include "kernel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+struct MailSlot {
+    struct MailSlot *next; // next slot in the mailbox ring, or in the free list
+    int size; // bytes in the message
+    void *buf; // message buffer, for zero-copy mailboxes
+    char data[MAX_MESSAGE]; // message bytes, for copying mailboxes
+};
+
+struct Mailbox {
+    int used; // flag to check if mailbox in use
+    int numSlots; // capacity of the ring
+    int slotSize; // largest message, or MBOX_ZEROCOPY
+    int count; // messages currently in the ring
+    struct MailSlot *readSlot; // next slot to receive from
+    struct MailSlot *writeSlot; // next slot to fill
+    struct WaitQueue senders; // processes blocked on a full mailbox
+    struct WaitQueue receivers; // processes blocked on an empty mailbox
+    struct WaitNode *watchers; // wait_any() callers waiting for a message
+};
+
+// mailbox table
+struct Mailbox mboxTable[MAXMBOX];
+
+// slab that every mailbox ring is carved from
+struct MailSlot slotSlab[MAXSLOTS];
+
+// unused slots in the slab
+struct MailSlot *freeSlots;
+
+/*
+ * Function: mboxInit
+ * ------------------
+ * This function empties the mailbox table and threads every slot of the slab
+ * onto the free list.
+ */
+void mboxInit(void) {
+    int i;
+
+    memset(mboxTable, 0, sizeof(mboxTable));
+    freeSlots = NULL;
+    for (i = MAXSLOTS - 1; i >= 0; i--) {
+        slotSlab[i].next = freeSlots;
+        freeSlots = &slotSlab[i];
+    }
+}
+
+/*
+ * Function: getMbox
+ * -----------------
+ * This function looks up a mailbox by ID.
+ *
+ * @param int zeroCopy: 1 if the caller passes buffers by pointer, 0 if it
+ *                      copies messages
+ *
+ * @return struct Mailbox *: the mailbox, or NULL if the ID is invalid or the
+ *                           mailbox is of the other kind
+ */
+static struct Mailbox *getMbox(int mbox, int zeroCopy) {
+    if (mbox < 0 || mbox >= MAXMBOX || !mboxTable[mbox].used ||
+    (mboxTable[mbox].slotSize == MBOX_ZEROCOPY) != zeroCopy) {
+        return NULL;
+    }
+    return &mboxTable[mbox];
+}
+
+/*
+ * Function: slotStore
+ * -------------------
+ * This function puts a message into the next free slot of the ring. The
+ * caller has checked that there is room.
+ */
+static void slotStore(struct Mailbox *mb, void *msg, int size) {
+    struct MailSlot *slot = mb->writeSlot;
+
+    if (mb->slotSize == MBOX_ZEROCOPY) {
+        slot->buf = msg;
+    }
+    else if (size > 0) {
+        memcpy(slot->data, msg, size);
+    }
+    slot->size = size;
+    mb->writeSlot = slot->next;
+    mb->count++;
+}
+
+/*
+ * Function: slotTake
+ * ------------------
+ * This function removes the oldest message from the ring.
+ *
+ * @param void *dest: buffer to copy into, or where to store the buffer
+ *                    pointer for a zero-copy mailbox
+ *
+ * @return int -1: returned if the message does not fit in maxSize bytes; it
+ *                 stays in the mailbox
+ *
+ * @return int >=0: size of the message
+ */
+static int slotTake(struct Mailbox *mb, void *dest, int maxSize) {
+    struct MailSlot *slot = mb->readSlot;
+
+    if (mb->slotSize == MBOX_ZEROCOPY) {
+        *(void **) dest = slot->buf;
+    }
+    else if (slot->size > maxSize) {
+        return -1;
+    }
+    else if (slot->size > 0) {
+        memcpy(dest, slot->data, slot->size);
+    }
+    mb->readSlot = slot->next;
+    mb->count--;
+    return slot->size;
+}
+
+/*
+ * Function: transfer
+ * ------------------
+ * This function moves a message straight from a sender to a receiver without
+ * going through a slot.
+ */
+static void transfer(struct Mailbox *mb, void *dest, void *msg, int size) {
+    if (mb->slotSize == MBOX_ZEROCOPY) {
+        *(void **) dest = msg;
+    }
+    else if (size > 0) {
+        memcpy(dest, msg, size);
+    }
+}
+
+/*
+ * Function: send
+ * --------------
+ * Common code for the four send calls. A waiting receiver gets the message
+ * directly and is woken; otherwise it goes into a slot, or the sender blocks
+ * until a receiver makes room.
+ *
+ * @return int -2: returned if conditional and the mailbox is full
+ *
+ * @return int -1: returned if the mailbox or message is invalid
+ *
+ * @return int -3: returned if the mailbox was released while blocked
+ *
+ * @return int -4: returned if kill_group() woke it while blocked
+ *
+ * @return int 0: success
+ */
+static int send(int mbox, void *msg, int size, int conditional, int zeroCopy) {
+    struct Mailbox *mb = getMbox(mbox, zeroCopy);
+    struct PCB *receiver;
+
+    if (mb == NULL || size < 0 || (msg == NULL && (size > 0 || zeroCopy)) ||
+    (!zeroCopy && size > mb->slotSize)) {
+        return -1;
+    }
+
+    receiver = waitQueuePop(&mb->receivers);
+    if (receiver != NULL) {
+        if (zeroCopy || size <= receiver->wait_size) {
+            transfer(mb, receiver->wait_msg, msg, size);
+            receiver->wait_result = size;
+            wakeProcess(receiver);
+            return 0;
+        }
+
+        // the receiver's buffer is too small; fail its receive and start over
+        receiver->wait_result = -1;
+        wakeProcess(receiver);
+        return send(mbox, msg, size, conditional, zeroCopy);
+    }
+
+    if (mb->count < mb->numSlots) {
+        slotStore(mb, msg, size);
+        watchWake(&mb->watchers, 1);
+        return 0;
+    }
+
+    if (conditional) {
+        return -2;
+    }
+
+    curProcess->wait_msg = msg;
+    curProcess->wait_size = size;
+    waitQueueAppend(&mb->senders, curProcess);
+    watchWake(&mb->watchers, 0);
+    blockMe();
+    return curProcess->wait_result;
+}
+
+/*
+ * Function: recv
+ * --------------
+ * Common code for the four receive calls. Taking a message from a full ring
+ * pulls in the message of the first blocked sender and wakes it; on a
+ * zero-slot mailbox the message comes straight from the sender.
+ *
+ * @return int -2: returned if conditional and the mailbox is empty
+ *
+ * @return int -1: returned if the mailbox is invalid or the message is larger
+ *                 than maxSize
+ *
+ * @return int -3: returned if the mailbox was released while blocked
+ *
+ * @return int -4: returned if kill_group() woke it while blocked
+ *
+ * @return int >=0: size of the message received
+ */
+static int recv(int mbox, void *dest, int maxSize, int conditional, int zeroCopy) {
+    struct Mailbox *mb = getMbox(mbox, zeroCopy);
+    struct PCB *sender;
+    int size;
+
+    if (mb == NULL || (dest == NULL && (zeroCopy || maxSize > 0)) || (!zeroCopy && maxSize < 0)) {
+        return -1;
+    }
+
+    if (mb->count > 0) {
+        size = slotTake(mb, dest, maxSize);
+        if (size < 0) {
+            return -1;
+        }
+
+        sender = waitQueuePop(&mb->senders);
+        if (sender != NULL) {
+            slotStore(mb, sender->wait_msg, sender->wait_size);
+            sender->wait_result = 0;
+            wakeProcess(sender);
+        }
+        return size;
+    }
+
+    // only a zero-slot mailbox can have senders waiting while it is empty
+    sender = mb->senders.head;
+    if (sender != NULL) {
+        if (!zeroCopy && sender->wait_size > maxSize) {
+            return -1;
+        }
+        waitQueuePop(&mb->senders);
+        size = sender->wait_size;
+        transfer(mb, dest, sender->wait_msg, size);
+        sender->wait_result = 0;
+        wakeProcess(sender);
+        return size;
+    }
+
+    if (conditional) {
+        return -2;
+    }
+
+    curProcess->wait_msg = dest;
+    curProcess->wait_size = maxSize;
+    waitQueueAppend(&mb->receivers, curProcess);
+    blockMe();
+    return curProcess->wait_result;
+}
+
+/*
+ * Function: mboxWatch
+ * -------------------
+ * This function checks a WAIT_MBOX target for wait_any(): a mailbox is
+ * ready if a receive would not block, because it holds a message or, with
+ * no slots, has a sender waiting. Otherwise the node goes on its watchers.
+ *
+ * @return int -1: returned if mbox is not a mailbox
+ *
+ * @return int 1: returned if it is ready now
+ *
+ * @return int 0: the node is watching it
+ */
+int mboxWatch(int mbox, struct WaitNode *node) {
+    if (mbox < 0 || mbox >= MAXMBOX || !mboxTable[mbox].used) {
+        return -1;
+    }
+    struct Mailbox *mb = &mboxTable[mbox];
+
+    if (mb->count > 0 || mb->senders.head != NULL) {
+        return 1;
+    }
+    watchAdd(&mb->watchers, node);
+    return 0;
+}
+
+/*
+ * Function: MboxCreate
+ * --------------------
+ * This function creates a mailbox whose ring of slots is taken from the
+ * kernel slab.
+ *
+ * @param int numSlots: number of messages the mailbox can hold; 0 makes every
+ *                      send wait for a receiver
+ *
+ * @param int slotSize: largest message in bytes (at most MAX_MESSAGE; 0 for
+ *                      signals only), or MBOX_ZEROCOPY to pass buffers by
+ *                      pointer
+ *
+ * @return int -1: returned if an argument is out of range, the mailbox table
+ *                 is full, or the slab has too few free slots
+ *
+ * @return int >=0: ID of the new mailbox
+ */
+int MboxCreate(int numSlots, int slotSize) {
+    checkKernelMode("MboxCreate");
+
+    if (numSlots < 0 || numSlots > MAXSLOTS || (slotSize < 0 && slotSize != MBOX_ZEROCOPY) ||
+        slotSize > MAX_MESSAGE) {
+        return -1;
+    }
+
+    int mbox;
+    for (mbox = 0; mbox < MAXMBOX && mboxTable[mbox].used; mbox++)
+        ;
+    if (mbox == MAXMBOX) {
+        return -1;
+    }
+
+    // carve the ring out of the free list, giving it back if we run short
+    struct MailSlot *ring = NULL;
+    struct MailSlot *last = NULL;
+    int i;
+    for (i = 0; i < numSlots; i++) {
+        struct MailSlot *slot = freeSlots;
+        if (slot == NULL) {
+            if (last != NULL) {
+                last->next = freeSlots;
+                freeSlots = ring;
+            }
+            return -1;
+        }
+        freeSlots = slot->next;
+        slot->next = ring;
+        ring = slot;
+        if (last == NULL) {
+            last = slot;
+        }
+    }
+    if (last != NULL) {
+        last->next = ring; // close the ring
+    }
+
+    struct Mailbox *mb = &mboxTable[mbox];
+    memset(mb, 0, sizeof(struct Mailbox));
+    mb->used = 1;
+    mb->numSlots = numSlots;
+    mb->slotSize = slotSize;
+    mb->readSlot = ring;
+    mb->writeSlot = ring;
+
+    return mbox;
+}
+
+/*
+ * Function: MboxRelease
+ * ---------------------
+ * This function destroys a mailbox, returns its slots to the slab and wakes
+ * every process blocked on it; their calls return -3. Processes watching it
+ * in wait_any() wake too, and their next receive returns -1. Buffers still
+ * queued in a zero-copy mailbox are not freed.
+ *
+ * @return int -1: returned if the mailbox does not exist
+ *
+ * @return int 0: success
+ */
+int MboxRelease(int mbox) {
+    checkKernelMode("MboxRelease");
+
+    if (mbox < 0 || mbox >= MAXMBOX || !mboxTable[mbox].used) {
+        return -1;
+    }
+
+    struct Mailbox *mb = &mboxTable[mbox];
+    if (mb->numSlots > 0) {
+        struct MailSlot *first = mb->readSlot->next;
+        mb->readSlot->next = freeSlots; // break the ring in front of 'first'
+        freeSlots = first;
+    }
+
+    // detach the waiters first, since a woken process may reuse the ID or
+    // kill_group() one of them; none of them runs until the loop is done
+    struct PCB *waiters[2] = { mb->senders.head, mb->receivers.head };
+    mb->senders.head = mb->senders.tail = NULL;
+    mb->receivers.head = mb->receivers.tail = NULL;
+    mb->used = 0;
+    watchWake(&mb->watchers, 0);
+
+    int i;
+    for (i = 0; i < 2; i++) {
+        struct PCB *proc = waiters[i];
+        while (proc != NULL) {
+            struct PCB *next = proc->wait_next;
+            proc->wait_next = NULL;
+            proc->wait_queue = NULL;
+            if (proc->run_state == PROC_BLOCKED) {
+                proc->wait_result = -3;
+                readyProcess(proc);
+            }
+            proc = next;
+        }
+    }
+    preemptIfOutranked();
+    return 0;
+}
+
+/*
+ * Function: MboxSend
+ * ------------------
+ * This function copies a message into a mailbox, blocking while it is full.
+ *
+ * @return int -3: returned if the mailbox was released while blocked
+ *
+ * @return int -4: returned if kill_group() woke it while blocked
+ *
+ * @return int -1: returned if the mailbox is invalid or msgSize is larger
+ *                 than its slot size
+ *
+ * @return int 0: success
+ */
+int MboxSend(int mbox, void *msg, int msgSize) {
+    checkKernelMode("MboxSend");
+    return send(mbox, msg, msgSize, 0, 0);
+}
+
+/*
+ * Function: MboxRecv
+ * ------------------
+ * This function copies the oldest message out of a mailbox, blocking while it
+ * is empty.
+ *
+ * @return int -3: returned if the mailbox was released while blocked
+ *
+ * @return int -4: returned if kill_group() woke it while blocked
+ *
+ * @return int -1: returned if the mailbox is invalid or the message is larger
+ *                 than maxMsgSize
+ *
+ * @return int >=0: size of the message
+ */
+int MboxRecv(int mbox, void *msg, int maxMsgSize) {
+    checkKernelMode("MboxRecv");
+    return recv(mbox, msg, maxMsgSize, 0, 0);
+}
+
+/*
+ * Function: MboxCondSend
+ * ----------------------
+ * This function is MboxSend() that returns -2 instead of blocking.
+ */
+int MboxCondSend(int mbox, void *msg, int msgSize) {
+    checkKernelMode("MboxCondSend");
+    return send(mbox, msg, msgSize, 1, 0);
+}
+
+/*
+ * Function: MboxCondRecv
+ * ----------------------
+ * This function is MboxRecv() that returns -2 instead of blocking.
+ */
+int MboxCondRecv(int mbox, void *msg, int maxMsgSize) {
+    checkKernelMode("MboxCondRecv");
+    return recv(mbox, msg, maxMsgSize, 1, 0);
+}
+
+/*
+ * Function: MboxSendBuf
+ * ---------------------
+ * This function passes a buffer through a zero-copy mailbox without copying
+ * it, blocking while the mailbox is full. Ownership of the buffer moves to
+ * whoever receives it.
+ *
+ * @return int -3: returned if the mailbox was released while blocked
+ *
+ * @return int -4: returned if kill_group() woke it while blocked
+ *
+ * @return int -1: returned if the mailbox is not a zero-copy mailbox or buf
+ *                 is NULL
+ *
+ * @return int 0: success
+ */
+int MboxSendBuf(int mbox, void *buf, int size) {
+    checkKernelMode("MboxSendBuf");
+    return send(mbox, buf, size, 0, 1);
+}
+
+/*
+ * Function: MboxRecvBuf
+ * ---------------------
+ * This function takes the oldest buffer out of a zero-copy mailbox, blocking
+ * while it is empty. The caller now owns the buffer.
+ *
+ * @param void **buf: out-pointer filled with the buffer
+ *
+ * @return int -3: returned if the mailbox was released while blocked
+ *
+ * @return int -4: returned if kill_group() woke it while blocked
+ *
+ * @return int -1: returned if the mailbox is not a zero-copy mailbox or buf
+ *                 is NULL
+ *
+ * @return int >=0: size the sender gave for the buffer
+ */
+int MboxRecvBuf(int mbox, void **buf) {
+    checkKernelMode("MboxRecvBuf");
+    return recv(mbox, buf, 0, 0, 1);
+}
+
+/*
+ * Function: MboxCondSendBuf
+ * -------------------------
+ * This function is MboxSendBuf() that returns -2 instead of blocking.
+ */
+int MboxCondSendBuf(int mbox, void *buf, int size) {
+    checkKernelMode("MboxCondSendBuf");
+    return send(mbox, buf, size, 1, 1);
+}
+
+/*
+ * Function: MboxCondRecvBuf
+ * -------------------------
+ * This function is MboxRecvBuf() that returns -2 instead of blocking.
+ */
+int MboxCondRecvBuf(int mbox, void **buf) {
+    checkKernelMode("MboxCondRecvBuf");
+    return recv(mbox, buf, 0, 1, 1);
+}
@@ -0,0 +1,204 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include "kernel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Kernel memory accounting. The only memory the kernel allocates per process
+ * is its stack, plus any arena pages it asks for (arena.c, counted there);
+ * PCBs live in the static process table. A stack is charged
+ * from spork() until the process is reaped, so a zombie keeps its stack
+ * charged (and counted as zombie bytes) until its parent joins it. During
+ * smpRun() the counters shared between CPUs are updated atomically; the
+ * peaks may then miss a concurrent spork() or two.
+ */
+
+// bytes of stack currently allocated, including zombies' stacks
+long stackBytes;
+
+// part of stackBytes held by processes that have quit but not been joined
+long zombieBytes;
+
+// highest stackBytes since phase1_init()
+long peakStackBytes;
+
+// limits; 0 means no limit
+long maxStackBytes;
+int maxChildren;
+
+/*
+ * Function: memAdmit
+ * ------------------
+ * This function checks whether 'parent' may spork a child with a stack of
+ * 'stackSize' bytes under the current limits.
+ *
+ * @return int -1: returned if a limit would be exceeded
+ *
+ * @return int 0: the child fits
+ */
+int memAdmit(struct PCB *parent, int stackSize) {
+    if (maxStackBytes > 0 && stackBytes + stackSize > maxStackBytes) {
+        return -1;
+    }
+    if (maxChildren > 0 && parent->num_children >= maxChildren) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Function: memCharge
+ * -------------------
+ * This function charges a new process's stack to the global counters and to
+ * its parent, if it has one.
+ */
+void memCharge(struct PCB *proc) {
+    long now = ATOMIC_ADD(stackBytes, proc->stack_size);
+    if (now > peakStackBytes) {
+        peakStackBytes = now;
+    }
+
+    struct PCB *parent = proc->parent;
+    if (parent != NULL) {
+        parent->num_children++;
+        parent->child_bytes += proc->stack_size;
+        if (parent->child_bytes > parent->peak_child_bytes) {
+            parent->peak_child_bytes = parent->child_bytes;
+        }
+    }
+}
+
+/*
+ * Function: memZombie
+ * -------------------
+ * This function moves a quitting process's stack into the zombie counters.
+ */
+void memZombie(struct PCB *proc) {
+    ATOMIC_ADD(zombieBytes, proc->stack_size);
+    ATOMIC_ADD(proc->parent->zombie_bytes, proc->stack_size);
+}
+
+/*
+ * Function: memRelease
+ * --------------------
+ * This function uncharges a reaped process's stack.
+ */
+void memRelease(struct PCB *proc) {
+    ATOMIC_ADD(stackBytes, -proc->stack_size);
+    ATOMIC_ADD(zombieBytes, -proc->stack_size);
+
+    struct PCB *parent = proc->parent;
+    parent->num_children--;
+    parent->child_bytes -= proc->stack_size;
+    ATOMIC_ADD(parent->zombie_bytes, -proc->stack_size);
+}
+
+/*
+ * Function: memMove
+ * -----------------
+ * This function moves a child's charges from its old parent to 'to', for
+ * orphan reparenting. Limits are not applied to the new parent.
+ */
+void memMove(struct PCB *child, struct PCB *to) {
+    struct PCB *from = child->parent;
+    int zombie = child->run_state == PROC_ZOMBIE ? child->stack_size : 0;
+
+    from->num_children--;
+    from->child_bytes -= child->stack_size;
+    from->zombie_bytes -= zombie;
+
+    to->num_children++;
+    to->child_bytes += child->stack_size;
+    to->zombie_bytes += zombie;
+    if (to->child_bytes > to->peak_child_bytes) {
+        to->peak_child_bytes = to->child_bytes;
+    }
+}
+
+/*
+ * Function: memInit
+ * -----------------
+ * This function resets the counters and removes the limits.
+ */
+void memInit(void) {
+    stackBytes = 0;
+    zombieBytes = 0;
+    peakStackBytes = 0;
+    maxStackBytes = 0;
+    maxChildren = 0;
+}
+
+/*
+ * Function: setMemLimits
+ * ----------------------
+ * This function sets the limits spork() enforces. A spork() that would go
+ * over either of them returns -3 without allocating anything.
+ *
+ * @param long maxStack: most bytes of stack the kernel may hold at once,
+ *                       zombies included; 0 for no limit
+ *
+ * @param int maxKids: most unjoined children a process may have; 0 for no
+ *                     limit
+ *
+ * @return int -1: returned if either limit is negative
+ *
+ * @return int 0: success
+ */
+int setMemLimits(long maxStack, int maxKids) {
+    checkKernelMode("setMemLimits");
+
+    if (maxStack < 0 || maxKids < 0) {
+        return -1;
+    }
+    maxStackBytes = maxStack;
+    maxChildren = maxKids;
+    return 0;
+}
+
+/*
+ * Function: getMemStats
+ * ---------------------
+ * This function reports memory use for the whole kernel or for one process.
+ * For the kernel, stackBytes/zombieBytes/peakBytes cover every stack and
+ * children counts all processes. For a process, they cover the stacks of
+ * its unjoined children, and children is how many of those there are.
+ * regionBytes is the size of all region buffers, or of those the process is
+ * attached to (shared ones included).
+ *
+ * @param int pid: process ID, or 0 for the whole kernel
+ *
+ * @param struct MemStats *stats: out-pointer filled with the counters
+ *
+ * @return int -1: returned if stats is NULL or pid is not a process
+ *
+ * @return int 0: success
+ */
+int getMemStats(int pid, struct MemStats *stats) {
+    checkKernelMode("getMemStats");
+
+    if (stats == NULL) {
+        return -1;
+    }
+
+    if (pid == 0) {
+        stats->stackBytes = stackBytes;
+        stats->zombieBytes = zombieBytes;
+        stats->peakBytes = peakStackBytes;
+        stats->children = processes;
+        stats->regionBytes = regionBytes;
+        return 0;
+    }
+
+    struct PCB *proc = pid_lookup(pid);
+    if (proc == NULL) {
+        return -1;
+    }
+    stats->stackBytes = proc->child_bytes;
+    stats->zombieBytes = proc->zombie_bytes;
+    stats->peakBytes = proc->peak_child_bytes;
+    stats->children = proc->num_children;
+    stats->regionBytes = regionAttachedBytes(proc);
+    return 0;
+}
@@ -32,6 +32,33 @@
 
 #define MAXSYSCALLS  50
 
+/*
+ * Maximum number of semaphores and mutexes, combined.
+ */
+
+#define MAXSEMS      200
+
+/*
+ * Maximum number of process groups.  Group 0 means "no group".
+ */
+
+#define MAXGROUPS    50
+
+/*
+ * Maximum number of copy-on-write regions.
+ */
+
+#define MAXREGIONS   16
+
+/*
+ * Mailbox limits: number of mailboxes, slots shared by all of them, and the
+ * largest message that is copied into a slot.
+ */
+
+#define MAXMBOX      2000
+#define MAXSLOTS     2500
+#define MAX_MESSAGE  150
+
 
 /* 
  * These functions must be provided by Phase 1.
@@ -58,6 +85,426 @@ void TEMP_switchTo(int pid);
 
 
 
+/* kernel semaphores and mutexes.  Both share one table of MAXSEMS entries
+ * and hand the resource straight to the first waiter on release.  A
+ * process that quits releases the mutexes it still holds.
+ */
+struct SyncStats {
+    int acquisitions;   /* successful SemP()/MutexLock() calls        */
+    int waits;          /* how many of those had to block             */
+    int avgWait;        /* mean time spent blocked, in microseconds   */
+    int maxWait;        /* longest time spent blocked, in microseconds */
+};
+
+extern int  SemCreate(int value);
+extern int  SemP(int sem);
+extern int  SemV(int sem);
+extern int  SemFree(int sem);
+extern int  MutexCreate(void);
+extern int  MutexLock(int mutex);
+extern int  MutexUnlock(int mutex);
+extern int  SemStats(int id, struct SyncStats *stats);
+
+
+
+/* bounded mailboxes.  A mailbox created with a slot size of 0 or more copies
+ * each message (up to that size) into a slot; 0-byte slots make a mailbox
+ * for signals only.  One created with MBOX_ZEROCOPY as its slot size passes
+ * buffers by pointer, handing ownership to the receiver.  The Cond variants
+ * return -2 instead of blocking.
+ */
+#define MBOX_ZEROCOPY (-1)
+
+extern int  MboxCreate(int numSlots, int slotSize);
+extern int  MboxRelease(int mbox);
+extern int  MboxSend(int mbox, void *msg, int msgSize);
+extern int  MboxRecv(int mbox, void *msg, int maxMsgSize);
+extern int  MboxCondSend(int mbox, void *msg, int msgSize);
+extern int  MboxCondRecv(int mbox, void *msg, int maxMsgSize);
+extern int  MboxSendBuf(int mbox, void *buf, int size);
+extern int  MboxRecvBuf(int mbox, void **buf);
+extern int  MboxCondSendBuf(int mbox, void *buf, int size);
+extern int  MboxCondRecvBuf(int mbox, void **buf);
+
+
+
+/* process groups.  A child starts in its parent's group.  kill_group()
+ * asks every member to quit (they poll isKilled()), waking blocked members
+ * with -4 from the call they are blocked in, and join_group() reaps every
+ * terminated member that is a child of the caller.
+ */
+extern int  create_group(void);
+extern int  free_group(int gid);
+extern int  set_group(int pid, int gid);
+extern int  get_group(int pid);
+extern int  kill_group(int gid);
+extern int  join_group(int gid);
+
+/* group CPU quotas.  set_group_quota() lets a group's members use 'quota'
+ * microseconds of currentTime() in every 'period' between them; a quota of
+ * 0 lifts the limit.  Once a group has used its quota it is throttled: its
+ * members leave the ready queues until the period ends.  Like stride
+ * scheduling, this takes effect at the next kernel entry after a clock
+ * tick or switch, and quotas are not enforced during smpRun().
+ * dumpProcesses() shows throttled processes and ends with dumpGroups().
+ */
+struct QuotaStats {
+    int quota;               /* microseconds per period, 0 for none      */
+    int period;              /* period length in microseconds            */
+    int used;                /* CPU charged in the current period        */
+    int throttled;           /* 1 while the group is held back           */
+    int throttles;           /* times it has been throttled              */
+    long long throttledTime; /* microseconds spent throttled, in total   */
+};
+
+extern int  set_group_quota(int gid, int quota, int period);
+extern int  groupQuotaStats(int gid, struct QuotaStats *stats);
+extern void dumpGroups(void);
+extern int  isKilled(void);
+
+
+
+/* what quit_phase_1a() does when the quitting process still has children:
+ * halt the simulation (the default) or hand them over to init.
+ */
+#define ORPHANS_HALT      0
+#define ORPHANS_REPARENT  1
+
+extern int  set_orphan_policy(int policy);
+
+
+
+/* context switch backends.  Each process keeps the backend that was current
+ * when it was sporked; init always uses USLOSS.  The native backend saves
+ * only callee-saved registers and exists on x86-64 and arm64 only.
+ */
+#define SWITCH_USLOSS  0
+#define SWITCH_NATIVE  1
+
+extern int  setSwitchBackend(int backend);
+extern int  getSwitchCount(int backend);
+
+
+
+/* sampling profiler.  profileStart() hooks the clock interrupt and records
+ * the running process (and, on the host harness, the interrupted PC) on each
+ * tick, into a buffer of the given size; dumpProfile() prints the samples as
+ * folded stacks for flame graph tools.
+ */
+extern int  profileStart(int bufferSize);
+extern int  profileStop(void);
+extern void dumpProfile(void);
+extern void profileStats(int *recorded, int *dropped, int *overhead, int *elapsed);
+
+
+
+/* latency histograms, in microseconds.  With -DLATENCY_HIST the kernel times
+ * spork(), join(), every context switch and the time from quit to reap, and
+ * prints dumpLatency() when the simulation exits; without it the kernel
+ * records nothing.  latencyRecord() can add samples either way.
+ */
+#define LAT_SPORK   0
+#define LAT_JOIN    1
+#define LAT_SWITCH  2
+#define LAT_REAP    3
+#define LAT_NUM     4
+
+extern void latencyRecord(int which, int us);
+extern int  latencyPercentile(int which, int pct);
+extern int  latencyCount(int which);
+extern void latencyReset(void);
+extern void dumpLatency(void);
+
+
+
+/* record/replay of scheduling.  schedRecordStart() logs every context switch
+ * and clock interrupt to a file as the run goes, so a run that halts keeps
+ * its log; schedLogStop() closes it.  schedReplayStart() reads one back and
+ * makes the same switches and raises the same interrupts at the same kernel
+ * calls, halting if the run stops matching the log.  Terminal interrupts
+ * are not logged, so neither starts while a terminal is busy or waited on.
+ */
+#define SCHED_LIVE    0
+#define SCHED_RECORD  1
+#define SCHED_REPLAY  2
+
+extern int  schedRecordStart(char *path);
+extern int  schedReplayStart(char *path);
+extern int  schedLogStop(void);
+extern int  schedLogSize(void);
+
+
+
+/* checks the process table's invariants (counts, child lists, ready queues);
+ * prints the first violation and returns -1, or returns 0.
+ */
+extern int  checkProcessTable(void);
+
+
+
+/* kernel memory accounting and limits.  Every process stack is charged from
+ * spork() until the process is joined.  With pid 0, getMemStats() reports
+ * the whole kernel (children = number of processes); with a pid, it reports
+ * the stacks of that process's unjoined children.  spork() returns -3 when a
+ * limit set with setMemLimits() would be exceeded (0 = no limit).
+ */
+struct MemStats {
+    long stackBytes;    /* stack bytes allocated, zombies included        */
+    long zombieBytes;   /* part of stackBytes held by unjoined zombies    */
+    long peakBytes;     /* highest stackBytes seen                        */
+    int  children;      /* processes (pid 0) or unjoined children         */
+    long regionBytes;   /* region buffers allocated (pid 0) or attached   */
+};
+
+extern int  setMemLimits(long maxStack, int maxKids);
+extern int  getMemStats(int pid, struct MemStats *stats);
+
+
+
+/* copy-on-write regions.  regionCreate() makes a zeroed buffer of the given
+ * size; spork_clone() is spork() with the child sharing all of the parent's
+ * regions.  regionGet() gives a read-only view, and regionWrite() a writable
+ * one, copying the buffer first if it is still shared.  A writable view is
+ * only good until the caller's next spork_clone(); call regionWrite() again
+ * afterwards.
+ */
+extern int   regionCreate(int size);
+extern void *regionGet(int id);
+extern void *regionWrite(int id);
+extern int   regionSize(int id);
+extern int   regionDetach(int id);
+extern int   spork_clone(char *name, int(*func)(char *), char *arg,
+                         int stacksize, int priority);
+
+
+
+/* process states.  Every process table slot is in exactly one of these at a
+ * time; processCount() says how many processes are in a state in constant
+ * time.  Builds without NDEBUG halt on a state change the kernel does not
+ * allow (for example, switching to a blocked process).
+ */
+enum ProcState {
+    PROC_FREE,       /* slot not in use                              */
+    PROC_READY,      /* on a ready queue                             */
+    PROC_RUNNING,    /* the current process                          */
+    PROC_BLOCKED,    /* waiting on a semaphore, mailbox or the clock */
+    PROC_ZOMBIE,     /* quit, not yet joined                         */
+    PROC_NUM_STATES
+};
+
+extern int  processCount(int state);
+
+
+
+/* idle process and clock sleeps.  When no process at priority 1-5 can run,
+ * the idle process (priority 7, outside the process table) waits for the
+ * next interrupt.  clockSleep() blocks the caller for a number of clock
+ * ticks.  idleStats() returns how often the idle process waited and how long
+ * it waited, for utilization figures.
+ */
+#define IDLE_WAIT  0
+#define IDLE_SPIN  1
+
+extern int  clockSleep(int ticks);
+extern int  setIdleMode(int mode);
+extern int  idleStats(int *idle, int *elapsed);
+
+
+
+/* stride scheduling.  Under POLICY_STRIDE, processes at priority 1-5 share
+ * the CPU in proportion to their tickets (DEFAULT_TICKETS each unless
+ * changed with setTickets()) instead of by priority.  The clock interrupt
+ * charges the running process; the switch happens at its next kernel call.
+ */
+#define POLICY_PRIORITY  0
+#define POLICY_STRIDE    1
+
+#define DEFAULT_TICKETS  100
+#define MAXTICKETS       10000
+
+extern int  setSchedPolicy(int policy);
+extern int  setTickets(int pid, int tickets);
+
+
+
+/* terminal output.  termWrite() copies bytes into a terminal's
+ * TERM_RING_SIZE-byte ring and returns; the terminal's transmit interrupt
+ * sends them, one character per interrupt.  A writer blocks only while the
+ * ring is full.  termFlush() waits until everything written so far has
+ * been sent.  While a schedule is recorded or replayed, both return -2
+ * instead of waiting.  termStats() reports what a terminal has sent and
+ * how long writers were held up.
+ */
+#define TERM_RING_SIZE  256
+
+struct TermStats {
+    long chars;        /* characters sent                           */
+    long interrupts;   /* transmit interrupts handled               */
+    int  stalls;       /* times a writer found the ring full        */
+    long stallTime;    /* microseconds writers spent blocked        */
+    int  queued;       /* characters in the ring, not yet sent      */
+};
+
+extern int  termWrite(int unit, char *buf, int len);
+extern int  termFlush(int unit);
+extern int  termStats(int unit, struct TermStats *stats);
+
+
+
+/* micro-tasks.  taskCreate() queues a call of func(arg, &step) at a
+ * priority, for work too short to be worth a process.  Tasks have no stack
+ * of their own: each priority has one runner, scheduled from the ready
+ * queues like a process, that calls its tasks in turn on a shared stack.  A
+ * task returns TASK_YIELD to be called again later (with step as it left
+ * it), or its exit status.  The creating process collects finished tasks
+ * with join(), which blocks while its tasks are still running.
+ */
+#define MAXTASKS    1000
+#define TASK_YIELD  (-2147483647 - 1)
+
+struct TaskStats {
+    int created;       /* tasks created since phase1_init()          */
+    int inUse;         /* task table entries not yet joined          */
+    int yields;        /* times a task returned TASK_YIELD           */
+    int taskBytes;     /* kernel memory per task                     */
+    int runnerBytes;   /* stack bytes of the runners started so far  */
+};
+
+extern int  taskCreate(int (*func)(void *arg, int *step), void *arg, int priority);
+extern int  taskStats(struct TaskStats *stats);
+
+
+
+/* per-process arenas.  proc_alloc() allocates from the calling process's
+ * own pages by bumping a pointer.  There is no free: all of a process's
+ * pages go back to the kernel's page pool at once when it is joined.
+ * arenaStats() reports on the pool.
+ */
+#define ARENA_PAGE_SIZE  4096
+#define ARENA_MAX_ALLOC  (ARENA_PAGE_SIZE - 16)
+
+struct ArenaStats {
+    int  pagesInUse;   /* pages held by processes                    */
+    int  pagesFree;    /* pages in the pool                          */
+    int  pagesTotal;   /* pages the pool has taken from the host     */
+    long allocs;       /* proc_alloc() calls that succeeded          */
+};
+
+extern void *proc_alloc(int size);
+extern int   arenaStats(struct ArenaStats *stats);
+
+
+
+/* multi-core host runs.  In host builds made with SMP=1, smpRun() runs the
+ * ready processes at priority 1-5 on 'cores' host threads, each a CPU with
+ * its own current process and work-stealing deque, and returns once every
+ * one of them (and everything they spork) has quit.  The caller waits on
+ * its own CPU meanwhile.  Only spork(), join(), quit_phase_1a(), getpid(),
+ * isKilled() and proc_alloc() may be called by the processes it runs.
+ */
+#define SMP_MAXCPUS  64
+
+struct SmpStats {
+    int quits;    /* processes that quit during the run           */
+    int steals;   /* processes a CPU took from another CPU's deque */
+    int yields;   /* times join() gave up a CPU to wait           */
+};
+
+extern int  smpRun(int cores, struct SmpStats *stats);
+
+
+
+/* directed yields.  yield_to() puts the caller at the tail of its ready
+ * queue and runs the given ready process next, without a scheduler pass:
+ * the cheapest way for a client to hand the CPU to its server.
+ * yieldStats() reports a process's counters.
+ */
+struct YieldStats {
+    int given;      /* successful yield_to() calls                */
+    int received;   /* yield_to() calls that named this process   */
+    int refused;    /* yield_to() calls that failed               */
+};
+
+extern int yield_to(int pid);
+extern int yieldStats(int pid, struct YieldStats *stats);
+
+
+
+/* waiting on several targets.  wait_any() blocks until one of 'count'
+ * targets is ready and returns its index; the lowest ready index if some
+ * are ready already.  A ready target only means the matching call would
+ * not block: join() for a child, MboxCondRecv() for a mailbox.
+ */
+#define WAIT_CHILD  0   /* id: a child's pid, or -1 for any child     */
+#define WAIT_MBOX   1   /* id: a mailbox with a message to receive    */
+#define WAIT_TICKS  2   /* id: clock interrupts from now; a timeout   */
+
+#define WAIT_MAX    16
+
+struct WaitTarget {
+    int type;
+    int id;
+};
+
+extern int wait_any(struct WaitTarget *targets, int count);
+
+
+
+/* checkpoints.  In host builds, checkpointSave() writes the whole kernel
+ * (globals, the process table and queues, and the kernel heap with every
+ * stack and context in it) to a file and returns 0.  A later run of the
+ * same binary with USLOSS_HOST_RESTORE=<file> in its environment skips
+ * boot, maps the heap back from the file and returns 1 from the same
+ * checkpointSave() call, in the process that made it.  Stack pages are read
+ * from the file only when they are touched.  The saving run must have
+ * USLOSS_HOST_CHECKPOINT set, which gives it the fixed layout a restore
+ * needs.
+ */
+extern int checkpointSave(char *path);
+
+
+
+/* system calls.  phase1_init() installs a MAXSYSCALLS-entry table on
+ * USLOSS_SYSCALL_INT.  The caller puts the call number in 'number' and the
+ * arguments of the matching kernel function in arg1..arg5, in order; the
+ * function's return value comes back in arg1.  The Sys_ wrappers below do
+ * this for user-mode code.
+ */
+#define SYS_SPORK          1
+#define SYS_JOIN           2
+#define SYS_QUIT_PHASE_1A  3
+#define SYS_GETPID         4
+#define SYS_DUMPPROCESSES  5
+#define SYS_SEMCREATE      6
+#define SYS_SEMP           7
+#define SYS_SEMV           8
+#define SYS_SEMFREE        9
+#define SYS_MBOXCREATE     10
+#define SYS_MBOXRELEASE    11
+#define SYS_MBOXSEND       12
+#define SYS_MBOXRECV       13
+
+extern int  syscallInstall(int number, void (*handler)(USLOSS_Sysargs *args));
+extern int  syscallStats(int number, int *calls, int *totalTime);
+extern void dumpSyscallStats(void);
+
+extern int  Sys_Spork(char *name, int(*func)(char *), char *arg,
+                      int stacksize, int priority);
+extern int  Sys_Join(int *status);
+extern void Sys_Quit(int status, int switchToPid) __attribute__((__noreturn__));
+extern int  Sys_GetPid(void);
+extern void Sys_DumpProcesses(void);
+extern int  Sys_SemCreate(int value);
+extern int  Sys_SemP(int sem);
+extern int  Sys_SemV(int sem);
+extern int  Sys_SemFree(int sem);
+extern int  Sys_MboxCreate(int numSlots, int slotSize);
+extern int  Sys_MboxRelease(int mbox);
+extern int  Sys_MboxSend(int mbox, void *msg, int msgSize);
+extern int  Sys_MboxRecv(int mbox, void *msg, int maxMsgSize);
+
+
+
 /* this is the main function for the init process.  The student code
  * must create a process (PID 1) use this as the main() function.
  */
@@ -0,0 +1,245 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include "kernel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Sampling profiler. While it is running, the clock interrupt records one
+ * sample per tick into a buffer allocated up front. Each sample holds the
+ * interrupted process's name and, when the platform can report it, the
+ * interrupted PC. Once the buffer is full, further ticks are only counted as
+ * dropped, so the cost per tick is bounded. The clock handler that was
+ * installed before the first profileStart() is still called on every tick.
+ * The profiler's handler stays installed once it is, and only passes ticks
+ * on while stopped, so that stopping does not unlink a handler that was
+ * installed after it.
+ */
+
+// at most this many distinct process names are kept; others share one entry
+#define MAX_PROFILE_NAMES 64
+
+struct Sample {
+    short name; // index into profileNames
+    unsigned long pc; // interrupted PC, 0 if unknown
+};
+
+// the host harness defines this; under USLOSS it is absent and PCs are 0
+extern unsigned long hostInterruptedPc(void) __attribute__((weak));
+
+static void (*chainedClockHandler)(int dev, void *arg);
+static int hooked; // profileClockHandler is installed
+
+static struct Sample *samples;
+static int maxSamples;
+static int numSamples;
+static int droppedSamples;
+static long long handlerTime; // microseconds spent in profileClockHandler
+static int profileStartTime;
+static int profileElapsed;
+static int profiling;
+
+static char profileNames[MAX_PROFILE_NAMES][MAXNAME+1];
+static int numProfileNames;
+
+// last name index recorded for each process table slot, to skip the lookup
+static int slotPid[MAXPROC];
+static short slotName[MAXPROC];
+
+/*
+ * Function: internName
+ * --------------------
+ * This function returns the index of a process name in profileNames, adding
+ * it if it is new. Once the table is full, new names map to the last entry.
+ */
+static short internName(char *name) {
+    int i;
+
+    for (i = 0; i < numProfileNames; i++) {
+        if (strcmp(profileNames[i], name) == 0) {
+            return i;
+        }
+    }
+    if (numProfileNames == MAX_PROFILE_NAMES) {
+        return MAX_PROFILE_NAMES - 1;
+    }
+    strcpy(profileNames[numProfileNames], numProfileNames == MAX_PROFILE_NAMES - 1 ? "[other]" : name);
+    return numProfileNames++;
+}
+
+/*
+ * Function: profileClockHandler
+ * -----------------------------
+ * This function is installed on USLOSS_CLOCK_INT by the first
+ * profileStart(). While profiling it records one sample; either way it then
+ * runs the handler it replaced.
+ */
+static void profileClockHandler(int dev, void *arg) {
+    if (!profiling) {
+        if (chainedClockHandler != NULL) {
+            chainedClockHandler(dev, arg);
+        }
+        return;
+    }
+
+    int start = currentTime();
+
+    if (numSamples < maxSamples) {
+        struct Sample *s = &samples[numSamples++];
+
+        if (curProcess == NULL) {
+            s->name = internName("[idle]");
+        }
+        else {
+            int slot = PID_SLOT(curProcess->pid);
+            if (slotPid[slot] != curProcess->pid) {
+                slotPid[slot] = curProcess->pid;
+                slotName[slot] = internName(curProcess->name);
+            }
+            s->name = slotName[slot];
+        }
+        s->pc = (hostInterruptedPc != NULL) ? hostInterruptedPc() : 0;
+    }
+    else {
+        droppedSamples++;
+    }
+
+    handlerTime += currentTime() - start;
+
+    if (chainedClockHandler != NULL) {
+        chainedClockHandler(dev, arg);
+    }
+}
+
+/*
+ * Function: profileStart
+ * ----------------------
+ * This function starts the profiler with room for 'bufferSize' samples,
+ * throwing away the samples of any earlier run.
+ *
+ * @param int bufferSize: maximum number of samples to keep
+ *
+ * @return int -1: returned if the profiler is already running, bufferSize is
+ *                 not positive, or the buffer cannot be allocated
+ *
+ * @return int 0: success
+ */
+int profileStart(int bufferSize) {
+    checkKernelMode("profileStart");
+
+    if (profiling || bufferSize <= 0) {
+        return -1;
+    }
+
+    kernelFree(samples);
+    samples = kernelAlloc(bufferSize * sizeof(struct Sample));
+    if (samples == NULL) {
+        return -1;
+    }
+    maxSamples = bufferSize;
+    numSamples = 0;
+    droppedSamples = 0;
+    handlerTime = 0;
+    numProfileNames = 0;
+    memset(slotPid, 0, sizeof(slotPid));
+
+    if (!hooked) {
+        chainedClockHandler = USLOSS_IntVec[USLOSS_CLOCK_INT];
+        USLOSS_IntVec[USLOSS_CLOCK_INT] = profileClockHandler;
+        hooked = 1;
+    }
+    profileStartTime = currentTime();
+    profiling = 1;
+    return 0;
+}
+
+/*
+ * Function: profileStop
+ * ---------------------
+ * This function stops the profiler; its clock handler stays installed and
+ * only passes ticks on. The samples are kept until the next profileStart().
+ *
+ * @return int -1: returned if the profiler is not running
+ *
+ * @return int >=0: number of samples recorded
+ */
+int profileStop(void) {
+    checkKernelMode("profileStop");
+
+    if (!profiling) {
+        return -1;
+    }
+    profileElapsed = currentTime() - profileStartTime;
+    profiling = 0;
+    return numSamples;
+}
+
+static int compareSamples(const void *a, const void *b) {
+    const struct Sample *x = a, *y = b;
+
+    if (x->name != y->name) {
+        return x->name - y->name;
+    }
+    if (x->pc != y->pc) {
+        return x->pc < y->pc ? -1 : 1;
+    }
+    return 0;
+}
+
+/*
+ * Function: dumpProfile
+ * ---------------------
+ * This function prints the samples of the last run in folded-stack format,
+ * one "name;pc count" line per distinct name and PC ("name count" when the
+ * PC is unknown), which flamegraph.pl and speedscope read directly.
+ */
+void dumpProfile(void) {
+    checkKernelMode("dumpProfile");
+
+    int i, run;
+
+    qsort(samples, numSamples, sizeof(struct Sample), compareSamples);
+
+    for (i = 0; i < numSamples; i += run) {
+        for (run = 1; i + run < numSamples && compareSamples(&samples[i], &samples[i + run]) == 0; run++) {
+        }
+        if (samples[i].pc == 0) {
+            USLOSS_Console("%s %d\n", profileNames[samples[i].name], run);
+        }
+        else {
+            USLOSS_Console("%s;0x%lx %d\n", profileNames[samples[i].name], samples[i].pc, run);
+        }
+    }
+}
+
+/*
+ * Function: profileStats
+ * ----------------------
+ * This function reports the size and cost of the current or last run. Any
+ * out-pointer may be NULL.
+ *
+ * @param int *recorded: number of samples in the buffer
+ *
+ * @param int *dropped: ticks that arrived after the buffer was full
+ *
+ * @param int *overhead: time spent inside the profiler's clock handler, in
+ *                       microseconds
+ *
+ * @param int *elapsed: time since profileStart() (up to profileStop() if it
+ *                      has been called), in microseconds
+ */
+void profileStats(int *recorded, int *dropped, int *overhead, int *elapsed) {
+    if (recorded != NULL) {
+        *recorded = numSamples;
+    }
+    if (dropped != NULL) {
+        *dropped = droppedSamples;
+    }
+    if (overhead != NULL) {
+        *overhead = (int) handlerTime;
+    }
+    if (elapsed != NULL) {
+        *elapsed = profiling ? currentTime() - profileStartTime : profileElapsed;
+    }
+}
@@ -0,0 +1,260 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include "kernel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Copy-on-write memory regions. A region is a kernel-allocated buffer that a
+ * process reaches through regionGet()/regionWrite() by region ID. A child
+ * made with spork_clone() starts out pointing at the same buffers as its
+ * parent; the first regionWrite() by either side on a shared buffer gives
+ * that process its own copy. Buffers are reference counted and freed when
+ * the last process lets go of them. The tables are not locked, so every
+ * call here fails while smpRun() is running, and smpRun() does not start
+ * while a ready process is attached to a region.
+ */
+
+struct Region {
+    int refs; // processes pointing at this buffer
+    int size; // bytes in data
+    char data[];
+};
+
+// number of processes attached to each region ID; 0 means the ID is free
+static int regionUsers[MAXREGIONS];
+
+// bytes of region buffers currently allocated
+long regionBytes;
+
+static struct Region *newBuffer(int size) {
+    struct Region *r = kernelAlloc(sizeof(struct Region) + size);
+    if (r != NULL) {
+        r->refs = 1;
+        r->size = size;
+        regionBytes += size;
+    }
+    return r;
+}
+
+static void dropBuffer(struct Region *r) {
+    if (--r->refs == 0) {
+        regionBytes -= r->size;
+        kernelFree(r);
+    }
+}
+
+/*
+ * Function: regionCreate
+ * ----------------------
+ * This function creates a zero-filled region and attaches the current
+ * process to it.
+ *
+ * @param int size: size of the region in bytes
+ *
+ * @return int -1: returned if size is not positive, all region IDs are in
+ *                 use, the buffer cannot be allocated, or smpRun() is
+ *                 active
+ *
+ * @return int >=0: region ID
+ */
+int regionCreate(int size) {
+    checkKernelMode("regionCreate");
+
+    int id;
+
+    if (size <= 0 || smpActive) {
+        return -1;
+    }
+    for (id = 0; id < MAXREGIONS && regionUsers[id] != 0; id++) {
+    }
+    if (id == MAXREGIONS) {
+        return -1;
+    }
+
+    struct Region *r = newBuffer(size);
+    if (r == NULL) {
+        return -1;
+    }
+    memset(r->data, 0, size);
+    curProcess->regions[id] = r;
+    regionUsers[id] = 1;
+    return id;
+}
+
+/*
+ * Function: regionGet
+ * -------------------
+ * This function returns the current process's view of a region for reading.
+ * The memory may be shared with other processes and must not be written;
+ * use regionWrite() for that.
+ *
+ * @param int id: region ID
+ *
+ * @return void *: the data, or NULL if the process is not attached to id or
+ *                 smpRun() is active
+ */
+void *regionGet(int id) {
+    checkKernelMode("regionGet");
+
+    if (smpActive || id < 0 || id >= MAXREGIONS || curProcess->regions[id] == NULL) {
+        return NULL;
+    }
+    return curProcess->regions[id]->data;
+}
+
+/*
+ * Function: regionWrite
+ * ---------------------
+ * This function returns a writable view of a region. If the buffer is
+ * shared, the current process first gets a private copy, so the other
+ * processes keep seeing the old contents. The pointer is only good until
+ * the caller's next spork_clone(): the child shares the buffer it points
+ * into, so writes through it would show up in the child too. Call
+ * regionWrite() again after cloning, which makes the copy.
+ *
+ * @param int id: region ID
+ *
+ * @return void *: the data, or NULL if the process is not attached to id,
+ *                 the copy cannot be allocated, or smpRun() is active
+ */
+void *regionWrite(int id) {
+    checkKernelMode("regionWrite");
+
+    if (smpActive || id < 0 || id >= MAXREGIONS || curProcess->regions[id] == NULL) {
+        return NULL;
+    }
+
+    struct Region *r = curProcess->regions[id];
+    if (r->refs > 1) {
+        struct Region *copy = newBuffer(r->size);
+        if (copy == NULL) {
+            return NULL;
+        }
+        memcpy(copy->data, r->data, r->size);
+        dropBuffer(r);
+        curProcess->regions[id] = copy;
+        r = copy;
+    }
+    return r->data;
+}
+
+/*
+ * Function: regionSize
+ * --------------------
+ * This function reports the size of a region the current process is
+ * attached to.
+ *
+ * @return int -1: returned if the process is not attached to id or smpRun()
+ *                 is active
+ *
+ * @return int >0: size in bytes
+ */
+int regionSize(int id) {
+    checkKernelMode("regionSize");
+
+    if (smpActive || id < 0 || id >= MAXREGIONS || curProcess->regions[id] == NULL) {
+        return -1;
+    }
+    return curProcess->regions[id]->size;
+}
+
+/*
+ * Function: regionDetach
+ * ----------------------
+ * This function detaches the current process from a region. The ID becomes
+ * free once no process is attached.
+ *
+ * @return int -1: returned if the process is not attached to id or smpRun()
+ *                 is active
+ *
+ * @return int 0: success
+ */
+int regionDetach(int id) {
+    checkKernelMode("regionDetach");
+
+    if (smpActive || id < 0 || id >= MAXREGIONS || curProcess->regions[id] == NULL) {
+        return -1;
+    }
+    dropBuffer(curProcess->regions[id]);
+    curProcess->regions[id] = NULL;
+    regionUsers[id]--;
+    return 0;
+}
+
+/*
+ * Function: regionShare
+ * ---------------------
+ * This function attaches a new child to every region its parent is attached
+ * to, sharing the parent's buffers.
+ */
+void regionShare(struct PCB *parent, struct PCB *child) {
+    int id;
+
+    for (id = 0; id < MAXREGIONS; id++) {
+        if (parent->regions[id] != NULL) {
+            child->regions[id] = parent->regions[id];
+            child->regions[id]->refs++;
+            regionUsers[id]++;
+        }
+    }
+}
+
+/*
+ * Function: regionRelease
+ * -----------------------
+ * This function detaches a process from all of its regions; called when it
+ * quits.
+ */
+void regionRelease(struct PCB *proc) {
+    int id;
+
+    for (id = 0; id < MAXREGIONS; id++) {
+        if (proc->regions[id] != NULL) {
+            dropBuffer(proc->regions[id]);
+            proc->regions[id] = NULL;
+            regionUsers[id]--;
+        }
+    }
+}
+
+/*
+ * Function: regionAttachedBytes
+ * -----------------------------
+ * This function adds up the sizes of the buffers a process is attached to.
+ */
+long regionAttachedBytes(struct PCB *proc) {
+    long bytes = 0;
+    int id;
+
+    for (id = 0; id < MAXREGIONS; id++) {
+        if (proc->regions[id] != NULL) {
+            bytes += proc->regions[id]->size;
+        }
+    }
+    return bytes;
+}
+
+/*
+ * Function: spork_clone
+ * ---------------------
+ * This function is spork(), except that the child starts out attached to
+ * all of the parent's regions, sharing their contents until one side writes.
+ * Parameters and return values are the same as spork()'s, except that it
+ * returns -1 while smpRun() is active, since another CPU could run the
+ * child before it is attached.
+ */
+int spork_clone(char *name, int(*startFunc)(char *), char *arg, int stacksize, int priority) {
+    checkKernelMode("spork_clone");
+
+    if (smpActive) {
+        return -1;
+    }
+
+    int pid = spork(name, startFunc, arg, stacksize, priority);
+    if (pid > 0) {
+        regionShare(curProcess, pid_lookup(pid));
+    }
+    return pid;
+}
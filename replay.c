@@ -0,0 +1,420 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include "kernel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Record and replay of scheduling. In record mode every context switch and
+ * every clock interrupt is appended to the log file as it happens, so a run
+ * that halts leaves its log behind: the stdio buffer is flushed with every
+ * interrupt logged, and by exit() when the simulation halts. A run that
+ * crashes loses the switches made since the last interrupt was logged. The
+ * clock handler only counts ticks; they are logged from kernel context, at
+ * the next kernel entry or switch, with interrupts disabled. In replay mode
+ * the log is read back: each switch is forced to the recorded process, live
+ * clock interrupts are dropped, and the recorded ones are raised again at
+ * the same point.
+ *
+ * Terminal interrupts are not logged. They only matter to scheduling when
+ * they wake a writer, so a log cannot start while a terminal is busy or
+ * waited on, and termWrite() and termFlush() refuse to wait meanwhile.
+ *
+ * Positions are measured in kernel entries (calls to checkKernelMode()). An
+ * interrupt recorded after the n-th entry is replayed at the start of entry
+ * n+1, so it lands between the same two kernel calls.
+ *
+ * Processes that already existed when recording started are logged by pid
+ * and ones created later by their pid's offset from the first pid handed out
+ * after the start, so that a replay can begin at a later point of a run
+ * (with new pids) as long as it makes the same calls.
+ *
+ * The log is "SCHD", a version byte, and then one unsigned LEB128 varint per
+ * event:
+ *   switch     (zigzag(id - previous switch id) << 1) | 0
+ *   interrupt  ((entries - entries at previous interrupt) << 1) | 1
+ * so a typical switch or tick takes a single byte.
+ */
+
+#define SCHED_MAGIC   "SCHD"
+#define SCHED_VERSION 1
+
+// kernel entries so far, counted by checkKernelMode()
+unsigned int kernelEntries;
+
+// SCHED_LIVE, SCHED_RECORD or SCHED_REPLAY
+int schedMode = SCHED_LIVE;
+
+static unsigned char *logBuf; // replay: the whole log
+static int logLen; // bytes written (record) or read (replay)
+static int logCap; // bytes in the file (replay)
+static FILE *logFile; // record: the log being written
+
+// record: clock ticks not logged yet, counted by schedClockHandler()
+static volatile int ticksPending;
+
+static int basePid; // first pid handed out after the log started
+static int lastId; // id of the previous switch event
+static unsigned int lastIntEntries; // kernelEntries at the previous interrupt
+static int numEvents;
+
+// replay: the next undelivered interrupt, or 0 if none is pending
+static int intPending;
+static unsigned int intAt;
+
+static void (*chainedClockHandler)(int dev, void *arg);
+static int hooked; // schedClockHandler is installed
+
+/*
+ * The log's name for a process: -pid for processes older than the log, and
+ * 1, 2, ... for the ones sporked after it started.
+ */
+static int pidToId(int pid) {
+    return pid >= basePid ? pid - basePid + 1 : -pid;
+}
+
+static int idToPid(int id) {
+    return id > 0 ? id + basePid - 1 : -id;
+}
+
+static void logByte(unsigned char b) {
+    putc(b, logFile);
+    logLen++;
+}
+
+static void logVarint(unsigned int v) {
+    while (v >= 0x80) {
+        logByte((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    logByte(v);
+}
+
+/*
+ * Function: readVarint
+ * --------------------
+ * This function decodes the next varint of a replayed log.
+ *
+ * @return int -1: returned at the end of the log
+ *
+ * @return int 0: *v holds the value
+ */
+static int readVarint(unsigned int *v) {
+    int shift = 0;
+
+    *v = 0;
+    while (logLen < logCap && shift < 35) {
+        unsigned char b = logBuf[logLen++];
+        *v |= (unsigned int) (b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            return 0;
+        }
+        shift += 7;
+    }
+    return -1;
+}
+
+/*
+ * Function: divergence
+ * --------------------
+ * This function stops a replay that no longer matches its log.
+ */
+static void divergence(char *what, int expected, int actual) {
+    USLOSS_Console("ERROR: replay diverged at event %d (kernel entry %u): expected %s %d, got %d.\n",
+                   numEvents, kernelEntries, what, expected, actual);
+    USLOSS_Halt(1);
+}
+
+/*
+ * Function: peekInterrupt
+ * -----------------------
+ * This function loads the position of the next recorded interrupt, if the
+ * next event in the log is one.
+ */
+static void peekInterrupt(void) {
+    int save = logLen;
+    unsigned int v;
+
+    intPending = 0;
+    if (readVarint(&v) == 0 && (v & 1)) {
+        intPending = 1;
+        intAt = lastIntEntries + (v >> 1);
+    }
+    else {
+        logLen = save;
+    }
+}
+
+/*
+ * Function: schedClockHandler
+ * ---------------------------
+ * This function is installed on USLOSS_CLOCK_INT by the first recording or
+ * replay, and stays installed, so that stopping does not unlink a handler
+ * installed after it. Recording counts the tick for schedLogInterrupts()
+ * and passes it on; it cannot log it here, since it may have interrupted a
+ * write to the log. Replaying drops it, since the recorded ticks are raised
+ * by schedReplayInterrupts() instead. Otherwise it only passes it on.
+ */
+static void schedClockHandler(int dev, void *arg) {
+    if (schedMode == SCHED_REPLAY) {
+        return;
+    }
+
+    if (schedMode == SCHED_RECORD) {
+        ticksPending++;
+    }
+
+    if (chainedClockHandler != NULL) {
+        chainedClockHandler(dev, arg);
+    }
+}
+
+/*
+ * Function: schedLogInterrupts
+ * ----------------------------
+ * This function logs the ticks counted since the last call, as interrupts
+ * after the kernelEntries-th entry, and flushes the log file; called while
+ * recording at every kernel entry, before it is counted, and before every
+ * switch is logged.
+ */
+void schedLogInterrupts(void) {
+    unsigned int oldPsr;
+
+    if (ticksPending == 0) {
+        return;
+    }
+    oldPsr = USLOSS_PsrGet();
+    USLOSS_PsrSet(oldPsr & ~USLOSS_PSR_CURRENT_INT);
+
+    while (ticksPending > 0) {
+        logVarint(((kernelEntries - lastIntEntries) << 1) | 1);
+        lastIntEntries = kernelEntries;
+        numEvents++;
+        ticksPending--;
+    }
+    fflush(logFile);
+
+    USLOSS_PsrSet(oldPsr);
+}
+
+/*
+ * Function: raisePending
+ * ----------------------
+ * This function raises the pending recorded interrupt and loads the next.
+ */
+static void raisePending(void) {
+    lastIntEntries = intAt;
+    numEvents++;
+    if (chainedClockHandler != NULL) {
+        chainedClockHandler(USLOSS_CLOCK_DEV, NULL);
+    }
+    peekInterrupt();
+}
+
+/*
+ * Function: schedReplayInterrupts
+ * -------------------------------
+ * This function is called on every kernel entry during a replay and raises
+ * each recorded interrupt whose position has been passed.
+ */
+void schedReplayInterrupts(void) {
+    while (intPending && kernelEntries > intAt) {
+        raisePending();
+    }
+}
+
+/*
+ * Function: schedDecision
+ * -----------------------
+ * This function is called for every context switch with the process the
+ * kernel is about to run. Recording logs it. Replaying checks it against the
+ * log: a dispatcher choice is replaced by the recorded process, so that the
+ * replay makes the same choice even where live timing would differ, while a
+ * switch the caller asked for by pid must match exactly.
+ *
+ * @param struct PCB *next: process the kernel is about to run
+ *
+ * @param int chosen: 1 if the dispatcher picked 'next', 0 if it was named by
+ *                    TEMP_switchTo() or quit_phase_1a()
+ *
+ * @return struct PCB *: process to actually run
+ */
+struct PCB *schedDecision(struct PCB *next, int chosen) {
+    unsigned int v;
+
+    if (schedMode == SCHED_RECORD) {
+        schedLogInterrupts();
+
+        int id = pidToId(next->pid);
+        int delta = id - lastId;
+        logVarint((((unsigned int) delta << 1) ^ (unsigned int) (delta >> 31)) << 1);
+        lastId = id;
+        numEvents++;
+        return next;
+    }
+
+    // interrupts logged before this switch arrived inside the kernel call
+    // that is making it, so they are raised now rather than at the next one
+    while (intPending) {
+        raisePending();
+    }
+
+    if (readVarint(&v) < 0) {
+        divergence("end of log at a switch to pid", -1, next->pid);
+    }
+    unsigned int zz = v >> 1;
+    int id = lastId + (int) ((zz >> 1) ^ -(zz & 1));
+    int pid = idToPid(id);
+    struct PCB *proc = pid_lookup(pid);
+    if (proc != next && (!chosen || proc == NULL || proc->run_state != PROC_READY)) {
+        divergence("a switch to pid", pid, next->pid);
+    }
+
+    lastId = id;
+    numEvents++;
+    peekInterrupt();
+    return proc;
+}
+
+static void schedBegin(int mode) {
+    basePid = PID;
+    ticksPending = 0;
+    lastId = 0;
+    lastIntEntries = kernelEntries;
+    numEvents = 0;
+    if (!hooked) {
+        chainedClockHandler = USLOSS_IntVec[USLOSS_CLOCK_INT];
+        USLOSS_IntVec[USLOSS_CLOCK_INT] = schedClockHandler;
+        hooked = 1;
+    }
+    schedMode = mode;
+}
+
+/*
+ * Function: schedRecordStart
+ * --------------------------
+ * This function starts logging scheduling decisions and clock interrupts
+ * to 'path'. The file is written as the run goes, and closed by
+ * schedLogStop() or when the simulation halts.
+ *
+ * @param char *path: file to write the log to
+ *
+ * @return int -1: returned if path is NULL, a recording or replay is
+ *                 already active, a terminal has a character out or a
+ *                 process waiting (see termWrite()), or the file cannot be
+ *                 created
+ *
+ * @return int 0: success
+ */
+int schedRecordStart(char *path) {
+    checkKernelMode("schedRecordStart");
+
+    if (path == NULL || schedMode != SCHED_LIVE || termBusy() || termWaiting()) {
+        return -1;
+    }
+
+    logFile = fopen(path, "wb");
+    if (logFile == NULL) {
+        return -1;
+    }
+    logLen = 0;
+    logByte(SCHED_MAGIC[0]);
+    logByte(SCHED_MAGIC[1]);
+    logByte(SCHED_MAGIC[2]);
+    logByte(SCHED_MAGIC[3]);
+    logByte(SCHED_VERSION);
+    schedBegin(SCHED_RECORD);
+    return 0;
+}
+
+/*
+ * Function: schedReplayStart
+ * --------------------------
+ * This function loads a log written by a recording and forces the following
+ * scheduling decisions and clock interrupts to match it. The run must make
+ * the same kernel calls as the recorded one, starting from the same point;
+ * any mismatch halts the simulation with a divergence report.
+ *
+ * @param char *path: log file to replay
+ *
+ * @return int -1: returned if path is NULL, a recording or replay is already
+ *                 active, a terminal has a character out or a process
+ *                 waiting, or the file cannot be read
+ *
+ * @return int -2: returned if the file is not a schedule log
+ *
+ * @return int 0: success
+ */
+int schedReplayStart(char *path) {
+    checkKernelMode("schedReplayStart");
+
+    if (path == NULL || schedMode != SCHED_LIVE || termBusy() || termWaiting()) {
+        return -1;
+    }
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    kernelFree(logBuf);
+    logBuf = kernelAlloc(size > 0 ? size : 1);
+    logCap = fread(logBuf, 1, size, f);
+    fclose(f);
+
+    if (logCap < 5 || memcmp(logBuf, SCHED_MAGIC, 4) != 0 || logBuf[4] != SCHED_VERSION) {
+        logCap = 0;
+        return -2;
+    }
+    logLen = 5;
+    schedBegin(SCHED_REPLAY);
+    peekInterrupt();
+    return 0;
+}
+
+/*
+ * Function: schedLogStop
+ * ----------------------
+ * This function ends a recording, closing its log file, or ends a replay.
+ *
+ * @return int -1: returned if nothing is active or the log cannot be written
+ *
+ * @return int -2: returned if a replay stops before the end of its log
+ *
+ * @return int >=0: number of events recorded or replayed
+ */
+int schedLogStop(void) {
+    checkKernelMode("schedLogStop");
+
+    int mode = schedMode;
+    if (mode == SCHED_LIVE) {
+        return -1;
+    }
+    if (mode == SCHED_RECORD) {
+        schedLogInterrupts();
+    }
+    schedMode = SCHED_LIVE;
+
+    if (mode == SCHED_REPLAY) {
+        return (logLen < logCap || intPending) ? -2 : numEvents;
+    }
+
+    int ok = !ferror(logFile);
+    ok = fclose(logFile) == 0 && ok;
+    logFile = NULL;
+    return ok ? numEvents : -1;
+}
+
+/*
+ * Function: schedLogSize
+ * ----------------------
+ * This function reports the size of the current or last log in bytes,
+ * including the 5-byte header.
+ */
+int schedLogSize(void) {
+    return schedMode == SCHED_REPLAY ? logCap : logLen;
+}
@@ -0,0 +1,320 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include "kernel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Multi-core runs for host builds made with SMP=1 (-DHOST_SMP). smpRun()
+ * hands the ready processes at priority 1-5 to a number of host threads,
+ * one per CPU. Each CPU has its own curProcess and PSR (thread-local in these
+ * builds) and a Chase-Lev deque of ready processes: it pushes and pops at
+ * the bottom of its own deque and, when that is empty, steals from the top
+ * of another CPU's. A process always runs from and returns to its CPU's
+ * scheduler context, so after yielding it may resume on another thread.
+ *
+ * There is no kernel lock. spork() claims a slot by swapping its pid in
+ * from 0, the counters shared between CPUs are updated with the ATOMIC_
+ * macros, and each process's own fields and child list are only written by
+ * the CPU running it. A quitting process becomes a zombie only once its
+ * CPU is back on the scheduler stack, so its parent may join it (and free
+ * the stack) from any CPU.
+ *
+ * Only spork(), join(), quit_phase_1a(), getpid(), isKilled() and
+ * proc_alloc() may be called from the CPUs; the rest of the kernel is not
+ * locked. What is enforced: smpRun() does not start under POLICY_STRIDE,
+ * record/replay or the native backend, or while a ready process is in a
+ * group or attached to a region. During the run, blocking or switching by
+ * hand halts, as does quitting with children; yield_to(), taskCreate(),
+ * spork_clone(), checkpointSave() and the region calls return -1; and
+ * kill_group() only marks the members. Nothing else is checked: the
+ * mailbox, semaphore and mutex calls that do not block, and the other group
+ * calls, run unlocked and must not be made.
+ */
+
+// set while smpRun() is running; readyProcess() and quit check it
+volatile int smpActive;
+
+#ifdef HOST_SMP
+
+#include <pthread.h>
+#include <sched.h>
+
+// a power of two above MAXPROC, so a deque can never fill
+#define DEQUE_SIZE  64
+#define DEQUE_MASK  (DEQUE_SIZE - 1)
+
+/*
+ * Chase-Lev work-stealing deque. The owning CPU pushes and pops at bottom;
+ * others steal at top. Only the last entry is ever contended, and a
+ * compare-and-swap on top settles who gets it.
+ */
+struct Deque {
+    long top;
+    long bottom;
+    struct PCB *slots[DEQUE_SIZE];
+};
+
+struct Cpu {
+    int id;
+    pthread_t thread;
+    USLOSS_Context sched; // scheduler context; processes switch back here
+    int reason; // SMP_YIELD or SMP_QUIT, from the process that switched out
+    struct Deque ready;
+    int quits;
+    int steals;
+    int yields;
+} __attribute__((aligned(64)));
+
+static struct Cpu cpus[SMP_MAXCPUS];
+static int numCpus;
+
+// the CPU this host thread is; NULL outside smpRun()'s threads
+static __thread struct Cpu *thisCpu;
+
+// processes handed out or sporked during the run that have not quit yet
+static int smpLive;
+
+// the PSR smpRun() was called with; each CPU's own PSR starts out as this
+static unsigned int smpPsr;
+
+static void dequePush(struct Deque *q, struct PCB *proc) {
+    long b = __atomic_load_n(&q->bottom, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&q->slots[b & DEQUE_MASK], proc, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+}
+
+static struct PCB *dequePop(struct Deque *q) {
+    long b = __atomic_load_n(&q->bottom, __ATOMIC_RELAXED) - 1;
+    long t;
+    struct PCB *proc = NULL;
+
+    __atomic_store_n(&q->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    t = __atomic_load_n(&q->top, __ATOMIC_RELAXED);
+
+    if (t <= b) {
+        proc = __atomic_load_n(&q->slots[b & DEQUE_MASK], __ATOMIC_RELAXED);
+        if (t == b) {
+            // the last entry: race the thieves for it
+            if (!__atomic_compare_exchange_n(&q->top, &t, t + 1, 0,
+                                             __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+                proc = NULL;
+            }
+            __atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+        }
+    }
+    else {
+        __atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+    return proc;
+}
+
+static struct PCB *dequeSteal(struct Deque *q) {
+    long t = __atomic_load_n(&q->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long b = __atomic_load_n(&q->bottom, __ATOMIC_ACQUIRE);
+
+    if (t < b) {
+        struct PCB *proc = __atomic_load_n(&q->slots[t & DEQUE_MASK], __ATOMIC_RELAXED);
+        if (__atomic_compare_exchange_n(&q->top, &t, t + 1, 0,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            return proc;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Function: stealWork
+ * -------------------
+ * This function tries each other CPU's deque once, starting with the next
+ * CPU up, and returns the first process it manages to take, or NULL.
+ */
+static struct PCB *stealWork(struct Cpu *cpu) {
+    int i;
+
+    for (i = 1; i < numCpus; i++) {
+        struct PCB *proc = dequeSteal(&cpus[(cpu->id + i) % numCpus].ready);
+        if (proc != NULL) {
+            cpu->steals++;
+            return proc;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Function: cpuMain
+ * -----------------
+ * This function is one CPU's scheduler loop. It runs ready processes until
+ * every process of the run has quit. A process that yielded is held back
+ * until the CPU has found something else to run, so a parent waiting in
+ * join() does not keep its children off a CPU.
+ */
+static void *cpuMain(void *arg) {
+    struct Cpu *cpu = arg;
+    struct PCB *yielded = NULL;
+
+    thisCpu = cpu;
+    USLOSS_PsrSet(smpPsr);
+    while (ATOMIC_LOAD(smpLive) > 0) {
+        struct PCB *proc = dequePop(&cpu->ready);
+        if (proc == NULL) {
+            proc = stealWork(cpu);
+        }
+        if (yielded != NULL) {
+            if (proc == NULL) {
+                proc = yielded;
+            }
+            else {
+                dequePush(&cpu->ready, yielded);
+            }
+            yielded = NULL;
+        }
+        if (proc == NULL) {
+            sched_yield();
+            continue;
+        }
+
+        setState(proc, PROC_RUNNING);
+        curProcess = proc;
+        USLOSS_ContextSwitch(&cpu->sched, &proc->state);
+        curProcess = NULL;
+
+        if (cpu->reason == SMP_QUIT) {
+            setState(proc, PROC_ZOMBIE);
+            cpu->quits++;
+            ATOMIC_ADD(smpLive, -1);
+        }
+        else {
+            setState(proc, PROC_READY);
+            cpu->yields++;
+            yielded = proc;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Function: smpPush
+ * -----------------
+ * This function puts a newly ready process on the current CPU's deque;
+ * called by readyProcess() during smpRun().
+ */
+void smpPush(struct PCB *proc) {
+    ATOMIC_ADD(smpLive, 1);
+    dequePush(&thisCpu->ready, proc);
+}
+
+/*
+ * Function: smpSwitchOut
+ * ----------------------
+ * This function gives the current process's CPU back to its scheduler
+ * loop. After SMP_YIELD the process is ready again and returns from here,
+ * maybe on another CPU; after SMP_QUIT it never returns.
+ */
+void smpSwitchOut(int reason) {
+    struct Cpu *cpu = thisCpu;
+
+    cpu->reason = reason;
+    USLOSS_ContextSwitch(&curProcess->state, &cpu->sched);
+}
+
+/*
+ * Function: smpRun
+ * ----------------
+ * This function runs every ready process at priority 1-5 on 'cores' host
+ * threads, dealt out round robin, and waits until all of them, and any
+ * processes they spork, have quit. The zombies are left for their parents
+ * to join. The caller keeps its own CPU, waiting, the whole time.
+ *
+ * @param int cores: number of CPUs, 1 to SMP_MAXCPUS
+ *
+ * @param struct SmpStats *stats: out-pointer filled with totals over all
+ *                                CPUs; may be NULL
+ *
+ * @return int -1: returned if cores is out of range, the build has no
+ *                 HOST_SMP, or the kernel is in a mode smpRun() does not
+ *                 support (see above)
+ *
+ * @return int >=0: number of processes that quit during the run
+ */
+int smpRun(int cores, struct SmpStats *stats) {
+    checkKernelMode("smpRun");
+
+    int i, dealt = 0;
+
+    if (cores < 1 || cores > SMP_MAXCPUS || smpActive || schedPolicy != POLICY_PRIORITY ||
+        schedMode != SCHED_LIVE || switchBackend != SWITCH_USLOSS) {
+        return -1;
+    }
+    for (i = 0; i < MAXPROC; i++) {
+        struct PCB *proc = &pTable[i];
+        if (proc->run_state == PROC_READY && proc->priority <= 5 &&
+            (proc->backend != SWITCH_USLOSS || proc->group != 0 ||
+             regionAttachedBytes(proc) != 0)) {
+            return -1;
+        }
+    }
+
+    memset(cpus, 0, sizeof(cpus));
+    numCpus = cores;
+    for (i = 0; i < cores; i++) {
+        cpus[i].id = i;
+    }
+    for (i = 0; i < MAXPROC; i++) {
+        struct PCB *proc = &pTable[i];
+        if (proc->run_state == PROC_READY && proc->priority <= 5) {
+            unreadyProcess(proc);
+            dequePush(&cpus[dealt % cores].ready, proc);
+            dealt++;
+        }
+    }
+
+    smpLive = dealt;
+    smpPsr = USLOSS_PsrGet();
+    smpActive = 1;
+    for (i = 0; i < cores; i++) {
+        pthread_create(&cpus[i].thread, NULL, cpuMain, &cpus[i]);
+    }
+    for (i = 0; i < cores; i++) {
+        pthread_join(cpus[i].thread, NULL);
+    }
+    smpActive = 0;
+
+    struct SmpStats total;
+    memset(&total, 0, sizeof(total));
+    for (i = 0; i < cores; i++) {
+        total.quits += cpus[i].quits;
+        total.steals += cpus[i].steals;
+        total.yields += cpus[i].yields;
+    }
+    if (stats != NULL) {
+        *stats = total;
+    }
+    return total.quits;
+}
+
+#else
+
+void smpPush(struct PCB *proc) {
+    USLOSS_Console("ERROR: smpPush() called in a build without HOST_SMP.\n");
+    USLOSS_Halt(1);
+}
+
+void smpSwitchOut(int reason) {
+    USLOSS_Console("ERROR: smpSwitchOut() called in a build without HOST_SMP.\n");
+    USLOSS_Halt(1);
+}
+
+int smpRun(int cores, struct SmpStats *stats) {
+    checkKernelMode("smpRun");
+
+    return -1;
+}
+
+#endif
@@ -0,0 +1,198 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include "kernel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Stride scheduling. Under POLICY_STRIDE the ready processes at priority
+ * 1-5 sit in a min-heap keyed on their pass instead of on queue[0..4]. The
+ * process with the lowest pass runs; while it runs, its pass grows by
+ * STRIDE1 / tickets for every microsecond of currentTime() it uses, so over
+ * time each process gets CPU in proportion to its tickets. The clock handler
+ * charges the running process and asks for a reschedule, which happens at
+ * the next kernel entry (see checkKernelMode()).
+ */
+
+#define STRIDE1  (1 << 20)
+
+// ready processes ordered on pass; strideHeap[0] has the lowest
+struct PCB *strideHeap[MAXPROC];
+int strideCount;
+
+// set by the clock handler; checkKernelMode() dispatches when it is set
+volatile int reschedPending;
+
+// pass of the process dispatched last; processes joining the heap start here
+static long long globalPass;
+
+// currentTime() when the running process was last charged
+static int chargeTime;
+
+static void (*chainedClockHandler)(int dev, void *arg);
+
+static void swapEntries(int i, int j) {
+    struct PCB *tmp = strideHeap[i];
+
+    strideHeap[i] = strideHeap[j];
+    strideHeap[j] = tmp;
+    strideHeap[i]->heap_index = i;
+    strideHeap[j]->heap_index = j;
+}
+
+static void siftUp(int i) {
+    while (i > 0 && strideHeap[(i - 1) / 2]->pass > strideHeap[i]->pass) {
+        swapEntries(i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void siftDown(int i) {
+    while (1) {
+        int least = i, l = 2 * i + 1, r = 2 * i + 2;
+
+        if (l < strideCount && strideHeap[l]->pass < strideHeap[least]->pass) {
+            least = l;
+        }
+        if (r < strideCount && strideHeap[r]->pass < strideHeap[least]->pass) {
+            least = r;
+        }
+        if (least == i) {
+            return;
+        }
+        swapEntries(i, least);
+        i = least;
+    }
+}
+
+/*
+ * Function: strideInsert
+ * ----------------------
+ * This function adds a ready process to the heap. A process that has been
+ * away (new, or blocked for a while) starts no lower than globalPass, so it
+ * cannot make up for the time it was not competing.
+ */
+void strideInsert(struct PCB *proc) {
+    if (proc->pass < globalPass) {
+        proc->pass = globalPass;
+    }
+    proc->heap_index = strideCount;
+    strideHeap[strideCount++] = proc;
+    siftUp(proc->heap_index);
+}
+
+/*
+ * Function: strideRemove
+ * ----------------------
+ * This function takes a process out of the heap, wherever it is.
+ */
+void strideRemove(struct PCB *proc) {
+    int i = proc->heap_index;
+
+    strideCount--;
+    if (i != strideCount) {
+        struct PCB *moved = strideHeap[strideCount];
+
+        strideHeap[i] = moved;
+        moved->heap_index = i;
+        siftUp(i);
+        siftDown(moved->heap_index);
+    }
+}
+
+/*
+ * Function: strideMin
+ * -------------------
+ * This function returns the ready process with the lowest pass, or NULL.
+ */
+struct PCB *strideMin(void) {
+    return strideCount > 0 ? strideHeap[0] : NULL;
+}
+
+/*
+ * Function: strideCharge
+ * ----------------------
+ * This function charges the running process for the time since it was last
+ * charged. The running process is never in the heap, so this is safe from
+ * the clock handler.
+ */
+void strideCharge(struct PCB *proc) {
+    int now = currentTime();
+
+    if (proc != NULL && proc->tickets > 0) {
+        proc->pass += (long long) (now - chargeTime) * (STRIDE1 / proc->tickets);
+    }
+    chargeTime = now;
+}
+
+/*
+ * Function: strideDispatched
+ * --------------------------
+ * This function notes that 'proc' is about to run; called by the
+ * dispatcher under POLICY_STRIDE.
+ */
+void strideDispatched(struct PCB *proc) {
+    if (proc->priority <= 5) {
+        globalPass = proc->pass;
+    }
+    chargeTime = currentTime();
+}
+
+static void strideClockHandler(int dev, void *arg) {
+    if (schedPolicy == POLICY_STRIDE) {
+        strideCharge(curProcess);
+        reschedPending = 1;
+    }
+
+    if (chainedClockHandler != NULL) {
+        chainedClockHandler(dev, arg);
+    }
+}
+
+/*
+ * Function: strideInit
+ * --------------------
+ * This function empties the heap and installs the clock handler; called
+ * from phase1_init().
+ */
+void strideInit(void) {
+    strideCount = 0;
+    reschedPending = 0;
+    globalPass = 0;
+    chargeTime = currentTime();
+
+    chainedClockHandler = USLOSS_IntVec[USLOSS_CLOCK_INT];
+    USLOSS_IntVec[USLOSS_CLOCK_INT] = strideClockHandler;
+}
+
+/*
+ * Function: setTickets
+ * --------------------
+ * This function sets a process's share of the CPU under POLICY_STRIDE. The
+ * new value applies to the time the process uses from now on.
+ *
+ * @param int pid: process ID
+ *
+ * @param int tickets: number of tickets, 1 to MAXTICKETS
+ *
+ * @return int -1: returned if pid is not a live process or tickets is out
+ *                 of range
+ *
+ * @return int >=0: the previous number of tickets (0 for init, which never
+ *                  competes)
+ */
+int setTickets(int pid, int tickets) {
+    checkKernelMode("setTickets");
+
+    struct PCB *proc = pid_lookup(pid);
+    if (proc == NULL || proc->run_state == PROC_ZOMBIE || tickets < 1 || tickets > MAXTICKETS) {
+        return -1;
+    }
+    if (proc == curProcess) {
+        strideCharge(proc);
+    }
+    int old = proc->tickets;
+    proc->tickets = tickets;
+    return old;
+}
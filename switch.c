@@ -0,0 +1,286 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include "kernel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Context switch backends. Every process records which backend created its
+ * context, and contextSwitch() picks the matching switch routine:
+ *
+ *   SWITCH_USLOSS  russ_ContextInit() and USLOSS_ContextSwitch(), with a full
+ *                  USLOSS_Context per process.
+ *   SWITCH_NATIVE  a few lines of assembly that save only the callee-saved
+ *                  registers on the process's own stack. Available on x86-64
+ *                  and arm64; meant for benchmarking and host-side runs.
+ *
+ * A switch between processes of different backends goes through a small
+ * bridge context that lives in both worlds.
+ */
+
+// saves the callee-saved registers on the current stack, stores the stack
+// pointer in *fromSp, and resumes whatever was saved at toSp
+extern void nativeSwitch(void **fromSp, void *toSp);
+
+#if defined(__x86_64__)
+#define NATIVE_SWITCH_AVAILABLE 1
+#define NATIVE_FRAME_WORDS 7
+#define NATIVE_FRAME_RETURN 6
+__asm__(
+    ".text\n"
+    ".globl nativeSwitch\n"
+    ".type nativeSwitch, @function\n"
+    "nativeSwitch:\n"
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    ".size nativeSwitch, .-nativeSwitch\n"
+);
+#elif defined(__aarch64__)
+#define NATIVE_SWITCH_AVAILABLE 1
+#define NATIVE_FRAME_WORDS 20
+#define NATIVE_FRAME_RETURN 11
+__asm__(
+    ".text\n"
+    ".globl nativeSwitch\n"
+    ".type nativeSwitch, %function\n"
+    "nativeSwitch:\n"
+    "    sub sp, sp, #160\n"
+    "    stp x19, x20, [sp, #0]\n"
+    "    stp x21, x22, [sp, #16]\n"
+    "    stp x23, x24, [sp, #32]\n"
+    "    stp x25, x26, [sp, #48]\n"
+    "    stp x27, x28, [sp, #64]\n"
+    "    stp x29, x30, [sp, #80]\n"
+    "    stp d8, d9, [sp, #96]\n"
+    "    stp d10, d11, [sp, #112]\n"
+    "    stp d12, d13, [sp, #128]\n"
+    "    stp d14, d15, [sp, #144]\n"
+    "    mov x9, sp\n"
+    "    str x9, [x0]\n"
+    "    mov sp, x1\n"
+    "    ldp x19, x20, [sp, #0]\n"
+    "    ldp x21, x22, [sp, #16]\n"
+    "    ldp x23, x24, [sp, #32]\n"
+    "    ldp x25, x26, [sp, #48]\n"
+    "    ldp x27, x28, [sp, #64]\n"
+    "    ldp x29, x30, [sp, #80]\n"
+    "    ldp d8, d9, [sp, #96]\n"
+    "    ldp d10, d11, [sp, #112]\n"
+    "    ldp d12, d13, [sp, #128]\n"
+    "    ldp d14, d15, [sp, #144]\n"
+    "    add sp, sp, #160\n"
+    "    ret\n"
+    ".size nativeSwitch, .-nativeSwitch\n"
+);
+#else
+#define NATIVE_SWITCH_AVAILABLE 0
+void nativeSwitch(void **fromSp, void *toSp) {
+    USLOSS_Console("ERROR: the native context switch is not available on this architecture.\n");
+    USLOSS_Halt(1);
+}
+#endif
+
+struct SwitchBackend {
+    char *name;
+    void (*init)(struct PCB *proc, int (*func)(char *), char *arg, int stackSize);
+    void (*switchTo)(struct PCB *from, struct PCB *to);
+};
+
+// backend given to processes created from now on
+int switchBackend = SWITCH_USLOSS;
+
+// number of switches made by each backend, plus bridged ones
+int switchCounts[SWITCH_NATIVE + 2];
+
+// the bridge: a USLOSS context that also has a native stack pointer
+USLOSS_Context bridgeState;
+void *bridgeSp;
+void *bridgeStack;
+struct PCB *bridgeTarget;
+
+// where a switch with nothing to save puts the registers
+static void *scratchSp;
+
+static void uslossInit(struct PCB *proc, int (*func)(char *), char *arg, int stackSize) {
+    russ_ContextInit(proc->pid, &proc->state, proc->stack, stackSize, func, arg);
+}
+
+static void uslossSwitch(struct PCB *from, struct PCB *to) {
+    USLOSS_ContextSwitch(from == NULL ? NULL : &from->state, &to->state);
+}
+
+/*
+ * Function: nativeLaunch
+ * ----------------------
+ * This function is where a native process starts: the first switch to it
+ * "returns" here. Like the USLOSS trampoline, it enables interrupts and runs
+ * the process's main function, which must not return.
+ */
+static void nativeLaunch(void) {
+    USLOSS_PsrSet(USLOSS_PsrGet() | USLOSS_PSR_CURRENT_INT);
+
+    int rc = curProcess->start_func(curProcess->start_arg);
+    USLOSS_Console("ERROR: Process pid %d returned %d from its main function without calling quit.\n", getpid(), rc);
+    USLOSS_Halt(1);
+}
+
+/*
+ * Function: nativeInit
+ * --------------------
+ * This function builds the frame nativeSwitch() expects at the top of a new
+ * process's stack: zeroed callee-saved registers and a return address that
+ * lands in nativeLaunch() with the stack aligned as if it had been called.
+ */
+static void nativeInit(struct PCB *proc, int (*func)(char *), char *arg, int stackSize) {
+    unsigned long top = ((unsigned long) proc->stack + stackSize) & ~15UL;
+    void **frame;
+
+#if defined(__x86_64__)
+    top -= 8; // as if nativeLaunch had been called: rsp is 8 mod 16 on entry
+#endif
+    frame = (void **) top - NATIVE_FRAME_WORDS;
+    memset(frame, 0, NATIVE_FRAME_WORDS * sizeof(void *));
+    frame[NATIVE_FRAME_RETURN] = (void *) nativeLaunch;
+
+    proc->start_func = func;
+    proc->start_arg = arg;
+    proc->native_sp = frame;
+}
+
+static void nativeSwitchTo(struct PCB *from, struct PCB *to) {
+    nativeSwitch(from == NULL ? &scratchSp : &from->native_sp, to->native_sp);
+}
+
+struct SwitchBackend switchBackends[] = {
+    { "USLOSS", uslossInit, uslossSwitch },
+    { "native", nativeInit, nativeSwitchTo },
+};
+
+/*
+ * Function: bridgeMain
+ * --------------------
+ * This function runs forever on the bridge stack. A USLOSS process that
+ * switches to a native one lands here and is carried over with
+ * nativeSwitch(); a native process going the other way resumes here and is
+ * carried over with USLOSS_ContextSwitch(). Since a crossing always starts
+ * from the side the bridge is not parked on, the two calls alternate.
+ */
+static void bridgeMain(void) {
+    while (1) {
+        nativeSwitch(&bridgeSp, bridgeTarget->native_sp);
+        USLOSS_ContextSwitch(&bridgeState, &bridgeTarget->state);
+    }
+}
+
+/*
+ * Function: contextInit
+ * ---------------------
+ * This function creates a process's initial context with the current
+ * backend.
+ *
+ * @param int stackSize: size of proc->stack in bytes
+ */
+void contextInit(struct PCB *proc, int (*func)(char *), char *arg, int stackSize) {
+    proc->backend = switchBackend;
+    switchBackends[proc->backend].init(proc, func, arg, stackSize);
+}
+
+/*
+ * Function: contextSwitch
+ * -----------------------
+ * This function saves the registers of 'from' and resumes 'to', using the
+ * bridge when the two were created by different backends.
+ *
+ * @param struct PCB *from: process being switched away from, or NULL if
+ *                          nothing is running yet
+ *
+ * @param struct PCB *to: process to resume
+ */
+void contextSwitch(struct PCB *from, struct PCB *to) {
+    if (from == NULL || from->backend == to->backend) {
+        switchCounts[to->backend]++;
+        switchBackends[to->backend].switchTo(from, to);
+        return;
+    }
+
+    switchCounts[SWITCH_NATIVE + 1]++;
+    bridgeTarget = to;
+    if (from->backend == SWITCH_USLOSS) {
+        if (bridgeStack == NULL) {
+            bridgeStack = kernelAlloc(USLOSS_MIN_STACK);
+            USLOSS_ContextInit(&bridgeState, bridgeStack, USLOSS_MIN_STACK, NULL, bridgeMain);
+        }
+        USLOSS_ContextSwitch(&from->state, &bridgeState);
+    }
+    else {
+        nativeSwitch(&from->native_sp, bridgeSp);
+    }
+}
+
+/*
+ * Function: setSwitchBackend
+ * --------------------------
+ * This function chooses the backend for processes created after this call.
+ * Existing processes keep the one they were created with.
+ *
+ * @param int backend: SWITCH_USLOSS or SWITCH_NATIVE
+ *
+ * @return int -1: returned if backend is unknown or not available on this
+ *                 architecture
+ *
+ * @return int >=0: the previous backend
+ */
+int setSwitchBackend(int backend) {
+    checkKernelMode("setSwitchBackend");
+
+    if (backend != SWITCH_USLOSS && (backend != SWITCH_NATIVE || !NATIVE_SWITCH_AVAILABLE)) {
+        return -1;
+    }
+    int old = switchBackend;
+    switchBackend = backend;
+    return old;
+}
+
+/*
+ * Function: getSwitchCount
+ * ------------------------
+ * This function reports how many switches a backend has made.
+ *
+ * @param int backend: SWITCH_USLOSS, SWITCH_NATIVE, or SWITCH_NATIVE+1 for
+ *                     switches that went through the bridge
+ *
+ * @return int -1: returned if backend is out of range
+ *
+ * @return int >=0: number of switches
+ */
+int getSwitchCount(int backend) {
+    if (backend < SWITCH_USLOSS || backend > SWITCH_NATIVE + 1) {
+        return -1;
+    }
+    return switchCounts[backend];
+}
+
+/*
+ * Function: switchInit
+ * --------------------
+ * This function resets the backend choice and counters; init always starts
+ * on the USLOSS backend.
+ */
+void switchInit(void) {
+    switchBackend = SWITCH_USLOSS;
+    memset(switchCounts, 0, sizeof(switchCounts));
+}
@@ -0,0 +1,366 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include "kernel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+struct Semaphore {
+    int used; // flag to check if semaphore in use
+    int isMutex; // flag to check if this entry is a mutex
+    int value; // count of available units (0 or 1 for a mutex)
+    struct PCB *owner; // process holding the mutex, NULL for semaphores
+    struct WaitQueue waiters; // processes blocked in SemP() or MutexLock()
+    int acquisitions; // successful SemP()/MutexLock() calls
+    int waits; // acquisitions that had to block first
+    long long totalWait; // sum of blocked time, in microseconds
+    int maxWait; // longest blocked time, in microseconds
+};
+
+// semaphore and mutex table
+struct Semaphore semTable[MAXSEMS];
+
+/*
+ * Function: getSem
+ * ----------------
+ * This function looks up a semaphore or mutex by ID.
+ *
+ * @param int id: semaphore or mutex ID
+ *
+ * @param int isMutex: 1 if the caller expects a mutex, 0 for a semaphore
+ *
+ * @return struct Semaphore *: the entry, or NULL if the ID is out of range, not
+ *                             in use, or of the other kind
+ */
+static struct Semaphore *getSem(int id, int isMutex) {
+    if (id < 0 || id >= MAXSEMS || !semTable[id].used || semTable[id].isMutex != isMutex) {
+        return NULL;
+    }
+    return &semTable[id];
+}
+
+/*
+ * Function: allocSem
+ * ------------------
+ * This function finds a free entry in the semaphore table and initializes it.
+ *
+ * @return int -1: returned if the table is full
+ *
+ * @return int >=0: ID of the new entry
+ */
+static int allocSem(int isMutex, int value) {
+    int id;
+
+    for (id = 0; id < MAXSEMS; id++) {
+        if (!semTable[id].used) {
+            memset(&semTable[id], 0, sizeof(struct Semaphore));
+            semTable[id].used = 1;
+            semTable[id].isMutex = isMutex;
+            semTable[id].value = value;
+            return id;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Function: waitForSem
+ * --------------------
+ * This function blocks the current process on a semaphore's wait queue. When
+ * it returns 0, the releaser has already handed the resource over.
+ *
+ * @return int -4: returned if kill_group() woke it instead
+ *
+ * @return int 0: the resource is the caller's
+ */
+static int waitForSem(struct Semaphore *sem) {
+    curProcess->wait_start = currentTime();
+    curProcess->wait_result = 0;
+    waitQueueAppend(&sem->waiters, curProcess);
+    blockMe();
+    return curProcess->wait_result;
+}
+
+/*
+ * Function: handOff
+ * -----------------
+ * This function gives the resource directly to the first waiter, records how
+ * long it waited, and wakes it. The waiter runs immediately if it has higher
+ * priority than the releaser, unless the releaser is quitting.
+ *
+ * @param int runNow: 1 to let the waiter preempt the releaser, 0 to only
+ *                    make it ready
+ *
+ * @return int 1: a waiter was woken
+ *
+ * @return int 0: nobody was waiting
+ */
+static int handOff(struct Semaphore *sem, int runNow) {
+    struct PCB *waiter = waitQueuePop(&sem->waiters);
+
+    if (waiter == NULL) {
+        return 0;
+    }
+
+    int waited = currentTime() - waiter->wait_start;
+    sem->acquisitions++;
+    sem->waits++;
+    sem->totalWait += waited;
+    if (waited > sem->maxWait) {
+        sem->maxWait = waited;
+    }
+
+    if (sem->isMutex) {
+        sem->owner = waiter;
+        waiter->mutexes_held++;
+    }
+    if (runNow) {
+        wakeProcess(waiter);
+    }
+    else {
+        readyProcess(waiter);
+    }
+    return 1;
+}
+
+/*
+ * Function: unlockMutex
+ * ---------------------
+ * This function takes a mutex from its owner and passes it to the first
+ * waiter, or unlocks it if nobody is waiting.
+ *
+ * @param int runNow: passed on to handOff()
+ */
+static void unlockMutex(struct Semaphore *m, int runNow) {
+    m->owner->mutexes_held--;
+    if (!handOff(m, runNow)) {
+        m->owner = NULL;
+        m->value = 1;
+    }
+}
+
+/*
+ * Function: SemCreate
+ * -------------------
+ * This function creates a counting semaphore.
+ *
+ * @param int value: initial count, which must not be negative
+ *
+ * @return int -1: returned if value is negative or the table is full
+ *
+ * @return int >=0: ID of the new semaphore
+ */
+int SemCreate(int value) {
+    checkKernelMode("SemCreate");
+
+    if (value < 0) {
+        return -1;
+    }
+    return allocSem(0, value);
+}
+
+/*
+ * Function: SemP
+ * --------------
+ * This function decrements a semaphore, blocking until a unit is available.
+ * Waiters are served in FIFO order.
+ *
+ * @param int sem: semaphore ID
+ *
+ * @return int -1: returned if sem is not a valid semaphore
+ *
+ * @return int -4: returned if kill_group() woke it while blocked
+ *
+ * @return int 0: the unit was acquired
+ */
+int SemP(int sem) {
+    checkKernelMode("SemP");
+
+    struct Semaphore *s = getSem(sem, 0);
+    if (s == NULL) {
+        return -1;
+    }
+
+    if (s->value > 0) {
+        s->value--;
+        s->acquisitions++;
+    }
+    else {
+        return waitForSem(s);
+    }
+    return 0;
+}
+
+/*
+ * Function: SemV
+ * --------------
+ * This function increments a semaphore. If a process is waiting, the unit is
+ * handed straight to it instead, so the count never rises while there are
+ * waiters.
+ *
+ * @param int sem: semaphore ID
+ *
+ * @return int -1: returned if sem is not a valid semaphore
+ *
+ * @return int 0: success
+ */
+int SemV(int sem) {
+    checkKernelMode("SemV");
+
+    struct Semaphore *s = getSem(sem, 0);
+    if (s == NULL) {
+        return -1;
+    }
+
+    if (!handOff(s, 1)) {
+        s->value++;
+    }
+    return 0;
+}
+
+/*
+ * Function: SemFree
+ * -----------------
+ * This function releases a semaphore or mutex so its ID can be reused.
+ *
+ * @param int sem: semaphore or mutex ID
+ *
+ * @return int -1: returned if the ID is invalid or processes are still waiting
+ *
+ * @return int 0: success
+ */
+int SemFree(int sem) {
+    checkKernelMode("SemFree");
+
+    if (sem < 0 || sem >= MAXSEMS || !semTable[sem].used || semTable[sem].waiters.head != NULL) {
+        return -1;
+    }
+    if (semTable[sem].owner != NULL) {
+        semTable[sem].owner->mutexes_held--;
+    }
+    semTable[sem].used = 0;
+    return 0;
+}
+
+/*
+ * Function: MutexCreate
+ * ---------------------
+ * This function creates an unlocked mutex.
+ *
+ * @return int -1: returned if the table is full
+ *
+ * @return int >=0: ID of the new mutex
+ */
+int MutexCreate(void) {
+    checkKernelMode("MutexCreate");
+
+    return allocSem(1, 1);
+}
+
+/*
+ * Function: MutexLock
+ * -------------------
+ * This function acquires a mutex, blocking until its owner releases it or
+ * quits. Mutexes are not recursive.
+ *
+ * @param int mutex: mutex ID
+ *
+ * @return int -1: returned if mutex is not a valid mutex or the current
+ *                 process already holds it
+ *
+ * @return int -4: returned if kill_group() woke it while blocked
+ *
+ * @return int 0: the mutex is now held by the current process
+ */
+int MutexLock(int mutex) {
+    checkKernelMode("MutexLock");
+
+    struct Semaphore *m = getSem(mutex, 1);
+    if (m == NULL || m->owner == curProcess) {
+        return -1;
+    }
+
+    if (m->value > 0) {
+        m->value = 0;
+        m->owner = curProcess;
+        curProcess->mutexes_held++;
+        m->acquisitions++;
+    }
+    else {
+        return waitForSem(m);
+    }
+    return 0;
+}
+
+/*
+ * Function: MutexUnlock
+ * ---------------------
+ * This function releases a mutex. If a process is waiting, ownership passes
+ * directly to it.
+ *
+ * @param int mutex: mutex ID
+ *
+ * @return int -1: returned if mutex is not a valid mutex or the current
+ *                 process does not hold it
+ *
+ * @return int 0: success
+ */
+int MutexUnlock(int mutex) {
+    checkKernelMode("MutexUnlock");
+
+    struct Semaphore *m = getSem(mutex, 1);
+    if (m == NULL || m->owner != curProcess) {
+        return -1;
+    }
+
+    unlockMutex(m, 1);
+    return 0;
+}
+
+/*
+ * Function: mutexQuit
+ * -------------------
+ * This function releases every mutex a quitting process still holds, so
+ * that a later process in its table slot does not inherit them. Each one
+ * passes to its first waiter, which is made ready but does not run until
+ * the quit switches away, or is unlocked.
+ *
+ * @param struct PCB *proc: the quitting process
+ */
+void mutexQuit(struct PCB *proc) {
+    int id;
+
+    for (id = 0; id < MAXSEMS && proc->mutexes_held > 0; id++) {
+        if (semTable[id].used && semTable[id].owner == proc) {
+            unlockMutex(&semTable[id], 0);
+        }
+    }
+}
+
+/*
+ * Function: SemStats
+ * ------------------
+ * This function reports contention statistics for a semaphore or mutex.
+ *
+ * @param int id: semaphore or mutex ID
+ *
+ * @param struct SyncStats *stats: out-pointer filled with the statistics
+ *
+ * @return int -1: returned if the ID is invalid or stats is NULL
+ *
+ * @return int 0: success
+ */
+int SemStats(int id, struct SyncStats *stats) {
+    checkKernelMode("SemStats");
+
+    if (id < 0 || id >= MAXSEMS || !semTable[id].used || stats == NULL) {
+        return -1;
+    }
+
+    struct Semaphore *s = &semTable[id];
+    stats->acquisitions = s->acquisitions;
+    stats->waits = s->waits;
+    stats->avgWait = (s->waits == 0) ? 0 : (int) (s->totalWait / s->waits);
+    stats->maxWait = s->maxWait;
+    return 0;
+}
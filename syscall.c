@@ -0,0 +1,215 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include "kernel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+// system call vector, indexed by USLOSS_Sysargs.number
+void (*systemCallVec[MAXSYSCALLS])(USLOSS_Sysargs *args);
+
+// number of times each system call was made
+int syscallCalls[MAXSYSCALLS];
+
+// total time spent in each system call, in microseconds
+long long syscallTime[MAXSYSCALLS];
+
+/*
+ * Function: nullsys
+ * -----------------
+ * This function is in every slot of the table that has no handler; calling
+ * it is a fatal error.
+ */
+static void nullsys(USLOSS_Sysargs *args) {
+    USLOSS_Console("ERROR: Process pid %d called undefined syscall %d.\n", getpid(), args->number);
+    USLOSS_Halt(1);
+}
+
+/*
+ * The handlers for the built-in calls. Each unpacks USLOSS_Sysargs, calls the
+ * kernel function, and stores its return value in arg1.
+ */
+
+static void sysSpork(USLOSS_Sysargs *args) {
+    args->arg1 = (void *) (long) spork((char *) args->arg1, (int (*)(char *)) args->arg2,
+                                       (char *) args->arg3, (int) (long) args->arg4,
+                                       (int) (long) args->arg5);
+}
+
+static void sysJoin(USLOSS_Sysargs *args) {
+    args->arg1 = (void *) (long) join((int *) args->arg1);
+}
+
+static void sysQuit(USLOSS_Sysargs *args) {
+    quit_phase_1a((int) (long) args->arg1, (int) (long) args->arg2);
+}
+
+static void sysGetpid(USLOSS_Sysargs *args) {
+    args->arg1 = (void *) (long) getpid();
+}
+
+static void sysDumpProcesses(USLOSS_Sysargs *args) {
+    dumpProcesses();
+}
+
+static void sysSemCreate(USLOSS_Sysargs *args) {
+    args->arg1 = (void *) (long) SemCreate((int) (long) args->arg1);
+}
+
+static void sysSemP(USLOSS_Sysargs *args) {
+    args->arg1 = (void *) (long) SemP((int) (long) args->arg1);
+}
+
+static void sysSemV(USLOSS_Sysargs *args) {
+    args->arg1 = (void *) (long) SemV((int) (long) args->arg1);
+}
+
+static void sysSemFree(USLOSS_Sysargs *args) {
+    args->arg1 = (void *) (long) SemFree((int) (long) args->arg1);
+}
+
+static void sysMboxCreate(USLOSS_Sysargs *args) {
+    args->arg1 = (void *) (long) MboxCreate((int) (long) args->arg1, (int) (long) args->arg2);
+}
+
+static void sysMboxRelease(USLOSS_Sysargs *args) {
+    args->arg1 = (void *) (long) MboxRelease((int) (long) args->arg1);
+}
+
+static void sysMboxSend(USLOSS_Sysargs *args) {
+    args->arg1 = (void *) (long) MboxSend((int) (long) args->arg1, args->arg2, (int) (long) args->arg3);
+}
+
+static void sysMboxRecv(USLOSS_Sysargs *args) {
+    args->arg1 = (void *) (long) MboxRecv((int) (long) args->arg1, args->arg2, (int) (long) args->arg3);
+}
+
+/*
+ * Function: syscallHandler
+ * ------------------------
+ * This function is the USLOSS_SYSCALL_INT handler. The trap has already put
+ * us in kernel mode, so it just range-checks the call number, counts the
+ * call, dispatches through the table, and charges the time taken (including
+ * any time spent blocked) to that call. The count comes first because some
+ * calls, such as quit, never return.
+ * 
+ * @param void *arg: the caller's USLOSS_Sysargs
+ */
+static void syscallHandler(int dev, void *arg) {
+    USLOSS_Sysargs *args = (USLOSS_Sysargs *) arg;
+
+    if (args == NULL || args->number < 0 || args->number >= MAXSYSCALLS) {
+        USLOSS_Console("ERROR: Process pid %d called syscall %d, which is out of range.\n", getpid(),
+                       args == NULL ? -1 : args->number);
+        USLOSS_Halt(1);
+    }
+
+    int number = args->number;
+    int start = currentTime();
+    syscallCalls[number]++;
+    systemCallVec[number](args);
+    syscallTime[number] += currentTime() - start;
+}
+
+/*
+ * Function: syscallInit
+ * ---------------------
+ * This function fills the table with nullsys(), installs the built-in calls
+ * and hooks the table up to USLOSS_SYSCALL_INT.
+ */
+void syscallInit(void) {
+    int i;
+
+    for (i = 0; i < MAXSYSCALLS; i++) {
+        systemCallVec[i] = nullsys;
+    }
+    memset(syscallCalls, 0, sizeof(syscallCalls));
+    memset(syscallTime, 0, sizeof(syscallTime));
+
+    systemCallVec[SYS_SPORK]         = sysSpork;
+    systemCallVec[SYS_JOIN]          = sysJoin;
+    systemCallVec[SYS_QUIT_PHASE_1A] = sysQuit;
+    systemCallVec[SYS_GETPID]        = sysGetpid;
+    systemCallVec[SYS_DUMPPROCESSES] = sysDumpProcesses;
+    systemCallVec[SYS_SEMCREATE]     = sysSemCreate;
+    systemCallVec[SYS_SEMP]          = sysSemP;
+    systemCallVec[SYS_SEMV]          = sysSemV;
+    systemCallVec[SYS_SEMFREE]       = sysSemFree;
+    systemCallVec[SYS_MBOXCREATE]    = sysMboxCreate;
+    systemCallVec[SYS_MBOXRELEASE]   = sysMboxRelease;
+    systemCallVec[SYS_MBOXSEND]      = sysMboxSend;
+    systemCallVec[SYS_MBOXRECV]      = sysMboxRecv;
+
+    USLOSS_IntVec[USLOSS_SYSCALL_INT] = syscallHandler;
+}
+
+/*
+ * Function: syscallInstall
+ * ------------------------
+ * This function puts a handler into the system call table, replacing
+ * whatever was there.
+ * 
+ * @param int number: system call number
+ * 
+ * @param handler: function to run for that call, or NULL to remove it
+ * 
+ * @return int -1: returned if number is out of range
+ * 
+ * @return int 0: success
+ */
+int syscallInstall(int number, void (*handler)(USLOSS_Sysargs *args)) {
+    checkKernelMode("syscallInstall");
+
+    if (number < 0 || number >= MAXSYSCALLS) {
+        return -1;
+    }
+    systemCallVec[number] = (handler == NULL) ? nullsys : handler;
+    return 0;
+}
+
+/*
+ * Function: syscallStats
+ * ----------------------
+ * This function reports how often a system call was made and how long it
+ * took in total. A call that never returns, such as quit, is counted but
+ * adds no time.
+ * 
+ * @param int *calls: out-pointer filled with the number of calls
+ * 
+ * @param int *totalTime: out-pointer filled with the time spent, in
+ *                        microseconds
+ * 
+ * @return int -1: returned if number is out of range or a pointer is NULL
+ * 
+ * @return int 0: success
+ */
+int syscallStats(int number, int *calls, int *totalTime) {
+    checkKernelMode("syscallStats");
+
+    if (number < 0 || number >= MAXSYSCALLS || calls == NULL || totalTime == NULL) {
+        return -1;
+    }
+    *calls = syscallCalls[number];
+    *totalTime = (int) syscallTime[number];
+    return 0;
+}
+
+/*
+ * Function: dumpSyscallStats
+ * --------------------------
+ * This function prints the call count and latency of every system call that
+ * has been made at least once.
+ */
+void dumpSyscallStats(void) {
+    checkKernelMode("dumpSyscallStats");
+
+    int i;
+
+    USLOSS_Console("%7s  %8s  %12s  %8s\n", "SYSCALL", "CALLS", "TOTAL(us)", "AVG(us)");
+    for (i = 0; i < MAXSYSCALLS; i++) {
+        if (syscallCalls[i] > 0) {
+            USLOSS_Console("%7d  %8d  %12lld  %8lld\n", i, syscallCalls[i], syscallTime[i],
+                           syscallTime[i] / syscallCalls[i]);
+        }
+    }
+}
@@ -0,0 +1,336 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include "kernel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Micro-tasks. A task is a function and an argument in a MAXTASKS-entry
+ * table; it has no stack or context of its own. Each priority level has one
+ * runner, a process outside the process table (pid 0, like the idle
+ * process) that sits on the ordinary ready queue for its priority whenever
+ * tasks are waiting. When dispatched, the runner calls the waiting tasks in
+ * turn on its own stack. A task that returns TASK_YIELD goes to the back of
+ * the line and is called again later with the same step value. Any other
+ * return value is its exit status, and the task waits for its parent's join(),
+ * like a zombie child.
+ *
+ * The runners use USLOSS_ContextInit() directly, like the switch bridge, so
+ * that they do not take a launch slot in the helper library's table, which
+ * is indexed by pid.
+ */
+
+struct Task {
+    int (*func)(void *arg, int *step);
+    void *arg;
+    struct Task *next; // on its priority's run queue, its parent's done list, or the free list
+    struct PCB *parent; // process that joins it
+    int id; // from the same sequence as pids
+    int step; // where a yielding task resumes; 0 at the first call
+    int status; // return value, once done
+    short priority;
+    short done;
+};
+
+// FIFO of tasks waiting to be called at one priority
+struct TaskQueue {
+    struct Task *head;
+    struct Task *tail;
+};
+
+static struct Task taskTable[MAXTASKS];
+static struct Task *freeTasks;
+
+// one runner and one run queue per priority; priority p uses index p-1
+static struct PCB runners[5];
+static struct TaskQueue taskQueues[5];
+
+// task being called on this CPU, NULL while the runner is between tasks
+static struct Task *curTask;
+
+static int tasksCreated;
+static int taskYields;
+
+static void taskQueueAppend(struct TaskQueue *tq, struct Task *task) {
+    task->next = NULL;
+    if (tq->tail == NULL) {
+        tq->head = task;
+    }
+    else {
+        tq->tail->next = task;
+    }
+    tq->tail = task;
+}
+
+static struct Task *taskQueuePop(struct TaskQueue *tq) {
+    struct Task *task = tq->head;
+
+    if (task != NULL) {
+        tq->head = task->next;
+        if (tq->head == NULL) {
+            tq->tail = NULL;
+        }
+    }
+    return task;
+}
+
+/*
+ * Function: taskFinish
+ * --------------------
+ * This function records a task's exit status and moves it to its parent's
+ * done list. If the parent is blocked in join() waiting for its tasks, it is
+ * woken, and runs at once if it outranks the runner.
+ */
+static void taskFinish(struct Task *task, int status) {
+    struct PCB *parent = task->parent;
+
+    task->status = status;
+    task->done = 1;
+    task->next = parent->done_tasks;
+    parent->done_tasks = task;
+    parent->live_tasks--;
+
+    if (parent->task_join) {
+        parent->task_join = 0;
+        wakeProcess(parent);
+    }
+}
+
+/*
+ * Function: taskRunner
+ * --------------------
+ * This function is the main function of every runner; the runner finds its
+ * priority in its PCB. It calls the tasks on its run queue until the queue
+ * is empty and then blocks until taskCreate() readies it again. After a
+ * yield, or when an interrupt has made someone due, it lets the ready
+ * processes at its priority or better run first.
+ */
+static void taskRunner(void) {
+    USLOSS_PsrSet(USLOSS_PsrGet() | USLOSS_PSR_CURRENT_INT);
+
+    struct TaskQueue *tq = &taskQueues[curProcess->priority - 1];
+
+    while (1) {
+        struct Task *task = taskQueuePop(tq);
+
+        if (task == NULL) {
+            blockMe();
+            continue;
+        }
+
+        curTask = task;
+        int rc = task->func(task->arg, &task->step);
+        curTask = NULL;
+
+        if (rc == TASK_YIELD) {
+            taskYields++;
+            taskQueueAppend(tq, task);
+            yieldCpu();
+        }
+        else {
+            taskFinish(task, rc);
+            if (wakePending) {
+                yieldCpu();
+            }
+        }
+    }
+}
+
+/*
+ * Function: taskInit
+ * ------------------
+ * This function empties the task table and run queues; called from
+ * phase1_init(). The runners get their stacks when the first task at their
+ * priority is created.
+ */
+void taskInit(void) {
+    int i;
+
+    memset(taskTable, 0, sizeof(taskTable));
+    memset(runners, 0, sizeof(runners));
+    memset(taskQueues, 0, sizeof(taskQueues));
+
+    freeTasks = NULL;
+    for (i = MAXTASKS - 1; i >= 0; i--) {
+        taskTable[i].next = freeTasks;
+        freeTasks = &taskTable[i];
+    }
+    for (i = 0; i < 5; i++) {
+        strcpy(runners[i].name, "tasks");
+        runners[i].priority = i + 1;
+        runners[i].tickets = DEFAULT_TICKETS;
+    }
+    curTask = NULL;
+    tasksCreated = 0;
+    taskYields = 0;
+}
+
+/*
+ * Function: taskRunnersReady
+ * --------------------------
+ * This function returns how many runners are on a ready queue, for
+ * checkProcessTable(), since they are not in the table.
+ */
+int taskRunnersReady(void) {
+    int i, n = 0;
+
+    for (i = 0; i < 5; i++) {
+        n += runners[i].run_state == PROC_READY;
+    }
+    return n;
+}
+
+/*
+ * Function: taskCreate
+ * --------------------
+ * This function creates a micro-task: 'func' will be called with 'arg' by
+ * the runner for 'priority', which is scheduled like any process at that
+ * priority. The task belongs to the calling process, or, when called from a
+ * task, to that task's parent, and is collected with join(). Like spork(),
+ * this does not switch; the task runs once the dispatcher picks its runner.
+ *
+ * A task must not block or quit: it would hold up every other task at its
+ * priority. To wait for something, it returns TASK_YIELD and is called
+ * again later, with *step as it left it.
+ *
+ * @param int (*func)(void *, int *): task function; returns TASK_YIELD to
+ *                                    be called again, or its exit status
+ *
+ * @param void *arg: argument passed to func, may be NULL
+ *
+ * @param int priority: priority in the range 1-5 (inclusive)
+ *
+ * @return int -1: returned if func is NULL, priority is out of range, the
+ *                 task table is full, the runner's stack cannot be allocated,
+ *                 or smpRun() is active
+ *
+ * @return int >0: ID of the task, which join() returns when it collects it
+ */
+int taskCreate(int (*func)(void *, int *), void *arg, int priority) {
+    checkKernelMode("taskCreate");
+
+    if (func == NULL || priority < 1 || priority > 5 || freeTasks == NULL || smpActive) {
+        return -1;
+    }
+    struct PCB *runner = &runners[priority - 1];
+
+    if (runner->stack == NULL) {
+        runner->stack = kernelAlloc(USLOSS_MIN_STACK);
+        if (runner->stack == NULL) {
+            return -1;
+        }
+        runner->stack_size = USLOSS_MIN_STACK;
+        runner->backend = SWITCH_USLOSS;
+        USLOSS_ContextInit(&runner->state, runner->stack, USLOSS_MIN_STACK, NULL, taskRunner);
+    }
+
+    struct Task *task = freeTasks;
+    freeTasks = task->next;
+
+    task->func = func;
+    task->arg = arg;
+    task->parent = curTask != NULL ? curTask->parent : curProcess;
+    task->id = ATOMIC_ADD(PID, 1) - 1;
+    task->step = 0;
+    task->status = 0;
+    task->priority = priority;
+    task->done = 0;
+    task->parent->live_tasks++;
+    tasksCreated++;
+
+    taskQueueAppend(&taskQueues[priority - 1], task);
+    if (runner->run_state == PROC_FREE || runner->run_state == PROC_BLOCKED) {
+        readyProcess(runner);
+    }
+    return task->id;
+}
+
+/*
+ * Function: taskReap
+ * ------------------
+ * This function collects one finished task of 'proc' for join() and returns
+ * its table entry to the free list.
+ *
+ * @param int *status: out-pointer filled with the task's exit status
+ *
+ * @return int 0: returned if no task of proc has finished
+ *
+ * @return int >0: ID of the task collected
+ */
+int taskReap(struct PCB *proc, int *status) {
+    struct Task *task = proc->done_tasks;
+
+    if (task == NULL) {
+        return 0;
+    }
+    proc->done_tasks = task->next;
+
+    int id = task->id;
+    *status = task->status;
+    memset(task, 0, sizeof(*task));
+    task->next = freeTasks;
+    freeTasks = task;
+    return id;
+}
+
+/*
+ * Function: taskAdopt
+ * -------------------
+ * This function hands every task of a quitting process, finished or not,
+ * to 'to'. The finished ones are spliced onto its done list; unfinished ones
+ * are found by a scan of the task table.
+ */
+void taskAdopt(struct PCB *proc, struct PCB *to) {
+    struct Task *task;
+    int i;
+
+    if (proc->done_tasks != NULL) {
+        for (task = proc->done_tasks; task->next != NULL; task = task->next) {
+            task->parent = to;
+        }
+        task->parent = to;
+        task->next = to->done_tasks;
+        to->done_tasks = proc->done_tasks;
+        proc->done_tasks = NULL;
+    }
+    for (i = 0; i < MAXTASKS && proc->live_tasks > 0; i++) {
+        if (taskTable[i].func != NULL && !taskTable[i].done && taskTable[i].parent == proc) {
+            taskTable[i].parent = to;
+            proc->live_tasks--;
+            to->live_tasks++;
+        }
+    }
+}
+
+/*
+ * Function: taskStats
+ * -------------------
+ * This function reports on the task table.
+ *
+ * @param struct TaskStats *stats: out-pointer filled with the counters
+ *
+ * @return int -1: returned if stats is NULL
+ *
+ * @return int 0: success
+ */
+int taskStats(struct TaskStats *stats) {
+    struct Task *task;
+    int i, unused = 0;
+
+    if (stats == NULL) {
+        return -1;
+    }
+    for (task = freeTasks; task != NULL; task = task->next) {
+        unused++;
+    }
+    stats->created = tasksCreated;
+    stats->inUse = MAXTASKS - unused;
+    stats->yields = taskYields;
+    stats->taskBytes = sizeof(struct Task);
+    stats->runnerBytes = 0;
+    for (i = 0; i < 5; i++) {
+        stats->runnerBytes += runners[i].stack_size;
+    }
+    return 0;
+}
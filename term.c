@@ -0,0 +1,296 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include "kernel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Interrupt-driven terminal output. Each terminal has a TERM_RING_SIZE-byte
+ * ring that termWrite() fills and returns from without waiting for the
+ * device. The terminal's transmit interrupt drives the rest: the handler
+ * sends the next character from the ring, one per interrupt, and turns the
+ * interrupt off once the ring is empty. A writer that finds the ring full
+ * waits on the terminal's writers queue, and termFlush() on its flushers
+ * queue. Like the clock handler, the terminal handler never touches a
+ * queue, since it can interrupt the kernel in the middle of an update; it
+ * sets wakePending, and termWakeWriters() lets the waiters go at the next
+ * kernel entry or dispatch.
+ */
+
+struct Terminal {
+    char ring[TERM_RING_SIZE];
+    volatile unsigned int head; // next character to send; moved by the handler
+    volatile unsigned int tail; // next free byte; moved by writers
+    volatile int sending; // a character is out, so an interrupt will follow
+    struct WaitQueue writers; // waiting for the ring to drain to half
+    struct WaitQueue flushers; // waiting for it to be empty and idle
+    long chars;
+    long interrupts;
+    int stalls;
+    long long stallTime;
+};
+
+static struct Terminal terms[USLOSS_TERM_UNITS];
+
+static void (*chainedTermHandler)(int dev, void *arg);
+
+/*
+ * Function: sendNext
+ * ------------------
+ * This function sends the next character in the ring with the transmit
+ * interrupt on or, if the ring is empty, turns the interrupt off. Only
+ * called while no character is out: from the handler, or by a writer that
+ * found the terminal idle.
+ */
+static void sendNext(struct Terminal *term, int unit) {
+    if (term->head == term->tail) {
+        term->sending = 0;
+        USLOSS_DeviceOutput(USLOSS_TERM_DEV, unit, (void *) 0L);
+        return;
+    }
+
+    int ctrl = USLOSS_TERM_CTRL_CHAR(0, term->ring[term->head % TERM_RING_SIZE]);
+    ctrl = USLOSS_TERM_CTRL_XMIT_INT(USLOSS_TERM_CTRL_XMIT_CHAR(ctrl));
+    term->head++;
+    term->sending = 1;
+    term->chars++;
+    USLOSS_DeviceOutput(USLOSS_TERM_DEV, unit, (void *) (long) ctrl);
+}
+
+static void termHandler(int dev, void *arg) {
+    int unit = (int) (long) arg;
+    struct Terminal *term = &terms[unit];
+    int status;
+
+    USLOSS_DeviceInput(USLOSS_TERM_DEV, unit, &status);
+    if (term->sending && USLOSS_TERM_STAT_XMIT(status) == USLOSS_DEV_READY) {
+        term->interrupts++;
+        sendNext(term, unit);
+        if (term->writers.head != NULL || term->flushers.head != NULL) {
+            wakePending = 1;
+        }
+    }
+
+    if (chainedTermHandler != NULL) {
+        chainedTermHandler(dev, arg);
+    }
+}
+
+/*
+ * Function: termInit
+ * ------------------
+ * This function empties the rings and installs the terminal interrupt
+ * handler; called from phase1_init().
+ */
+void termInit(void) {
+    memset(terms, 0, sizeof(terms));
+
+    chainedTermHandler = USLOSS_IntVec[USLOSS_TERM_INT];
+    USLOSS_IntVec[USLOSS_TERM_INT] = termHandler;
+}
+
+/*
+ * Function: termWakeWriters
+ * -------------------------
+ * This function puts back on their ready queues the writers of each
+ * terminal whose ring has drained to half full, and the flushers of each
+ * terminal that has sent everything. It does not switch.
+ */
+void termWakeWriters(void) {
+    int unit;
+
+    for (unit = 0; unit < USLOSS_TERM_UNITS; unit++) {
+        struct Terminal *term = &terms[unit];
+        struct PCB *proc;
+
+        while (term->tail - term->head <= TERM_RING_SIZE / 2 &&
+               (proc = waitQueuePop(&term->writers)) != NULL) {
+            readyProcess(proc);
+        }
+        while (!term->sending && (proc = waitQueuePop(&term->flushers)) != NULL) {
+            readyProcess(proc);
+        }
+    }
+}
+
+/*
+ * Function: termWaiting
+ * ---------------------
+ * This function tells the dispatcher whether some process is waiting on a
+ * terminal, and so will be woken by an interrupt.
+ */
+int termWaiting(void) {
+    int unit;
+
+    for (unit = 0; unit < USLOSS_TERM_UNITS; unit++) {
+        if (terms[unit].writers.head != NULL || terms[unit].flushers.head != NULL) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Function: termBusy
+ * ------------------
+ * This function tells checkpointSave() whether some terminal has a
+ * character out, whose interrupt a restored run would never get; a
+ * schedule log refuses to start then too.
+ */
+int termBusy(void) {
+    int unit;
+
+    for (unit = 0; unit < USLOSS_TERM_UNITS; unit++) {
+        if (terms[unit].sending) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Function: termBlock
+ * -------------------
+ * This function blocks the current process on one of a terminal's queues.
+ * The dispatcher checks the ring again before switching away, in case the
+ * interrupt that would have woken it came in while it was queueing.
+ *
+ * @return int -4: returned if kill_group() woke it
+ *
+ * @return int 0: the terminal has made progress
+ */
+static int termBlock(struct WaitQueue *wq) {
+    curProcess->wait_result = 0;
+    waitQueueAppend(wq, curProcess);
+    blockMe();
+    return curProcess->wait_result;
+}
+
+/*
+ * Function: termWrite
+ * -------------------
+ * This function queues 'len' bytes for output on a terminal and returns
+ * once they are all in its ring; it blocks only while the ring is full.
+ * The characters go out in the background, one per terminal interrupt.
+ *
+ * @param int unit: terminal, 0 to USLOSS_TERM_UNITS - 1
+ *
+ * @param char *buf: bytes to write
+ *
+ * @param int len: number of bytes
+ *
+ * @return int -1: returned if unit is out of range, buf is NULL or len is
+ *                 negative
+ *
+ * @return int -2: returned if the ring filled while a schedule is being
+ *                 recorded or replayed, whose log has no terminal
+ *                 interrupts to wake it by; some of the bytes may have been
+ *                 queued
+ *
+ * @return int -4: returned if kill_group() woke it while the ring was full;
+ *                 some of the bytes may have been queued
+ *
+ * @return int >=0: number of bytes written, always len
+ */
+int termWrite(int unit, char *buf, int len) {
+    checkKernelMode("termWrite");
+
+    int i = 0;
+
+    if (unit < 0 || unit >= USLOSS_TERM_UNITS || buf == NULL || len < 0) {
+        return -1;
+    }
+    struct Terminal *term = &terms[unit];
+
+    while (i < len) {
+        if (term->tail - term->head == TERM_RING_SIZE) {
+            int start = currentTime();
+
+            if (schedMode != SCHED_LIVE) {
+                return -2;
+            }
+            term->stalls++;
+            int rc = termBlock(&term->writers);
+            term->stallTime += currentTime() - start;
+            if (rc < 0) {
+                return rc;
+            }
+            continue;
+        }
+        while (i < len && term->tail - term->head < TERM_RING_SIZE) {
+            term->ring[term->tail % TERM_RING_SIZE] = buf[i++];
+            term->tail++;
+        }
+
+        // the tail moves before sending is checked, so a handler that runs
+        // in between has already sent from the new tail
+        if (!term->sending) {
+            sendNext(term, unit);
+        }
+    }
+    return len;
+}
+
+/*
+ * Function: termFlush
+ * -------------------
+ * This function blocks until everything written to a terminal so far has
+ * been sent.
+ *
+ * @param int unit: terminal, 0 to USLOSS_TERM_UNITS - 1
+ *
+ * @return int -1: returned if unit is out of range
+ *
+ * @return int -2: returned if it would have to wait while a schedule is
+ *                 being recorded or replayed
+ *
+ * @return int -4: returned if kill_group() woke it while blocked
+ *
+ * @return int 0: success
+ */
+int termFlush(int unit) {
+    checkKernelMode("termFlush");
+
+    if (unit < 0 || unit >= USLOSS_TERM_UNITS) {
+        return -1;
+    }
+    while (terms[unit].sending) {
+        if (schedMode != SCHED_LIVE) {
+            return -2;
+        }
+        if (termBlock(&terms[unit].flushers) < 0) {
+            return -4;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Function: termStats
+ * -------------------
+ * This function reports what a terminal has sent so far.
+ *
+ * @param int unit: terminal, 0 to USLOSS_TERM_UNITS - 1
+ *
+ * @param struct TermStats *stats: out-pointer filled with the counters
+ *
+ * @return int -1: returned if unit is out of range or stats is NULL
+ *
+ * @return int 0: success
+ */
+int termStats(int unit, struct TermStats *stats) {
+    checkKernelMode("termStats");
+
+    if (unit < 0 || unit >= USLOSS_TERM_UNITS || stats == NULL) {
+        return -1;
+    }
+    struct Terminal *term = &terms[unit];
+
+    stats->chars = term->chars;
+    stats->interrupts = term->interrupts;
+    stats->stalls = term->stalls;
+    stats->stallTime = (long) term->stallTime;
+    stats->queued = term->tail - term->head;
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks kernel semaphores and mutexes: a higher priority waiter is switched
+ * to as soon as the resource is released, mutex ownership passes to waiters
+ * in FIFO order, and the contention counters add up.
+ */
+
+int XXp1(char *), XXp2(char *);
+
+int tm_pid = -1;
+int sem = -1;
+int mutex = -1;
+int xxp2_pid[2];
+
+int testcase_main()
+{
+    int status, kidpid, pid1, i;
+    struct SyncStats stats;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: XXp1 blocks in SemP() and runs again the moment testcase_main() calls SemV(), because it is higher priority.  Then two XXp2 processes queue on a mutex held by testcase_main() and get it in the order they asked for it.\n");
+
+    sem = SemCreate(0);
+    USLOSS_Console("testcase_main(): SemCreate(0) returned %d\n", sem);
+    USLOSS_Console("testcase_main(): SemP() on a bad ID returned %d\n", SemP(MAXSEMS));
+
+    pid1 = spork("XXp1", XXp1, "XXp1", USLOSS_MIN_STACK, 2);
+    USLOSS_Console("Phase 1A TEMPORARY HACK: Manually switching to the recently created XXp1()\n");
+    TEMP_switchTo(pid1);
+
+    USLOSS_Console("testcase_main(): XXp1 is blocked, calling SemV()\n");
+    SemV(sem);
+    USLOSS_Console("testcase_main(): back from SemV()\n");
+
+    kidpid = join(&status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+
+    mutex = MutexCreate();
+    USLOSS_Console("testcase_main(): MutexCreate() returned %d\n", mutex);
+    USLOSS_Console("testcase_main(): MutexLock() returned %d\n", MutexLock(mutex));
+    USLOSS_Console("testcase_main(): second MutexLock() returned %d\n", MutexLock(mutex));
+
+    for (i = 0; i < 2; i++) {
+        xxp2_pid[i] = spork("XXp2", XXp2, i == 0 ? "first" : "second", USLOSS_MIN_STACK, 2);
+    }
+    USLOSS_Console("Phase 1A TEMPORARY HACK: Manually switching to the first XXp2()\n");
+    TEMP_switchTo(xxp2_pid[0]);
+
+    USLOSS_Console("testcase_main(): both XXp2 are blocked, calling MutexUnlock()\n");
+    MutexUnlock(mutex);
+    USLOSS_Console("testcase_main(): back from MutexUnlock()\n");
+    USLOSS_Console("Phase 1A TEMPORARY HACK: Manually switching to the second XXp2()\n");
+    TEMP_switchTo(xxp2_pid[1]);
+
+    for (i = 0; i < 2; i++) {
+        kidpid = join(&status);
+        USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+    }
+
+    SemStats(sem, &stats);
+    USLOSS_Console("testcase_main(): semaphore acquisitions %d waits %d\n", stats.acquisitions, stats.waits);
+    SemStats(mutex, &stats);
+    USLOSS_Console("testcase_main(): mutex acquisitions %d waits %d\n", stats.acquisitions, stats.waits);
+    USLOSS_Console("testcase_main(): SemFree() returned %d and %d\n", SemFree(sem), SemFree(mutex));
+
+    return 0;
+}
+
+int XXp1(char *arg)
+{
+    USLOSS_Console("XXp1(): started, calling SemP()\n");
+    SemP(sem);
+    USLOSS_Console("XXp1(): back from SemP()\n");
+
+    quit_phase_1a(3, tm_pid);
+}
+
+int XXp2(char *arg)
+{
+    USLOSS_Console("XXp2(): %s started, calling MutexLock()\n", arg);
+    MutexLock(mutex);
+    USLOSS_Console("XXp2(): %s holds the mutex\n", arg);
+    USLOSS_Console("XXp2(): %s MutexUnlock() returned %d\n", arg, MutexUnlock(mutex));
+
+    quit_phase_1a(4, tm_pid);
+}
@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks mailboxes: messages come out in FIFO order, a full mailbox refuses
+ * a conditional send, a blocked receiver is handed the next message directly,
+ * a mailbox with 0-byte slots carries signals, zero-copy mailboxes pass the
+ * sender's buffer itself, and releasing a mailbox wakes its waiters with -3.
+ */
+
+int XXp1(char *), XXp2(char *);
+
+int tm_pid = -1;
+int mbox = -1;
+int zcbox = -1;
+int sigbox = -1;
+char *sentBuf;
+
+int testcase_main()
+{
+    int status, kidpid, pid1, rc;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: XXp1 drains the two queued messages, blocks on the empty mailbox, and gets the third message straight from testcase_main()'s MboxSend().  XXp2 receives the very buffer that was sent through the zero-copy mailbox, then blocks until the mailbox is released.\n");
+
+    mbox = MboxCreate(2, 16);
+    USLOSS_Console("testcase_main(): MboxCreate(2, 16) returned %d\n", mbox);
+    USLOSS_Console("testcase_main(): MboxCreate(1, MAX_MESSAGE+1) returned %d\n", MboxCreate(1, MAX_MESSAGE+1));
+    USLOSS_Console("testcase_main(): MboxSend() of 17 bytes returned %d\n", MboxSend(mbox, "seventeen bytes!", 17));
+
+    rc = MboxSend(mbox, "first", 6);
+    USLOSS_Console("testcase_main(): MboxSend(first) returned %d\n", rc);
+    rc = MboxSend(mbox, "second", 7);
+    USLOSS_Console("testcase_main(): MboxSend(second) returned %d\n", rc);
+    rc = MboxCondSend(mbox, "third", 6);
+    USLOSS_Console("testcase_main(): MboxCondSend(third) on a full mailbox returned %d\n", rc);
+
+    pid1 = spork("XXp1", XXp1, "XXp1", USLOSS_MIN_STACK, 2);
+    USLOSS_Console("Phase 1A TEMPORARY HACK: Manually switching to the recently created XXp1()\n");
+    TEMP_switchTo(pid1);
+
+    USLOSS_Console("testcase_main(): XXp1 is blocked, sending third\n");
+    rc = MboxSend(mbox, "third", 6);
+    USLOSS_Console("testcase_main(): MboxSend(third) returned %d\n", rc);
+
+    kidpid = join(&status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+
+    // 0-byte slots make an ordinary copying mailbox, for signals
+    sigbox = MboxCreate(1, 0);
+    USLOSS_Console("testcase_main(): MboxCreate(1, 0) returned %d, MboxCreate(1, -2) returned %d\n", sigbox, MboxCreate(1, -2));
+    USLOSS_Console("testcase_main(): signal mailbox: MboxSend() of 1 byte returned %d", MboxSend(sigbox, "x", 1));
+    USLOSS_Console(", MboxSendBuf() returned %d", MboxSendBuf(sigbox, "x", 0));
+    USLOSS_Console(", MboxSend() returned %d\n", MboxSend(sigbox, NULL, 0));
+    USLOSS_Console("testcase_main(): signal mailbox: MboxRecv() returned %d\n", MboxRecv(sigbox, NULL, 0));
+    USLOSS_Console("testcase_main(): signal mailbox: MboxCondRecv() when empty returned %d\n", MboxCondRecv(sigbox, NULL, 0));
+    MboxRelease(sigbox);
+
+    zcbox = MboxCreate(1, MBOX_ZEROCOPY);
+    sentBuf = malloc(4096);
+    strcpy(sentBuf, "a large buffer");
+    rc = MboxSendBuf(zcbox, sentBuf, 4096);
+    USLOSS_Console("testcase_main(): MboxSendBuf() returned %d\n", rc);
+    USLOSS_Console("testcase_main(): MboxSend() on a zero-copy mailbox returned %d\n", MboxSend(zcbox, "x", 2));
+
+    pid1 = spork("XXp2", XXp2, "XXp2", USLOSS_MIN_STACK, 2);
+    USLOSS_Console("Phase 1A TEMPORARY HACK: Manually switching to the recently created XXp2()\n");
+    TEMP_switchTo(pid1);
+
+    USLOSS_Console("testcase_main(): XXp2 is blocked, releasing the mailbox\n");
+    USLOSS_Console("testcase_main(): MboxRelease() returned %d\n", MboxRelease(zcbox));
+    USLOSS_Console("testcase_main(): second MboxRelease() returned %d\n", MboxRelease(zcbox));
+
+    kidpid = join(&status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+    MboxRelease(mbox);
+
+    return 0;
+}
+
+int XXp1(char *arg)
+{
+    char buf[16];
+    int i, rc;
+
+    USLOSS_Console("XXp1(): MboxRecv() into a 3 byte buffer returned %d\n", MboxRecv(mbox, buf, 3));
+    for (i = 0; i < 3; i++) {
+        rc = MboxRecv(mbox, buf, sizeof(buf));
+        USLOSS_Console("XXp1(): MboxRecv() returned %d: '%s'\n", rc, buf);
+    }
+    USLOSS_Console("XXp1(): MboxCondRecv() on an empty mailbox returned %d\n", MboxCondRecv(mbox, buf, sizeof(buf)));
+
+    quit_phase_1a(3, tm_pid);
+}
+
+int XXp2(char *arg)
+{
+    void *buf;
+    int rc;
+
+    rc = MboxRecvBuf(zcbox, &buf);
+    USLOSS_Console("XXp2(): MboxRecvBuf() returned %d: '%s', same buffer: %s\n", rc, (char *) buf, buf == sentBuf ? "yes" : "no");
+    free(buf);
+
+    rc = MboxRecvBuf(zcbox, &buf);
+    USLOSS_Console("XXp2(): MboxRecvBuf() on the released mailbox returned %d\n", rc);
+
+    quit_phase_1a(4, tm_pid);
+}
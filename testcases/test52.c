@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks the system call table: a user-mode process reaches the kernel
+ * through Sys_ wrappers, the table counts every call, and an undefined call
+ * number halts the simulation.
+ */
+
+int XXp1(char *);
+
+int tm_pid = -1;
+
+int testcase_main()
+{
+    int status, kidpid, pid1, calls, time;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: XXp1 switches to user mode and uses only system calls, including to quit.  Afterwards the per-call counters match what it did, and calling an undefined syscall halts the simulation.\n");
+
+    pid1 = spork("XXp1", XXp1, "XXp1", USLOSS_MIN_STACK, 2);
+    USLOSS_Console("Phase 1A TEMPORARY HACK: Manually switching to the recently created XXp1()\n");
+    TEMP_switchTo(pid1);
+
+    kidpid = join(&status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+
+    syscallStats(SYS_GETPID, &calls, &time);
+    USLOSS_Console("testcase_main(): SYS_GETPID was called %d times\n", calls);
+    syscallStats(SYS_MBOXSEND, &calls, &time);
+    USLOSS_Console("testcase_main(): SYS_MBOXSEND was called %d times\n", calls);
+    syscallStats(SYS_QUIT_PHASE_1A, &calls, &time);
+    USLOSS_Console("testcase_main(): SYS_QUIT_PHASE_1A was called %d times\n", calls);
+    USLOSS_Console("testcase_main(): syscallStats(MAXSYSCALLS) returned %d\n", syscallStats(MAXSYSCALLS, &calls, &time));
+
+    USLOSS_Console("testcase_main(): calling undefined syscall 40\n");
+    USLOSS_Sysargs args;
+    args.number = 40;
+    USLOSS_Syscall(&args);
+
+    USLOSS_Console("testcase_main(): should not see this message!\n");
+    return 0;
+}
+
+int XXp1(char *arg)
+{
+    char buf[16];
+    int mbox, rc;
+
+    USLOSS_PsrSet(USLOSS_PsrGet() & ~USLOSS_PSR_CURRENT_MODE);
+    USLOSS_Console("XXp1(): in user mode, Sys_GetPid() returned %d\n", Sys_GetPid());
+    USLOSS_Console("XXp1(): Sys_GetPid() again returned %d\n", Sys_GetPid());
+
+    mbox = Sys_MboxCreate(1, sizeof(buf));
+    rc = Sys_MboxSend(mbox, "hello", 6);
+    USLOSS_Console("XXp1(): Sys_MboxSend() returned %d\n", rc);
+    rc = Sys_MboxRecv(mbox, buf, sizeof(buf));
+    USLOSS_Console("XXp1(): Sys_MboxRecv() returned %d: '%s'\n", rc, buf);
+    Sys_MboxRelease(mbox);
+
+    rc = Sys_Spork("XXp2", XXp1, NULL, USLOSS_MIN_STACK, 9);
+    USLOSS_Console("XXp1(): Sys_Spork() with a bad priority returned %d\n", rc);
+
+    Sys_Quit(3, tm_pid);
+}
@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks process groups: children inherit their parent's group, kill_group()
+ * marks only the group's members and wakes the ones that are blocked, in
+ * SemP(), MboxRecv() and clockSleep(), with -4, and join_group() reaps all
+ * of them at once while leaving other children for join().
+ */
+
+int XXp1(char *);
+
+int tm_pid = -1;
+int gate = -1;
+int mbox = -1;
+
+int testcase_main()
+{
+    char *waits[4] = { "SemP", "MboxRecv", "clockSleep", "SemP" };
+    int status, kidpid, gid, i, pids[4];
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: Three XXp1 children are sporked into a group and a fourth is moved out of it.  After kill_group(), the three group members return -4 from SemP(), MboxRecv() and clockSleep() and see isKilled() set; the fourth stays blocked until SemV(). join_group() reaps those three and join() reaps the last one.\n");
+
+    gid = create_group();
+    USLOSS_Console("testcase_main(): create_group() returned %d\n", gid);
+    USLOSS_Console("testcase_main(): set_group() on a bad group returned %d\n", set_group(tm_pid, MAXGROUPS));
+
+    gate = SemCreate(0);
+    mbox = MboxCreate(1, 16);
+    set_group(tm_pid, gid);
+    for (i = 0; i < 4; i++) {
+        pids[i] = spork("XXp1", XXp1, waits[i], USLOSS_MIN_STACK, 4);
+    }
+    set_group(tm_pid, 0);
+    set_group(pids[3], 0);
+    USLOSS_Console("testcase_main(): child %d is in group %d, child %d is in group %d\n",
+                   pids[0], get_group(pids[0]), pids[3], get_group(pids[3]));
+
+    USLOSS_Console("Phase 1A TEMPORARY HACK: Manually switching to each XXp1() so it blocks\n");
+    for (i = 0; i < 4; i++) {
+        TEMP_switchTo(pids[i]);
+    }
+
+    USLOSS_Console("testcase_main(): kill_group() returned %d\n", kill_group(gid));
+    USLOSS_Console("testcase_main(): isKilled() returned %d\n", isKilled());
+    USLOSS_Console("testcase_main(): ready %d, blocked %d\n", processCount(PROC_READY), processCount(PROC_BLOCKED));
+    for (i = 0; i < 3; i++) {
+        TEMP_switchTo(pids[i]);
+    }
+    SemV(gate);
+    TEMP_switchTo(pids[3]);
+
+    USLOSS_Console("testcase_main(): free_group() on a group with members returned %d\n", free_group(gid));
+    USLOSS_Console("testcase_main(): join_group() returned %d\n", join_group(gid));
+    kidpid = join(&status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+    USLOSS_Console("testcase_main(): join() with no children left returned %d\n", join(&status));
+    USLOSS_Console("testcase_main(): free_group() returned %d\n", free_group(gid));
+
+    return 0;
+}
+
+int XXp1(char *arg)
+{
+    char msg[16];
+    int rc;
+
+    USLOSS_Console("XXp1(): pid %d in group %d waiting in %s()\n", getpid(), get_group(getpid()), arg);
+    if (arg[0] == 'S') {
+        rc = SemP(gate);
+    }
+    else if (arg[0] == 'M') {
+        rc = MboxRecv(mbox, msg, sizeof(msg));
+    }
+    else {
+        rc = clockSleep(1000000);
+    }
+    USLOSS_Console("XXp1(): pid %d %s() returned %d", getpid(), arg, rc);
+    USLOSS_Console(", isKilled() returned %d\n", isKilled());
+
+    quit_phase_1a(getpid(), tm_pid);
+}
@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks orphan reparenting: with ORPHANS_REPARENT set, a process that quits
+ * with children no longer halts the simulation, and its children (and their
+ * own children) carry on under init.
+ */
+
+int XXp1(char *), XXp2(char *), XXp3(char *);
+
+int tm_pid = -1;
+int xxp2_pid = -1;
+
+int testcase_main()
+{
+    int status, kidpid, pid1;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: XXp1 quits while its two XXp2 children are still alive.  Instead of halting, the children are moved under init (PPID 1), and one of them can still spork, run and quit normally.\n");
+
+    USLOSS_Console("testcase_main(): set_orphan_policy(7) returned %d\n", set_orphan_policy(7));
+    USLOSS_Console("testcase_main(): set_orphan_policy(ORPHANS_REPARENT) returned %d\n", set_orphan_policy(ORPHANS_REPARENT));
+
+    pid1 = spork("XXp1", XXp1, "XXp1", USLOSS_MIN_STACK, 2);
+    USLOSS_Console("Phase 1A TEMPORARY HACK: Manually switching to the recently created XXp1()\n");
+    TEMP_switchTo(pid1);
+
+    USLOSS_Console("testcase_main(): XXp1 has quit\n");
+    dumpProcesses();
+
+    USLOSS_Console("Phase 1A TEMPORARY HACK: Manually switching to the first XXp2()\n");
+    TEMP_switchTo(xxp2_pid);
+    dumpProcesses();
+
+    kidpid = join(&status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+    USLOSS_Console("testcase_main(): join() again returned %d\n", join(&status));
+
+    return 0;
+}
+
+int XXp1(char *arg)
+{
+    xxp2_pid = spork("XXp2", XXp2, "first", USLOSS_MIN_STACK, 4);
+    spork("XXp2", XXp2, "second", USLOSS_MIN_STACK, 4);
+    dumpProcesses();
+
+    USLOSS_Console("XXp1(): quitting with two children\n");
+    quit_phase_1a(1, tm_pid);
+}
+
+int XXp2(char *arg)
+{
+    int status, kidpid;
+
+    USLOSS_Console("XXp2(): %s started\n", arg);
+    kidpid = spork("XXp3", XXp3, "XXp3", USLOSS_MIN_STACK, 1);
+    TEMP_switchTo(kidpid);
+    kidpid = join(&status);
+    USLOSS_Console("XXp2(): exit status for child %d is %d\n", kidpid, status);
+
+    quit_phase_1a(2, tm_pid);
+}
+
+int XXp3(char *arg)
+{
+    USLOSS_Console("XXp3(): started\n");
+    quit_phase_1a(3, xxp2_pid);
+}
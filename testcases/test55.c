@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks the native context switch backend: processes created with it spork,
+ * block on a semaphore, quit and are joined exactly like USLOSS ones, and
+ * switches between the two kinds go through the bridge.
+ */
+
+int XXp1(char *), XXp2(char *);
+
+int tm_pid = -1;
+int xxp1_pid = -1;
+int sem;
+
+int testcase_main()
+{
+    int status, kidpid, pid1;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: XXp1 runs on the native backend and sporks a USLOSS child XXp2 which blocks on a semaphore; XXp1 wakes it, XXp2 quits back to XXp1, and XXp1 joins it and quits to testcase_main.\n");
+
+    USLOSS_Console("testcase_main(): setSwitchBackend(7) returned %d\n", setSwitchBackend(7));
+    sem = SemCreate(0);
+
+    USLOSS_Console("testcase_main(): setSwitchBackend(SWITCH_NATIVE) returned %d\n", setSwitchBackend(SWITCH_NATIVE));
+    pid1 = spork("XXp1", XXp1, "XXp1", USLOSS_MIN_STACK, 2);
+    xxp1_pid = pid1;
+    USLOSS_Console("testcase_main(): setSwitchBackend(SWITCH_USLOSS) returned %d\n", setSwitchBackend(SWITCH_USLOSS));
+
+    USLOSS_Console("Phase 1A TEMPORARY HACK: Manually switching to the recently created XXp1()\n");
+    TEMP_switchTo(pid1);
+
+    kidpid = join(&status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+    USLOSS_Console("testcase_main(): bridged switches: %d\n", getSwitchCount(SWITCH_NATIVE + 1));
+
+    return 0;
+}
+
+int XXp1(char *arg)
+{
+    int status, kidpid, pid2;
+
+    USLOSS_Console("XXp1(): started, arg = '%s'\n", arg);
+
+    // the parent restored SWITCH_USLOSS before running us, so XXp2 uses it
+    pid2 = spork("XXp2", XXp2, "XXp2", USLOSS_MIN_STACK, 3);
+    USLOSS_Console("XXp1(): Manually switching to XXp2()\n");
+    TEMP_switchTo(pid2);
+
+    USLOSS_Console("XXp1(): back, waking XXp2()\n");
+    SemV(sem);
+    USLOSS_Console("Phase 1A TEMPORARY HACK: XXp1() manually switching to XXp2()\n");
+    TEMP_switchTo(pid2);
+
+    kidpid = join(&status);
+    USLOSS_Console("XXp1(): exit status for child %d is %d\n", kidpid, status);
+
+    quit_phase_1a(5, tm_pid);
+}
+
+int XXp2(char *arg)
+{
+    USLOSS_Console("XXp2(): started, blocking on the semaphore\n");
+    SemP(sem);
+    USLOSS_Console("XXp2(): woken, quitting\n");
+
+    quit_phase_1a(7, xxp1_pid);
+}
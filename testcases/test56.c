@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks the sampling profiler by raising clock interrupts by hand from
+ * several processes: samples are attributed to the running process by name,
+ * ticks beyond the buffer are dropped, and the clock handler that was
+ * installed first keeps running.  Last, it stops the profiler while a
+ * schedule recording that started after it is still on: the recording
+ * still sees the ticks that follow, and the profiler does not sample the
+ * ticks after the recording stops.
+ */
+
+int Worker(char *);
+
+int tm_pid = -1;
+int ticks = 0;
+
+static void countingClockHandler(int dev, void *arg)
+{
+    ticks++;
+}
+
+static void tick(int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        USLOSS_IntVec[USLOSS_CLOCK_INT](USLOSS_CLOCK_DEV, NULL);
+    }
+}
+
+int testcase_main()
+{
+    int status, kidpid, pid1, pid2, recorded, dropped;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: 3 samples for testcase_main and 4 for the two Workers together; the 8th tick is dropped, ticks after profileStop() are not sampled, and the original handler sees all 10. After a second profileStart(), a recording started after it logs all 3 ticks that follow, the profiler only samples the one before its profileStop(), and the original handler sees all 15.\n");
+
+    USLOSS_IntVec[USLOSS_CLOCK_INT] = countingClockHandler;
+
+    USLOSS_Console("testcase_main(): profileStart(0) returned %d\n", profileStart(0));
+    USLOSS_Console("testcase_main(): profileStart(7) returned %d\n", profileStart(7));
+    USLOSS_Console("testcase_main(): profileStart(7) again returned %d\n", profileStart(7));
+
+    tick(2);
+
+    pid1 = spork("Worker", Worker, "first", USLOSS_MIN_STACK, 2);
+    pid2 = spork("Worker", Worker, "second", USLOSS_MIN_STACK, 2);
+    USLOSS_Console("Phase 1A TEMPORARY HACK: Manually switching to the first Worker()\n");
+    TEMP_switchTo(pid1);
+    USLOSS_Console("Phase 1A TEMPORARY HACK: Manually switching to the second Worker()\n");
+    TEMP_switchTo(pid2);
+
+    tick(2);
+    USLOSS_Console("testcase_main(): profileStop() returned %d\n", profileStop());
+    USLOSS_Console("testcase_main(): profileStop() again returned %d\n", profileStop());
+    tick(2);
+
+    profileStats(&recorded, &dropped, NULL, NULL);
+    USLOSS_Console("testcase_main(): %d samples, %d dropped, %d ticks seen by the original handler\n", recorded, dropped, ticks);
+    USLOSS_Console("testcase_main(): profile:\n");
+    dumpProfile();
+
+    USLOSS_Console("testcase_main(): profileStart(7) returned %d\n", profileStart(7));
+    USLOSS_Console("testcase_main(): schedRecordStart() returned %d\n", schedRecordStart("test56.sched"));
+    tick(1);
+    USLOSS_Console("testcase_main(): profileStop() returned %d\n", profileStop());
+    tick(2);
+    USLOSS_Console("testcase_main(): schedLogStop() returned %d\n", schedLogStop());
+    tick(2);
+    unlink("test56.sched");
+
+    profileStats(&recorded, &dropped, NULL, NULL);
+    USLOSS_Console("testcase_main(): %d samples, %d ticks seen by the original handler\n", recorded, ticks);
+
+    kidpid = join(&status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+    kidpid = join(&status);
+    USLOSS_Console("testcase_main(): exit status for child %d is %d\n", kidpid, status);
+
+    return 0;
+}
+
+int Worker(char *arg)
+{
+    USLOSS_Console("Worker(): %s, two ticks\n", arg);
+    tick(2);
+    quit_phase_1a(3, tm_pid);
+}
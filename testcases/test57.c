@@ -0,0 +1,46 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks the latency histograms with hand-recorded samples, so the output
+ * does not depend on timing: exact buckets below 16 us, log-linear buckets
+ * above, percentiles capped at the exact maximum, and reset.
+ */
+
+int testcase_main()
+{
+    int i;
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: percentiles are exact below 16 us and at most 12.5%% high above it, never above the maximum; bad arguments and empty histograms give -1.\n");
+
+    latencyReset();
+
+    USLOSS_Console("testcase_main(): empty: count %d p50 %d\n", latencyCount(LAT_JOIN), latencyPercentile(LAT_JOIN, 50));
+    USLOSS_Console("testcase_main(): latencyCount(LAT_NUM) returned %d\n", latencyCount(LAT_NUM));
+
+    for (i = 1; i <= 10; i++) {
+        latencyRecord(LAT_JOIN, i);
+    }
+    latencyRecord(LAT_JOIN, -5);
+    USLOSS_Console("testcase_main(): 0..10: count %d p0 %d p50 %d p90 %d p100 %d\n", latencyCount(LAT_JOIN),
+                   latencyPercentile(LAT_JOIN, 0), latencyPercentile(LAT_JOIN, 50),
+                   latencyPercentile(LAT_JOIN, 90), latencyPercentile(LAT_JOIN, 100));
+    USLOSS_Console("testcase_main(): latencyPercentile(LAT_JOIN, 101) returned %d\n", latencyPercentile(LAT_JOIN, 101));
+
+    for (i = 1; i <= 1000; i++) {
+        latencyRecord(LAT_SPORK, i);
+    }
+    latencyRecord(LAT_SPORK, 1000000000);
+    USLOSS_Console("testcase_main(): 1..1000 and 1e9: p50 %d p90 %d p99 %d p100 %d\n",
+                   latencyPercentile(LAT_SPORK, 50), latencyPercentile(LAT_SPORK, 90),
+                   latencyPercentile(LAT_SPORK, 99), latencyPercentile(LAT_SPORK, 100));
+
+    dumpLatency();
+
+    latencyReset();
+    USLOSS_Console("testcase_main(): after reset: count %d\n", latencyCount(LAT_SPORK));
+
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks record/replay of scheduling: a run with blocking, wake-ups and a
+ * clock interrupt is recorded, replayed with the same number of events and
+ * interrupts, and then a run that switches differently is caught as a
+ * divergence.
+ */
+
+#define LOG "test58.sched"
+
+int Worker(char *);
+
+int tm_pid = -1;
+int sem;
+int ticks = 0;
+
+static void countingClockHandler(int dev, void *arg)
+{
+    ticks++;
+}
+
+static void scenario(int firstWorker)
+{
+    int status, pids[2];
+
+    sem = SemCreate(0);
+    pids[0] = spork("Waiter", Worker, "wait", USLOSS_MIN_STACK, 2);
+    pids[1] = spork("Poster", Worker, "post", USLOSS_MIN_STACK, 2);
+
+    TEMP_switchTo(pids[firstWorker]);
+    USLOSS_Console("testcase_main(): joined %d\n", join(&status));
+    TEMP_switchTo(pids[0]);
+    USLOSS_Console("testcase_main(): joined %d\n", join(&status));
+    SemFree(sem);
+}
+
+int testcase_main()
+{
+    int events, size;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: the replay has as many events and clock ticks as the recording; the last run starts with the other worker and is stopped as a divergence.\n");
+
+    USLOSS_IntVec[USLOSS_CLOCK_INT] = countingClockHandler;
+
+    USLOSS_Console("testcase_main(): schedReplayStart(missing file) returned %d\n", schedReplayStart("no-such-file.sched"));
+    USLOSS_Console("testcase_main(): schedLogStop() returned %d\n", schedLogStop());
+
+    USLOSS_Console("testcase_main(): recording\n");
+    USLOSS_Console("testcase_main(): schedRecordStart() returned %d\n", schedRecordStart(LOG));
+    USLOSS_Console("testcase_main(): schedRecordStart() again returned %d\n", schedRecordStart(LOG));
+    scenario(0);
+    size = schedLogSize();
+    events = schedLogStop();
+    USLOSS_Console("testcase_main(): recorded %d events in %d bytes, %d ticks\n", events, size, ticks);
+
+    ticks = 0;
+    USLOSS_Console("testcase_main(): replaying\n");
+    USLOSS_Console("testcase_main(): schedReplayStart() returned %d\n", schedReplayStart(LOG));
+    scenario(0);
+    events = schedLogStop();
+    USLOSS_Console("testcase_main(): replayed %d events, %d ticks\n", events, ticks);
+
+    USLOSS_Console("testcase_main(): replaying a different run\n");
+    USLOSS_Console("testcase_main(): schedReplayStart() returned %d\n", schedReplayStart(LOG));
+    remove(LOG);
+    scenario(1);
+
+    USLOSS_Console("testcase_main(): ERROR: the divergence was not caught\n");
+    return 0;
+}
+
+int Worker(char *arg)
+{
+    if (arg[0] == 'w') {
+        USLOSS_Console("Worker(): waiting\n");
+        SemP(sem);
+        USLOSS_Console("Worker(): woken\n");
+    }
+    else {
+        USLOSS_Console("Worker(): tick, then posting\n");
+        USLOSS_IntVec[USLOSS_CLOCK_INT](USLOSS_CLOCK_DEV, NULL);
+        SemV(sem);
+    }
+    quit_phase_1a(0, tm_pid);
+}
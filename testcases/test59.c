@@ -0,0 +1,56 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks checkProcessTable() and that a zombie keeps its slot: XXp1 quits
+ * and stays unjoined while testcase_main sporks more than MAXPROC more
+ * processes (joining each), so the slot numbers wrap around past the zombie.
+ */
+
+int XXp1(char *), XXp2(char *);
+
+int tm_pid = -1;
+
+int testcase_main()
+{
+    int status, kidpid, pid1, i, failures = 0;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: the invariants hold throughout, the zombie XXp1 is never overwritten, and it is joined last with its own status.\n");
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d\n", checkProcessTable());
+
+    pid1 = spork("XXp1", XXp1, "XXp1", USLOSS_MIN_STACK, 2);
+    TEMP_switchTo(pid1);
+    USLOSS_Console("testcase_main(): XXp1 (pid %d) is a zombie; checkProcessTable() returned %d\n", pid1, checkProcessTable());
+
+    for (i = 0; i < 2 * MAXPROC; i++) {
+        kidpid = spork("XXp2", XXp2, "XXp2", USLOSS_MIN_STACK, 2);
+        if (kidpid % MAXPROC == pid1 % MAXPROC) {
+            USLOSS_Console("ERROR: spork() reused the zombie's slot for pid %d\n", kidpid);
+        }
+        TEMP_switchTo(kidpid);
+        if (join(&status) != kidpid || checkProcessTable() != 0) {
+            failures++;
+        }
+    }
+    USLOSS_Console("testcase_main(): %d spork/join rounds, %d failures\n", 2 * MAXPROC, failures);
+
+    kidpid = join(&status);
+    USLOSS_Console("testcase_main(): joined %d (XXp1 is %d) with status %d\n", kidpid, pid1, status);
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d\n", checkProcessTable());
+
+    return 0;
+}
+
+int XXp1(char *arg)
+{
+    quit_phase_1a(11, tm_pid);
+}
+
+int XXp2(char *arg)
+{
+    quit_phase_1a(22, tm_pid);
+}
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks memory accounting and limits: stacks are charged at spork(), turn
+ * into zombie bytes at quit and are released at join(); spork() returns -3
+ * once the stack limit or the per-parent child limit would be exceeded.
+ */
+
+int XXp1(char *);
+
+int tm_pid = -1;
+
+static void show(char *label, int pid)
+{
+    struct MemStats st;
+
+    getMemStats(pid, &st);
+    USLOSS_Console("%-28s stack %7ld  zombie %7ld  peak %7ld  children %d\n",
+                   label, st.stackBytes, st.zombieBytes, st.peakBytes, st.children);
+}
+
+int testcase_main()
+{
+    int status, kidpid, pid1, pid2;
+    struct MemStats st;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: byte counts follow each spork/quit/join; with a 2-child limit the third spork() and with a stack limit an oversized spork() return -3.\n");
+
+    USLOSS_Console("testcase_main(): getMemStats(NULL) returned %d, getMemStats(99) returned %d\n",
+                   getMemStats(0, NULL), getMemStats(99, &st));
+    USLOSS_Console("testcase_main(): setMemLimits(-1, 0) returned %d\n", setMemLimits(-1, 0));
+    show("kernel at start:", 0);
+
+    pid1 = spork("XXp1", XXp1, NULL, USLOSS_MIN_STACK, 2);
+    pid2 = spork("XXp1", XXp1, NULL, 2 * USLOSS_MIN_STACK, 2);
+    show("kernel after two sporks:", 0);
+    show("testcase_main after two:", tm_pid);
+
+    TEMP_switchTo(pid2);
+    show("kernel, one zombie:", 0);
+    show("testcase_main, one zombie:", tm_pid);
+
+    USLOSS_Console("testcase_main(): setMemLimits(0, 2) returned %d\n", setMemLimits(0, 2));
+    USLOSS_Console("testcase_main(): third spork() returned %d\n", spork("XXp1", XXp1, NULL, USLOSS_MIN_STACK, 2));
+
+    kidpid = join(&status);
+    USLOSS_Console("testcase_main(): joined %d with status %d\n", kidpid, status);
+    show("kernel after join:", 0);
+
+    USLOSS_Console("testcase_main(): setMemLimits(4 * MIN_STACK, 0) returned %d\n", setMemLimits(4 * USLOSS_MIN_STACK, 0));
+    USLOSS_Console("testcase_main(): spork() of 2 * MIN_STACK returned %d\n", spork("XXp1", XXp1, NULL, 2 * USLOSS_MIN_STACK, 2));
+    pid2 = spork("XXp1", XXp1, NULL, USLOSS_MIN_STACK, 2);
+    USLOSS_Console("testcase_main(): spork() of MIN_STACK returned %s\n", pid2 > 0 ? "a pid" : "an error");
+    setMemLimits(0, 0);
+
+    TEMP_switchTo(pid1);
+    TEMP_switchTo(pid2);
+    join(&status);
+    join(&status);
+    show("kernel at end:", 0);
+    show("testcase_main at end:", tm_pid);
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d\n", checkProcessTable());
+
+    return 0;
+}
+
+int XXp1(char *arg)
+{
+    quit_phase_1a(getpid(), tm_pid);
+}
@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <string.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks copy-on-write regions: a spork_clone() child sees the parent's
+ * region contents without a copy, its first write gives it a private copy
+ * that the parent does not see, and buffers are freed once nobody uses them.
+ */
+
+int Reader(char *), Writer(char *);
+
+int tm_pid = -1;
+int table;
+
+static void show(char *label)
+{
+    struct MemStats st;
+
+    getMemStats(0, &st);
+    USLOSS_Console("%-34s region bytes %ld\n", label, st.regionBytes);
+}
+
+int testcase_main()
+{
+    int status, pid1, pid2, pid3;
+    char *p;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: the children read \"hello\" without copying; the Writer's change stays private; a plain spork() child has no regions; all region memory is gone at the end.\n");
+
+    USLOSS_Console("testcase_main(): regionCreate(0) returned %d\n", regionCreate(0));
+    table = regionCreate(4096);
+    USLOSS_Console("testcase_main(): regionCreate(4096) returned %d\n", table);
+    strcpy(regionWrite(table), "hello");
+    show("testcase_main(): after create:");
+
+    pid1 = spork_clone("Reader", Reader, NULL, USLOSS_MIN_STACK, 2);
+    pid2 = spork_clone("Writer", Writer, NULL, USLOSS_MIN_STACK, 2);
+    pid3 = spork("Plain", Reader, NULL, USLOSS_MIN_STACK, 2);
+    show("testcase_main(): after three sporks:");
+
+    TEMP_switchTo(pid1);
+    TEMP_switchTo(pid2);
+    TEMP_switchTo(pid3);
+
+    p = regionGet(table);
+    USLOSS_Console("testcase_main(): parent still reads \"%s\"\n", p);
+    show("testcase_main(): after children quit:");
+
+    join(&status);
+    join(&status);
+    join(&status);
+
+    USLOSS_Console("testcase_main(): regionDetach() returned %d, again %d\n", regionDetach(table), regionDetach(table));
+    USLOSS_Console("testcase_main(): regionGet() after detach returned %s\n", regionGet(table) == NULL ? "NULL" : "a pointer");
+    show("testcase_main(): at end:");
+
+    return 0;
+}
+
+int Reader(char *arg)
+{
+    char *p = regionGet(table);
+
+    USLOSS_Console("Reader(): pid %d reads \"%s\", region size %d\n", getpid(), p == NULL ? "(not attached)" : p, regionSize(table));
+    show("Reader(): after reading:");
+    quit_phase_1a(0, tm_pid);
+}
+
+int Writer(char *arg)
+{
+    char *p = regionWrite(table);
+
+    strcpy(p, "world");
+    USLOSS_Console("Writer(): wrote \"%s\" into its own copy\n", (char *) regionGet(table));
+    show("Writer(): after writing:");
+    quit_phase_1a(0, tm_pid);
+}
@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks clockSleep() and the idle process: sleepers wake in order of their
+ * wake-up tick whatever their priority, the idle process runs only while
+ * every process is asleep, and the process table invariants still hold.
+ */
+
+int Sleeper(char *);
+
+int tm_pid = -1;
+int done;
+
+int testcase_main()
+{
+    int status, kidpid, i, waits;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: the sleepers wake after 1, 2 and 3 ticks, in that order; testcase_main wakes last and lets each one quit; the idle process waited for every tick.\n");
+
+    USLOSS_Console("testcase_main(): clockSleep(-1) returned %d, clockSleep(0) returned %d\n", clockSleep(-1), clockSleep(0));
+    USLOSS_Console("testcase_main(): setIdleMode(5) returned %d\n", setIdleMode(5));
+    done = SemCreate(0);
+
+    spork("Sleeper", Sleeper, "3", USLOSS_MIN_STACK, 1);
+    spork("Sleeper", Sleeper, "1", USLOSS_MIN_STACK, 2);
+    spork("Sleeper", Sleeper, "2", USLOSS_MIN_STACK, 1);
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d\n", checkProcessTable());
+
+    USLOSS_Console("testcase_main(): sleeping for 5 ticks\n");
+    clockSleep(5);
+    USLOSS_Console("testcase_main(): awake\n");
+
+    for (i = 0; i < 3; i++) {
+        SemV(done);
+        kidpid = join(&status);
+        USLOSS_Console("testcase_main(): joined %d with status %d\n", kidpid, status);
+    }
+
+    waits = idleStats(NULL, NULL);
+    USLOSS_Console("testcase_main(): the idle process waited for %d ticks\n", waits);
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d\n", checkProcessTable());
+
+    return 0;
+}
+
+int Sleeper(char *arg)
+{
+    int ticks = arg[0] - '0';
+
+    USLOSS_Console("Sleeper(): pid %d sleeping for %d ticks\n", getpid(), ticks);
+    clockSleep(ticks);
+    USLOSS_Console("Sleeper(): pid %d awake after %d ticks\n", getpid(), ticks);
+
+    // testcase_main may still be asleep; wait until it can be switched to
+    SemP(done);
+    quit_phase_1a(ticks, tm_pid);
+}
@@ -0,0 +1,69 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks the process state machine: processCount() follows each spork,
+ * block, quit and join; dumpProcesses() shows blocked processes as such;
+ * switching to a blocked process is an illegal transition and halts.
+ */
+
+int Waiter(char *), Quitter(char *);
+
+int tm_pid = -1;
+int sem;
+
+static void show(char *label)
+{
+    USLOSS_Console("%-32s free %2d  ready %d  running %d  blocked %d  zombie %d\n", label,
+                   processCount(PROC_FREE), processCount(PROC_READY), processCount(PROC_RUNNING),
+                   processCount(PROC_BLOCKED), processCount(PROC_ZOMBIE));
+}
+
+int testcase_main()
+{
+    int status, waiter, quitter;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: the counts move by one with each step; the Waiter shows as Blocked; switching to it halts the simulation.\n");
+
+    USLOSS_Console("testcase_main(): processCount(-1) returned %d, processCount(PROC_NUM_STATES) returned %d\n",
+                   processCount(-1), processCount(PROC_NUM_STATES));
+    show("testcase_main(): at start:");
+
+    sem = SemCreate(0);
+    waiter = spork("Waiter", Waiter, NULL, USLOSS_MIN_STACK, 4);
+    quitter = spork("Quitter", Quitter, NULL, USLOSS_MIN_STACK, 4);
+    show("testcase_main(): after sporks:");
+
+    TEMP_switchTo(waiter);
+    show("testcase_main(): Waiter blocked:");
+
+    TEMP_switchTo(quitter);
+    show("testcase_main(): Quitter quit:");
+    dumpProcesses();
+
+    join(&status);
+    show("testcase_main(): after join:");
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d\n", checkProcessTable());
+
+    USLOSS_Console("testcase_main(): switching to the blocked Waiter\n");
+    TEMP_switchTo(waiter);
+
+    USLOSS_Console("testcase_main(): ERROR: the switch went through\n");
+    return 0;
+}
+
+int Waiter(char *arg)
+{
+    SemP(sem);
+    USLOSS_Console("Waiter(): ERROR: woke up\n");
+    quit_phase_1a(0, tm_pid);
+}
+
+int Quitter(char *arg)
+{
+    quit_phase_1a(7, tm_pid);
+}
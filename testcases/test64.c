@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks the stride scheduling policy's API and its effect on wake-ups:
+ * under POLICY_STRIDE, waking a higher-priority process does not switch to
+ * it, since priorities no longer decide who runs; switching policies moves
+ * the ready processes between the queues and the stride heap.
+ */
+
+int High(char *);
+
+int tm_pid = -1;
+int wake, back;
+
+int testcase_main()
+{
+    int status, high;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: bad arguments return -1; under POLICY_STRIDE, High (priority 1) only runs once testcase_main blocks.\n");
+
+    USLOSS_Console("testcase_main(): setSchedPolicy(2) returned %d\n", setSchedPolicy(2));
+    USLOSS_Console("testcase_main(): setTickets(99, 10) returned %d, setTickets(me, 0) returned %d, setTickets(me, MAXTICKETS + 1) returned %d\n",
+                   setTickets(99, 10), setTickets(tm_pid, 0), setTickets(tm_pid, MAXTICKETS + 1));
+    USLOSS_Console("testcase_main(): setTickets(me, 300) returned %d\n", setTickets(tm_pid, 300));
+    USLOSS_Console("testcase_main(): setTickets(me, DEFAULT_TICKETS) returned %d\n", setTickets(tm_pid, DEFAULT_TICKETS));
+
+    wake = SemCreate(0);
+    back = SemCreate(0);
+    high = spork("High", High, NULL, USLOSS_MIN_STACK, 1);
+    TEMP_switchTo(high);
+
+    USLOSS_Console("testcase_main(): setSchedPolicy(POLICY_STRIDE) returned %d\n", setSchedPolicy(POLICY_STRIDE));
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d\n", checkProcessTable());
+
+    USLOSS_Console("testcase_main(): waking High\n");
+    SemV(wake);
+    USLOSS_Console("testcase_main(): SemV() returned without running High\n");
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d\n", checkProcessTable());
+
+    USLOSS_Console("testcase_main(): blocking\n");
+    SemP(back);
+    USLOSS_Console("testcase_main(): back\n");
+
+    USLOSS_Console("testcase_main(): setSchedPolicy(POLICY_PRIORITY) returned %d\n", setSchedPolicy(POLICY_PRIORITY));
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d\n", checkProcessTable());
+    TEMP_switchTo(high);
+
+    join(&status);
+    USLOSS_Console("testcase_main(): joined High with status %d\n", status);
+    return 0;
+}
+
+int High(char *arg)
+{
+    USLOSS_Console("High(): blocking\n");
+    SemP(wake);
+    USLOSS_Console("High(): running; waking testcase_main\n");
+    SemV(back);
+    USLOSS_Console("High(): SemV() returned; switching back\n");
+    TEMP_switchTo(tm_pid);
+    USLOSS_Console("High(): quitting\n");
+    quit_phase_1a(5, tm_pid);
+}
@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks smpRun(): four workers each spork and join three children, which
+ * may run on other CPUs. Each child also fills arena pages with
+ * proc_alloc(), while others on other CPUs allocate and are reaped. Every
+ * child's exit status reaches its parent, no two children's memory
+ * overlaps, spork_clone() and regionCreate() fail on the CPUs, and the
+ * process table is consistent afterwards. In builds without SMP=1, smpRun()
+ * returns -1 and the same workload runs on one CPU instead, so the output
+ * is the same either way.
+ */
+
+#define WORKERS   4
+#define CHILDREN  3
+#define OBJS      300
+
+int Worker(char *), Child(char *);
+
+int tm_pid = -1;
+int smp;
+int workerPids[WORKERS];
+int sums[WORKERS];
+int badAllocs;
+int regionCalls;
+
+int testcase_main()
+{
+    int status, i, pid, total = 0;
+    int workers[WORKERS];
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: bad core counts return -1; each worker joins all of its children and gets their statuses; no region call succeeds on the CPUs; the table checks out afterwards.\n");
+
+    USLOSS_Console("testcase_main(): smpRun(0) returned %d\n", smpRun(0, NULL));
+    USLOSS_Console("testcase_main(): smpRun(SMP_MAXCPUS + 1) returned %d\n", smpRun(SMP_MAXCPUS + 1, NULL));
+
+    for (i = 0; i < WORKERS; i++) {
+        workers[i] = spork("Worker", Worker, (char *) (long) i, USLOSS_MIN_STACK, 3);
+    }
+
+    smp = 1;
+    if (smpRun(2, NULL) < 0) {
+        smp = 0;
+        for (i = 0; i < WORKERS; i++) {
+            TEMP_switchTo(workers[i]);
+        }
+    }
+    USLOSS_Console("testcase_main(): workers done\n");
+    USLOSS_Console("testcase_main(): zombies %d, ready %d\n", processCount(PROC_ZOMBIE), processCount(PROC_READY));
+
+    for (i = 0; i < WORKERS; i++) {
+        pid = join(&status);
+        total += status;
+    }
+    for (i = 0; i < WORKERS; i++) {
+        USLOSS_Console("testcase_main(): worker %d's children returned statuses adding up to %d\n", i, sums[i]);
+    }
+    USLOSS_Console("testcase_main(): %d bad allocations\n", badAllocs);
+    USLOSS_Console("testcase_main(): %d region calls succeeded on the CPUs\n", regionCalls);
+    USLOSS_Console("testcase_main(): worker statuses add up to %d, last join returned %s\n", total,
+                   pid > 0 ? "a pid" : "an error");
+    USLOSS_Console("testcase_main(): join() with no children left returned %d\n", join(&status));
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d\n", checkProcessTable());
+    return 0;
+}
+
+int Worker(char *arg)
+{
+    int me = (int) (long) arg;
+    int i, status, child;
+
+    workerPids[me] = getpid();
+    if (smp && (spork_clone("Child", Child, NULL, USLOSS_MIN_STACK, 2) != -1 || regionCreate(8) != -1)) {
+        __atomic_add_fetch(&regionCalls, 1, __ATOMIC_RELAXED);
+    }
+    for (i = 0; i < CHILDREN; i++) {
+        child = spork("Child", Child, (char *) (long) (10 * me + i), USLOSS_MIN_STACK, 2);
+        if (!smp) {
+            TEMP_switchTo(child);
+        }
+        if (join(&status) != child) {
+            USLOSS_Console("Worker(): ERROR: joined the wrong child\n");
+        }
+        sums[me] += status;
+    }
+    quit_phase_1a(me, tm_pid);
+}
+
+int Child(char *arg)
+{
+    int n = (int) (long) arg;
+    volatile long i, work = 0;
+    int *objs[OBJS];
+
+    for (i = 0; i < OBJS; i++) {
+        objs[i] = proc_alloc(64);
+        objs[i][0] = n;
+    }
+    for (i = 0; i < 10000; i++) {
+        work += i;
+    }
+    for (i = 0; i < OBJS; i++) {
+        if (objs[i][0] != n) {
+            __atomic_add_fetch(&badAllocs, 1, __ATOMIC_RELAXED);
+        }
+    }
+    quit_phase_1a(n, workerPids[n / 10]);
+}
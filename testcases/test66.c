@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks the terminal output driver: a write that fits in the ring returns
+ * at once, with the first character already on its way; a write bigger
+ * than the ring blocks its writer until the ring drains; termFlush() waits
+ * for the last character; what reaches term1.out and term2.out is exactly
+ * what was written. A schedule recording cannot start while a terminal is
+ * busy, and during one a write that fills the ring, or a flush that would
+ * wait, returns -2.
+ */
+
+#define BIG  600
+
+int Writer(char *);
+
+int tm_pid = -1;
+int done;
+char big[BIG];
+
+static int fileMatches(char *name, char *expect, int len)
+{
+    char buf[BIG + 1];
+    FILE *f = fopen(name, "r");
+    int n;
+
+    if (f == NULL) {
+        return 0;
+    }
+    n = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+    return n == len && memcmp(buf, expect, len) == 0;
+}
+
+int testcase_main()
+{
+    struct TermStats stats;
+    char *hello = "hello, terminal\n";
+    int status, i;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: bad arguments return -1; the short write returns without stalling; the Writer stalls on its %d-byte write and both files match what was written.\n", BIG);
+
+    USLOSS_Console("testcase_main(): termWrite(-1) returned %d, termWrite(4) returned %d\n",
+                   termWrite(-1, hello, 1), termWrite(USLOSS_TERM_UNITS, hello, 1));
+    USLOSS_Console("testcase_main(): termWrite(NULL) returned %d, termWrite(len -1) returned %d\n",
+                   termWrite(1, NULL, 1), termWrite(1, hello, -1));
+    USLOSS_Console("testcase_main(): termFlush(9) returned %d, termStats(0, NULL) returned %d\n",
+                   termFlush(9), termStats(0, NULL));
+
+    USLOSS_Console("testcase_main(): termWrite(1, hello) returned %d\n", termWrite(1, hello, strlen(hello)));
+    termStats(1, &stats);
+    USLOSS_Console("testcase_main(): term 1: chars sent %ld, queued %d, stalls %d\n", stats.chars, stats.queued, stats.stalls);
+
+    for (i = 0; i < BIG; i++) {
+        big[i] = 'a' + i % 26;
+    }
+    done = SemCreate(0);
+    spork("Writer", Writer, NULL, USLOSS_MIN_STACK, 2);
+    SemP(done);
+    join(&status);
+
+    termStats(2, &stats);
+    USLOSS_Console("testcase_main(): term 2: chars sent %ld, interrupts %ld, queued %d, stalled %s\n",
+                   stats.chars, stats.interrupts, stats.queued, stats.stalls > 0 ? "yes" : "no");
+
+    USLOSS_Console("testcase_main(): termFlush(1) returned %d\n", termFlush(1));
+    termStats(1, &stats);
+    USLOSS_Console("testcase_main(): term 1: chars sent %ld, interrupts %ld, queued %d\n", stats.chars, stats.interrupts, stats.queued);
+
+    USLOSS_Console("testcase_main(): term1.out matches: %s\n", fileMatches("term1.out", hello, strlen(hello)) ? "yes" : "no");
+    USLOSS_Console("testcase_main(): term2.out matches: %s\n", fileMatches("term2.out", big, BIG) ? "yes" : "no");
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d\n", checkProcessTable());
+
+    termWrite(3, hello, strlen(hello));
+    USLOSS_Console("testcase_main(): term 3 busy, schedRecordStart() returned %d\n", schedRecordStart("test66.sched"));
+    termFlush(3);
+    USLOSS_Console("testcase_main(): term 3 idle, schedRecordStart() returned %d\n", schedRecordStart("test66.sched"));
+    USLOSS_Console("testcase_main(): recording, termWrite(3, %d bytes) returned %d\n", BIG, termWrite(3, big, BIG));
+    USLOSS_Console("testcase_main(): recording, termFlush(3) returned %d\n", termFlush(3));
+    schedLogStop();
+    USLOSS_Console("testcase_main(): stopped, termFlush(3) returned %d\n", termFlush(3));
+    unlink("test66.sched");
+    return 0;
+}
+
+int Writer(char *arg)
+{
+    USLOSS_Console("Writer(): termWrite(2, %d bytes) returned %d\n", BIG, termWrite(2, big, BIG));
+    USLOSS_Console("Writer(): termFlush(2) returned %d\n", termFlush(2));
+    SemV(done);
+    quit_phase_1a(0, tm_pid);
+}
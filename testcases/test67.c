@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks micro-tasks: bad arguments return -1; tasks at a higher priority
+ * than testcase_main run once it blocks in join(), in creation order, with a
+ * yielding task resumed at its step behind the others; a task created by a
+ * task belongs to the same parent; join() collects every task with its
+ * status and then returns -2; the process table holds no trace of them.
+ */
+
+int Square(void *, int *), Counter(void *, int *), Spawner(void *, int *);
+
+int tm_pid = -1;
+int ids[6];
+char *names[6] = { "Square 1", "Square 2", "Square 3", "Counter", "Spawner", "Square 4" };
+
+int testcase_main()
+{
+    struct TaskStats stats;
+    int status, i, id;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: bad arguments return -1; the priority 2 tasks run first, Counter's steps interleaved with the squares; Spawner's task is joined by testcase_main; join() then returns -2.\n");
+
+    USLOSS_Console("testcase_main(): taskCreate(NULL) returned %d, priority 0 returned %d, priority 6 returned %d\n",
+                   taskCreate(NULL, NULL, 2), taskCreate(Square, NULL, 0), taskCreate(Square, NULL, 6));
+    USLOSS_Console("testcase_main(): taskStats(NULL) returned %d\n", taskStats(NULL));
+
+    ids[4] = taskCreate(Spawner, NULL, 4);
+    ids[3] = taskCreate(Counter, NULL, 2);
+    for (i = 0; i < 3; i++) {
+        ids[i] = taskCreate(Square, (void *) (long) (i + 1), 2);
+    }
+    USLOSS_Console("testcase_main(): created 5 tasks, none has run yet\n");
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d, ready processes %d\n",
+                   checkProcessTable(), processCount(PROC_READY));
+
+    while ((id = join(&status)) > 0) {
+        for (i = 0; i < 6 && ids[i] != id; i++) {
+        }
+        USLOSS_Console("testcase_main(): join() returned %s, status %d\n", i < 6 ? names[i] : "an unknown id", status);
+    }
+    USLOSS_Console("testcase_main(): join() returned %d\n", id);
+
+    taskStats(&stats);
+    USLOSS_Console("testcase_main(): created %d, in use %d, yields %d, %s than 64 bytes per task\n",
+                   stats.created, stats.inUse, stats.yields, stats.taskBytes <= 64 ? "no more" : "more");
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d\n", checkProcessTable());
+    return 0;
+}
+
+int Square(void *arg, int *step)
+{
+    int n = (int) (long) arg;
+
+    USLOSS_Console("Square(%d): returning %d\n", n, n * n);
+    return n * n;
+}
+
+int Counter(void *arg, int *step)
+{
+    USLOSS_Console("Counter(): step %d\n", *step);
+    if (*step == 1) {
+        USLOSS_Console("Counter(): checkProcessTable() returned %d\n", checkProcessTable());
+    }
+    if (*step < 3) {
+        (*step)++;
+        return TASK_YIELD;
+    }
+    return 100;
+}
+
+int Spawner(void *arg, int *step)
+{
+    ids[5] = taskCreate(Square, (void *) 4L, 2);
+    USLOSS_Console("Spawner(): created Square 4\n");
+    return 7;
+}
@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks per-process arenas: bad sizes return NULL; allocations are aligned,
+ * distinct and spill onto new pages as needed; a child's pages stay in use
+ * while it is a zombie and all go back to the pool when it is joined; a
+ * second child reuses them without the pool growing.
+ */
+
+#define OBJS  300
+
+int Allocator(char *);
+
+int tm_pid = -1;
+
+static void showPool(char *when)
+{
+    struct ArenaStats stats;
+
+    arenaStats(&stats);
+    USLOSS_Console("testcase_main(): %s: pages in use %d, free %d, total %d, allocs %ld\n", when,
+                   stats.pagesInUse, stats.pagesFree, stats.pagesTotal, stats.allocs);
+}
+
+int testcase_main()
+{
+    int status, pid;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: bad sizes return NULL; each Allocator holds 5 pages until it is joined; the second Allocator reuses the first one's pages.\n");
+
+    USLOSS_Console("testcase_main(): proc_alloc(0) %s, proc_alloc(-1) %s, proc_alloc(ARENA_MAX_ALLOC + 1) %s\n",
+                   proc_alloc(0) == NULL ? "NULL" : "not NULL", proc_alloc(-1) == NULL ? "NULL" : "not NULL",
+                   proc_alloc(ARENA_MAX_ALLOC + 1) == NULL ? "NULL" : "not NULL");
+    USLOSS_Console("testcase_main(): arenaStats(NULL) returned %d\n", arenaStats(NULL));
+    showPool("at start");
+
+    pid = spork("Allocator", Allocator, "1", USLOSS_MIN_STACK, 2);
+    TEMP_switchTo(pid);
+    showPool("Allocator 1 is a zombie");
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d\n", checkProcessTable());
+    USLOSS_Console("testcase_main(): join() returned %s", join(&status) == pid ? "Allocator 1" : "something else");
+    USLOSS_Console(", status %d\n", status);
+    showPool("Allocator 1 joined");
+
+    pid = spork("Allocator", Allocator, "2", USLOSS_MIN_STACK, 2);
+    TEMP_switchTo(pid);
+    join(&status);
+    showPool("Allocator 2 joined");
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d\n", checkProcessTable());
+    return 0;
+}
+
+int Allocator(char *arg)
+{
+    char *objs[OBJS];
+    char *big;
+    int i, bad = 0;
+
+    // 33 bytes round up to 48, 85 to a page, so 300 objects take 4 pages;
+    // the largest allocation then needs a page of its own
+    for (i = 0; i < OBJS; i++) {
+        objs[i] = proc_alloc(33);
+        if (objs[i] == NULL || ((long) objs[i] & 15) != 0) {
+            bad++;
+            continue;
+        }
+        memset(objs[i], i & 0xff, 33);
+    }
+    for (i = 0; i < OBJS; i++) {
+        if (objs[i] != NULL && (objs[i][0] != (char) (i & 0xff) || objs[i][32] != (char) (i & 0xff))) {
+            bad++;
+        }
+    }
+    big = proc_alloc(ARENA_MAX_ALLOC);
+    USLOSS_Console("Allocator(%s): %d objects, %d bad; proc_alloc(ARENA_MAX_ALLOC) %s\n", arg, OBJS, bad,
+                   big == NULL ? "failed" : "worked");
+    quit_phase_1a(atoi(arg), tm_pid);
+}
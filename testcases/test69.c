@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks that a stale pid is rejected once its slot has been reused: the
+ * calls that take a pid return -1 for it but work for the process now in
+ * the slot, and TEMP_switchTo() with it halts, naming the new holder instead
+ * of switching to the wrong process.
+ */
+
+int Child(char *);
+
+int tm_pid = -1;
+
+int testcase_main()
+{
+    struct MemStats stats;
+    int status, stale, pid;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: calls with the stale pid return -1, the same calls with its slot's new pid work, and TEMP_switchTo(stale) halts the simulation.\n");
+
+    stale = spork("Child", Child, NULL, USLOSS_MIN_STACK, 2);
+    TEMP_switchTo(stale);
+    join(&status);
+    USLOSS_Console("testcase_main(): joined the first Child\n");
+    USLOSS_Console("testcase_main(): get_group(stale) returned %d, setTickets(stale) returned %d, getMemStats(stale) returned %d\n",
+                   get_group(stale), setTickets(stale, 10), getMemStats(stale, &stats));
+    USLOSS_Console("testcase_main(): get_group(0) returned %d, get_group(-7) returned %d, getMemStats(-7) returned %d\n",
+                   get_group(0), get_group(-7), getMemStats(-7, &stats));
+
+    // run through pids until a new process lands in the stale pid's slot
+    do {
+        pid = spork("Child", Child, NULL, USLOSS_MIN_STACK, 2);
+        if (pid % MAXPROC != stale % MAXPROC) {
+            TEMP_switchTo(pid);
+            join(&status);
+        }
+    } while (pid % MAXPROC != stale % MAXPROC);
+    USLOSS_Console("testcase_main(): pid %d is in the same slot as %d\n", pid, stale);
+
+    USLOSS_Console("testcase_main(): get_group(new) returned %d, setTickets(new) returned %d, getMemStats(new) returned %d\n",
+                   get_group(pid), setTickets(pid, 10), getMemStats(pid, &stats));
+    USLOSS_Console("testcase_main(): get_group(stale) returned %d, setTickets(stale) returned %d, getMemStats(stale) returned %d\n",
+                   get_group(stale), setTickets(stale, 10), getMemStats(stale, &stats));
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d\n", checkProcessTable());
+
+    USLOSS_Console("testcase_main(): TEMP_switchTo(stale)\n");
+    TEMP_switchTo(stale);
+
+    USLOSS_Console("testcase_main(): ERROR: TEMP_switchTo(stale) returned\n");
+    return 0;
+}
+
+int Child(char *arg)
+{
+    quit_phase_1a(0, tm_pid);
+}
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks checkpoints (host harness only). The run first restarts itself
+ * with USLOSS_HOST_CHECKPOINT set, which checkpoints need. testcase_main()
+ * then leaves three Waiters blocked on a semaphore, two messages in a
+ * mailbox and a string in its arena, saves a checkpoint and changes a
+ * global. It then runs a copy of this binary that restores the checkpoint:
+ * there, checkpointSave() returns 1 and the old global, the Waiters, the
+ * messages and the string are all back. Finally the original run finishes
+ * the same way with its own state.
+ */
+
+#define CKPT_FILE  "test70.ckpt"
+
+int Waiter(char *);
+
+int tm_pid = -1;
+int sem, mbox;
+int waiters[3];
+int counter;
+char *note;
+
+static void wrapUp(char *who)
+{
+    char msg[16];
+    int i, status;
+
+    USLOSS_Console("%s: counter %d, note \"%s\"\n", who, counter, note);
+    for (i = 0; i < 3; i++) {
+        SemV(sem);
+        USLOSS_Console("%s: join() returned Waiter %d\n", who, join(&status) == waiters[i] ? status : -1);
+    }
+    for (i = 0; i < 2; i++) {
+        MboxRecv(mbox, msg, sizeof(msg));
+        USLOSS_Console("%s: received \"%s\"\n", who, msg);
+    }
+    USLOSS_Console("%s: checkProcessTable() returned %d\n", who, checkProcessTable());
+}
+
+int testcase_main()
+{
+    int rc, i, status;
+    pid_t child;
+
+    tm_pid = getpid();
+
+    if (getenv("USLOSS_HOST_CHECKPOINT") == NULL) {
+        USLOSS_Console("testcase_main(): restarting with USLOSS_HOST_CHECKPOINT set\n");
+        fflush(stdout);
+        setenv("USLOSS_HOST_CHECKPOINT", "1", 1);
+        execl("/proc/self/exe", "test70", (char *) NULL);
+        USLOSS_Console("testcase_main(): cannot restart\n");
+        return 0;
+    }
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: bad paths return -1; the restored run comes back from checkpointSave() with 1 and the state as saved; then the original run finishes with its own state.\n");
+
+    sem = SemCreate(0);
+    mbox = MboxCreate(4, 16);
+    for (i = 1; i <= 3; i++) {
+        waiters[i - 1] = spork("Waiter", Waiter, i == 1 ? "1" : i == 2 ? "2" : "3", USLOSS_MIN_STACK, 2);
+        TEMP_switchTo(waiters[i - 1]);
+    }
+    MboxSend(mbox, "first", 6);
+    MboxSend(mbox, "second", 7);
+    note = proc_alloc(32);
+    strcpy(note, "kept in the arena");
+    counter = 41;
+
+    USLOSS_Console("testcase_main(): checkpointSave(NULL) returned %d, checkpointSave(\"/nonexistent/x\") returned %d\n",
+                   checkpointSave(NULL), checkpointSave("/nonexistent/x"));
+
+    rc = checkpointSave(CKPT_FILE);
+    if (rc == 1) {
+        counter++;
+        wrapUp("restored run");
+        return 0;
+    }
+    USLOSS_Console("testcase_main(): checkpointSave() returned %d\n", rc);
+    counter = 99;
+    strcpy(note, "changed after the save");
+
+    fflush(stdout);
+    child = fork();
+    if (child == 0) {
+        setenv("USLOSS_HOST_RESTORE", CKPT_FILE, 1);
+        execl("/proc/self/exe", "test70", (char *) NULL);
+        _exit(127);
+    }
+    waitpid(child, &status, 0);
+    USLOSS_Console("testcase_main(): the restored run exited with status %d\n", WEXITSTATUS(status));
+    unlink(CKPT_FILE);
+
+    wrapUp("testcase_main()");
+    return 0;
+}
+
+int Waiter(char *arg)
+{
+    SemP(sem);
+    USLOSS_Console("Waiter %s: woke up, counter %d\n", arg, counter);
+    quit_phase_1a(atoi(arg), tm_pid);
+}
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks wait_any(): bad targets return -1; a target that is ready already
+ * returns at once, the lowest index first; testcase_main() then sleeps
+ * until a message arrives, a child quits, a timeout passes and a mailbox is
+ * released, each time with the other targets still registered. Nodes left
+ * on the other lists must be gone: a later tick or message does not wake
+ * anybody twice. Two watchers of one mailbox both wake, and only the first
+ * to receive gets the message.
+ */
+
+int Sender(char *);
+int Releaser(char *);
+int Watcher(char *);
+
+int tm_pid = -1;
+int mb, mb2;
+
+static void show(char *what, int rc)
+{
+    USLOSS_Console("testcase_main(): %s: wait_any() returned %d\n", what, rc);
+}
+
+int testcase_main()
+{
+    struct WaitTarget t[WAIT_MAX + 1];
+    char msg[16];
+    int pid, status, i;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: -1 for each bad call; then wake-ups by mailbox (0), child (0), timeout (1), release (0), and both watchers wake for one message.\n");
+
+    mb = MboxCreate(2, 16);
+    t[0].type = WAIT_MBOX;
+    t[0].id = mb;
+    USLOSS_Console("testcase_main(): NULL %d, count 0 %d, count WAIT_MAX+1 %d\n",
+                   wait_any(NULL, 1), wait_any(t, 0), wait_any(t, WAIT_MAX + 1));
+    t[1].type = 7;
+    t[1].id = 0;
+    USLOSS_Console("testcase_main(): bad type %d", wait_any(t, 2));
+    t[1].type = WAIT_CHILD;
+    t[1].id = -1;
+    USLOSS_Console(", no children %d", wait_any(t, 2));
+    t[1].id = tm_pid;
+    USLOSS_Console(", not a child %d", wait_any(t, 2));
+    t[1].type = WAIT_MBOX;
+    t[1].id = MAXMBOX;
+    USLOSS_Console(", bad mailbox %d", wait_any(t, 2));
+    t[1].type = WAIT_TICKS;
+    t[1].id = -1;
+    USLOSS_Console(", negative ticks %d\n", wait_any(t, 2));
+
+    // ready already: the lowest ready index wins
+    t[1].id = 0;
+    show("mailbox empty, timeout 0", wait_any(t, 2));
+    MboxSend(mb, "early", 6);
+    show("mailbox with a message, timeout 0", wait_any(t, 2));
+    MboxCondRecv(mb, msg, sizeof(msg));
+
+    // a message arrives while a child and a timeout are watched too
+    pid = spork("Sender", Sender, "hello", USLOSS_MIN_STACK, 4);
+    t[1].type = WAIT_CHILD;
+    t[1].id = -1;
+    t[2].type = WAIT_TICKS;
+    t[2].id = 20;
+    show("waiting for the mailbox, any child or 20 ticks", wait_any(t, 3));
+    USLOSS_Console("testcase_main(): MboxCondRecv() returned %d, \"%s\"\n", MboxCondRecv(mb, msg, sizeof(msg)), msg);
+
+    // the child quits
+    t[0].type = WAIT_CHILD;
+    t[0].id = pid;
+    t[1].type = WAIT_MBOX;
+    t[1].id = mb;
+    show("waiting for Sender or the mailbox", wait_any(t, 2));
+    USLOSS_Console("testcase_main(): join() returned %s", join(&status) == pid ? "Sender" : "something else");
+    USLOSS_Console(", status %d\n", status);
+
+    // nothing comes, so the timeout does
+    t[0].type = WAIT_MBOX;
+    t[0].id = mb;
+    t[1].type = WAIT_TICKS;
+    t[1].id = 3;
+    show("waiting for the mailbox or 3 ticks", wait_any(t, 2));
+
+    // a mailbox is released
+    mb2 = MboxCreate(0, 16);
+    pid = spork("Releaser", Releaser, NULL, USLOSS_MIN_STACK, 4);
+    t[0].id = mb2;
+    t[1].id = 20;
+    show("waiting for the zero-slot mailbox or 20 ticks", wait_any(t, 2));
+    USLOSS_Console("testcase_main(): MboxCondRecv() on it returned %d\n", MboxCondRecv(mb2, msg, sizeof(msg)));
+    show("waiting for Releaser", wait_any((struct WaitTarget[]) { { WAIT_CHILD, pid } }, 1));
+    join(&status);
+
+    // the 20-tick timeouts above were unlinked: sleeping past them wakes nobody
+    clockSleep(25);
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d\n", checkProcessTable());
+
+    // two watchers on one mailbox
+    pid = spork("Watcher", Watcher, NULL, USLOSS_MIN_STACK, 2);
+    TEMP_switchTo(pid);
+    spork("Sender", Sender, "shared", USLOSS_MIN_STACK, 4);
+    t[0].id = mb;
+    show("watching the mailbox alongside Watcher", wait_any(t, 1));
+    USLOSS_Console("testcase_main(): MboxCondRecv() returned %d\n", MboxCondRecv(mb, msg, sizeof(msg)));
+    for (i = 0; i < 2; i++) {
+        t[0].type = WAIT_CHILD;
+        t[0].id = -1;
+        wait_any(t, 1);
+        join(&status);
+    }
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d\n", checkProcessTable());
+    return 0;
+}
+
+int Sender(char *arg)
+{
+    USLOSS_Console("Sender: sending \"%s\"\n", arg);
+    MboxSend(mb, arg, strlen(arg) + 1);
+    USLOSS_Console("Sender: quitting\n");
+    quit_phase_1a(3, tm_pid);
+}
+
+int Releaser(char *arg)
+{
+    USLOSS_Console("Releaser: releasing the mailbox\n");
+    MboxRelease(mb2);
+    USLOSS_Console("Releaser: quitting\n");
+    quit_phase_1a(4, tm_pid);
+}
+
+int Watcher(char *arg)
+{
+    struct WaitTarget t = { WAIT_MBOX, mb };
+    char msg[16];
+
+    USLOSS_Console("Watcher: wait_any() returned %d\n", wait_any(&t, 1));
+    USLOSS_Console("Watcher: MboxCondRecv() returned %d, \"%s\"\n", MboxCondRecv(mb, msg, sizeof(msg)), msg);
+    quit_phase_1a(5, tm_pid);
+}
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks yield_to(): stale and bad pids return -1; the caller itself, a
+ * blocked process and a zombie return -2. testcase_main() and Pong then
+ * bounce the CPU back and forth three times, and the counters show three
+ * handoffs each way plus the refusals. Finally, yielding to B while A is
+ * ahead of it on the same ready queue runs B at once, and puts
+ * testcase_main() behind A, so A runs next when B sleeps.
+ */
+
+#define ROUNDS  3
+
+int Pong(char *), Blocker(char *), Quitter(char *), A(char *), B(char *);
+
+int tm_pid = -1;
+int sem;
+
+static void showStats(char *name, int pid)
+{
+    struct YieldStats stats;
+
+    yieldStats(pid, &stats);
+    USLOSS_Console("testcase_main(): %s: given %d, received %d, refused %d\n", name,
+                   stats.given, stats.received, stats.refused);
+}
+
+int testcase_main()
+{
+    struct WaitTarget t = { WAIT_CHILD, -1 };
+    int blocker, quitter, pong, b, status, i;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: -1, -1, -2, -2, -2 for the bad calls; three round trips with Pong; then B runs before A, and A before testcase_main().\n");
+
+    sem = SemCreate(0);
+    blocker = spork("Blocker", Blocker, NULL, USLOSS_MIN_STACK, 2);
+    TEMP_switchTo(blocker);
+    quitter = spork("Quitter", Quitter, NULL, USLOSS_MIN_STACK, 2);
+    TEMP_switchTo(quitter);
+
+    USLOSS_Console("testcase_main(): yield_to(-1) %d, yield_to(stale) %d, yield_to(self) %d, yield_to(Blocker) %d, yield_to(Quitter) %d\n",
+                   yield_to(-1), yield_to(quitter + MAXPROC), yield_to(tm_pid), yield_to(blocker), yield_to(quitter));
+    USLOSS_Console("testcase_main(): yieldStats(stale) %d, yieldStats(NULL) %d\n",
+                   yieldStats(quitter + MAXPROC, NULL), yieldStats(tm_pid, NULL));
+    join(&status);
+    SemV(sem);
+    join(&status);
+
+    pong = spork("Pong", Pong, NULL, USLOSS_MIN_STACK, 3);
+    for (i = 0; i < ROUNDS; i++) {
+        USLOSS_Console("testcase_main(): round %d, yield_to(Pong)\n", i);
+        USLOSS_Console("testcase_main(): back, yield_to() returned %d\n", yield_to(pong));
+    }
+    showStats("own counters", tm_pid);
+    showStats("Pong's counters", pong);
+    yield_to(pong);
+    join(&status);
+
+    spork("A", A, NULL, USLOSS_MIN_STACK, 3);
+    b = spork("B", B, NULL, USLOSS_MIN_STACK, 3);
+    USLOSS_Console("testcase_main(): yield_to(B) with A ahead of it\n");
+    yield_to(b);
+    USLOSS_Console("testcase_main(): running again\n");
+    wait_any(&t, 1);
+    join(&status);
+    wait_any(&t, 1);
+    join(&status);
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d\n", checkProcessTable());
+    return 0;
+}
+
+int Pong(char *arg)
+{
+    int i;
+
+    for (i = 0; i < ROUNDS; i++) {
+        USLOSS_Console("Pong: round %d, yield_to(testcase_main)\n", i);
+        yield_to(tm_pid);
+    }
+    quit_phase_1a(0, tm_pid);
+}
+
+int Blocker(char *arg)
+{
+    SemP(sem);
+    quit_phase_1a(0, tm_pid);
+}
+
+int Quitter(char *arg)
+{
+    quit_phase_1a(0, tm_pid);
+}
+
+int A(char *arg)
+{
+    USLOSS_Console("A: running\n");
+    quit_phase_1a(0, tm_pid);
+}
+
+int B(char *arg)
+{
+    USLOSS_Console("B: running, going to sleep\n");
+    clockSleep(1);
+    USLOSS_Console("B: woke up\n");
+    quit_phase_1a(0, tm_pid);
+}
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks group CPU quotas: bad arguments return -1. Hog, in a group allowed
+ * 2 ms in every 100 ms, trades the CPU with testcase_main() through
+ * yield_to() and burns 1.5 ms each turn; after its second turn the group is
+ * over its quota, so at testcase_main()'s next kernel entry it is throttled
+ * and yield_to(Hog) is refused. A process moved into the group then waits
+ * too, until the quota is lifted. With the quota set again, Hog sleeps
+ * between slices; the group is throttled a second time while it sleeps, and
+ * Hog finishes once the next period starts.
+ */
+
+#define BURN_US 1500
+
+int Hog(char *), Joiner(char *);
+
+int tm_pid = -1;
+
+static void burn(void)
+{
+    int start = currentTime();
+
+    while (currentTime() - start < BURN_US) {
+    }
+}
+
+// the time throttled is only shown once a throttle is over, since one that
+// has just begun may not have lasted a microsecond yet
+static void showStats(int gid)
+{
+    struct QuotaStats stats;
+
+    groupQuotaStats(gid, &stats);
+    USLOSS_Console("testcase_main(): quota %d/%d, over quota %d, throttled %d, throttles %d",
+                   stats.quota, stats.period, stats.used >= stats.quota && stats.quota > 0, stats.throttled,
+                   stats.throttles);
+    if (!stats.throttled) {
+        USLOSS_Console(", time throttled %s", stats.throttledTime > 0 ? "> 0" : "0");
+    }
+    USLOSS_Console("\n");
+}
+
+int testcase_main()
+{
+    struct WaitTarget any = { WAIT_CHILD, -1 };
+    int gid, hog, joiner, status, i;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: -1 for each bad call; Hog runs twice, then yield_to(Hog) returns -2 and Joiner waits until the quota is lifted; Hog is throttled once more while sleeping, then finishes.\n");
+
+    gid = create_group();
+    USLOSS_Console("testcase_main(): bad group %d, negative quota %d, zero period %d, stats NULL %d\n",
+                   set_group_quota(MAXGROUPS, 100, 1000), set_group_quota(gid, -1, 1000),
+                   set_group_quota(gid, 100, 0), groupQuotaStats(gid, NULL));
+
+    hog = spork("Hog", Hog, NULL, USLOSS_MIN_STACK, 4);
+    set_group(hog, gid);
+    USLOSS_Console("testcase_main(): set_group_quota() returned %d\n", set_group_quota(gid, 2000, 100000));
+
+    for (i = 0; i < 3; i++) {
+        USLOSS_Console("testcase_main(): turn %d, yield_to(Hog) returned %d\n", i, yield_to(hog));
+    }
+    showStats(gid);
+
+    // a ready process that joins a throttled group is parked with it
+    joiner = spork("Joiner", Joiner, NULL, USLOSS_MIN_STACK, 4);
+    set_group(joiner, gid);
+    USLOSS_Console("testcase_main(): Joiner in the group, yield_to(Joiner) returned %d, checkProcessTable() returned %d\n",
+                   yield_to(joiner), checkProcessTable());
+    USLOSS_Console("testcase_main(): lifting the quota returned %d\n", set_group_quota(gid, 0, 0));
+    showStats(gid);
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d\n", checkProcessTable());
+
+    // Hog runs first, having been parked first; Joiner then quits
+    set_group_quota(gid, 2000, 100000);
+    wait_any(&any, 1);
+    USLOSS_Console("testcase_main(): join() returned %s\n", join(&status) == joiner ? "Joiner" : "something else");
+
+    // Hog sleeps between slices, and is throttled while asleep
+    wait_any(&any, 1);
+    USLOSS_Console("testcase_main(): join() returned %s\n", join(&status) == hog ? "Hog" : "something else");
+    showStats(gid);
+    USLOSS_Console("testcase_main(): free_group() returned %d, checkProcessTable() returned %d\n",
+                   free_group(gid), checkProcessTable());
+    return 0;
+}
+
+int Hog(char *arg)
+{
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        USLOSS_Console("Hog: turn %d\n", i);
+        burn();
+        yield_to(tm_pid);
+    }
+    USLOSS_Console("Hog: burning in slices\n");
+    for (i = 0; i < 3; i++) {
+        burn();
+        clockSleep(1);
+        USLOSS_Console("Hog: slice %d done\n", i);
+    }
+    quit_phase_1a(1, tm_pid);
+}
+
+int Joiner(char *arg)
+{
+    USLOSS_Console("Joiner: running\n");
+    quit_phase_1a(2, tm_pid);
+}
@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks that a recording survives a halt (host harness only): a forked
+ * copy of the run records a scenario with a clock tick and then halts
+ * without calling schedLogStop(). The log it leaves behind replays in the
+ * original run with the same events as a recording stopped normally.
+ */
+
+#define LOG "test74.sched"
+
+int Worker(char *);
+
+int tm_pid = -1;
+int sem;
+
+static void scenario(char *who)
+{
+    int status, pids[2];
+
+    sem = SemCreate(0);
+    pids[0] = spork("Waiter", Worker, "wait", USLOSS_MIN_STACK, 2);
+    pids[1] = spork("Poster", Worker, "post", USLOSS_MIN_STACK, 2);
+
+    TEMP_switchTo(pids[0]);
+    USLOSS_Console("%s: joined %s\n", who, join(&status) == pids[1] ? "Poster" : "something else");
+    TEMP_switchTo(pids[0]);
+    USLOSS_Console("%s: joined %s\n", who, join(&status) == pids[0] ? "Waiter" : "something else");
+    SemFree(sem);
+}
+
+int testcase_main()
+{
+    int status;
+    pid_t child;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: the recording run halts before schedLogStop(); its log replays all 6 events.\n");
+
+    fflush(stdout);
+    child = fork();
+    if (child == 0) {
+        USLOSS_Console("recording run: schedRecordStart() returned %d\n", schedRecordStart(LOG));
+        scenario("recording run");
+        USLOSS_Console("recording run: halting\n");
+        USLOSS_Halt(3);
+    }
+    waitpid(child, &status, 0);
+    USLOSS_Console("testcase_main(): the recording run exited with status %d\n", WEXITSTATUS(status));
+
+    USLOSS_Console("testcase_main(): schedReplayStart() returned %d\n", schedReplayStart(LOG));
+    scenario("testcase_main()");
+    USLOSS_Console("testcase_main(): replayed %d events\n", schedLogStop());
+    unlink(LOG);
+    return 0;
+}
+
+int Worker(char *arg)
+{
+    if (arg[0] == 'w') {
+        SemP(sem);
+    }
+    else {
+        USLOSS_IntVec[USLOSS_CLOCK_INT](USLOSS_CLOCK_DEV, NULL);
+        SemV(sem);
+    }
+    quit_phase_1a(0, tm_pid);
+}
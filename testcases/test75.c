@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks that quitting releases held mutexes: Holder quits while holding
+ * two mutexes, one of them with a process waiting. The waiter becomes the
+ * owner without running first, the other mutex is unlocked, and
+ * testcase_main(), which never held either, still cannot unlock them.
+ */
+
+int Holder(char *), Waiter(char *);
+
+int tm_pid = -1;
+int gate, busy, idle;
+
+int testcase_main()
+{
+    int status, holder, waiter;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: Holder quits holding both mutexes. Waiter then owns the one it waited for, and the other is free.\n");
+
+    gate = SemCreate(0);
+    busy = MutexCreate();
+    idle = MutexCreate();
+
+    holder = spork("Holder", Holder, NULL, USLOSS_MIN_STACK, 4);
+    TEMP_switchTo(holder);
+    waiter = spork("Waiter", Waiter, NULL, USLOSS_MIN_STACK, 4);
+    TEMP_switchTo(waiter);
+
+    USLOSS_Console("testcase_main(): Waiter is blocked, letting Holder quit\n");
+    SemV(gate);
+    TEMP_switchTo(holder);
+    USLOSS_Console("testcase_main(): join() returned %s\n", join(&status) == holder ? "Holder" : "something else");
+
+    USLOSS_Console("testcase_main(): MutexUnlock() on Waiter's mutex returned %d\n", MutexUnlock(busy));
+    USLOSS_Console("testcase_main(): MutexLock() on the other returned %d\n", MutexLock(idle));
+    USLOSS_Console("testcase_main(): MutexUnlock() on it returned %d\n", MutexUnlock(idle));
+
+    TEMP_switchTo(waiter);
+    USLOSS_Console("testcase_main(): join() returned %s\n", join(&status) == waiter ? "Waiter" : "something else");
+    return 0;
+}
+
+int Holder(char *arg)
+{
+    USLOSS_Console("Holder: MutexLock() returned %d and %d\n", MutexLock(busy), MutexLock(idle));
+    SemP(gate);
+    USLOSS_Console("Holder: quitting with both mutexes held\n");
+    quit_phase_1a(1, tm_pid);
+}
+
+int Waiter(char *arg)
+{
+    int rc = MutexLock(busy);
+
+    USLOSS_Console("Waiter: MutexLock() returned %d\n", rc);
+    USLOSS_Console("Waiter: MutexUnlock() returned %d\n", MutexUnlock(busy));
+    quit_phase_1a(2, tm_pid);
+}
@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include <string.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks the rule for writable region views across spork_clone(): the
+ * pointer the parent took before cloning points into the buffer the child
+ * now shares, and calling regionWrite() again gives the parent a private
+ * copy, so what it writes from then on stays out of the child's view.
+ */
+
+int Child(char *);
+
+int tm_pid = -1;
+int table;
+
+int testcase_main()
+{
+    int status, pid;
+    char *before, *after;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: after spork_clone(), regionWrite() returns a new pointer; the child still reads \"before\".\n");
+
+    table = regionCreate(64);
+    before = regionWrite(table);
+    strcpy(before, "before");
+
+    pid = spork_clone("Child", Child, NULL, USLOSS_MIN_STACK, 2);
+    USLOSS_Console("testcase_main(): the child shares the old pointer's buffer: %s\n",
+                   before == (char *) regionGet(table) ? "yes" : "no");
+
+    after = regionWrite(table);
+    USLOSS_Console("testcase_main(): regionWrite() after cloning returned %s pointer\n",
+                   after == before ? "the same" : "a new");
+    strcpy(after, "after");
+
+    TEMP_switchTo(pid);
+    USLOSS_Console("testcase_main(): parent reads \"%s\"\n", (char *) regionGet(table));
+    join(&status);
+    regionDetach(table);
+    return 0;
+}
+
+int Child(char *arg)
+{
+    USLOSS_Console("Child(): reads \"%s\"\n", (char *) regionGet(table));
+    quit_phase_1a(0, tm_pid);
+}
@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/*
+ * Checks MboxRelease() against a kill_group() from one of the waiters it
+ * wakes: Killer and Member both wait on a mailbox, Killer first. Releasing
+ * the mailbox readies both, and Killer, which outranks testcase_main(),
+ * runs and kills Member's group. Member is already ready by then, so it is
+ * only marked: its MboxRecv() returns -3 and isKilled() returns 1, and it
+ * is woken exactly once.
+ */
+
+int Killer(char *), Member(char *);
+
+int tm_pid = -1;
+int mbox, gid;
+
+int testcase_main()
+{
+    int status, killer, member;
+
+    tm_pid = getpid();
+
+    USLOSS_Console("testcase_main(): started\n");
+    USLOSS_Console("EXPECTATION: Killer runs right after the release and kills Member's group; Member then sees -3 and isKilled() 1.\n");
+
+    mbox = MboxCreate(1, 16);
+    gid = create_group();
+
+    killer = spork("Killer", Killer, NULL, USLOSS_MIN_STACK, 2);
+    TEMP_switchTo(killer);
+    member = spork("Member", Member, NULL, USLOSS_MIN_STACK, 4);
+    set_group(member, gid);
+    TEMP_switchTo(member);
+
+    USLOSS_Console("testcase_main(): both are blocked, releasing the mailbox\n");
+    USLOSS_Console("testcase_main(): MboxRelease() returned %d\n", MboxRelease(mbox));
+    USLOSS_Console("testcase_main(): checkProcessTable() returned %d\n", checkProcessTable());
+
+    TEMP_switchTo(member);
+    USLOSS_Console("testcase_main(): join() returned %s\n", join(&status) == member ? "Member" : "something else");
+    USLOSS_Console("testcase_main(): join() returned %s\n", join(&status) == killer ? "Killer" : "something else");
+    USLOSS_Console("testcase_main(): free_group() returned %d\n", free_group(gid));
+    return 0;
+}
+
+int Killer(char *arg)
+{
+    char msg[16];
+    int rc = MboxRecv(mbox, msg, sizeof(msg));
+
+    USLOSS_Console("Killer: MboxRecv() returned %d\n", rc);
+    USLOSS_Console("Killer: kill_group() returned %d\n", kill_group(gid));
+    quit_phase_1a(1, tm_pid);
+}
+
+int Member(char *arg)
+{
+    char msg[16];
+    int rc = MboxRecv(mbox, msg, sizeof(msg));
+
+    USLOSS_Console("Member: MboxRecv() returned %d, isKilled() returned %d\n", rc, isKilled());
+    quit_phase_1a(2, tm_pid);
+}
@@ -0,0 +1,222 @@
+#include "phase1helper.h"
+#include "phase1.h"
+#include "kernel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Waiting on several things at once. A process in wait_any() puts one
+ * WaitNode per target on that target's watch list: its parent's list of
+ * child watchers, a mailbox's watchers, or the clock's tick watchers. The
+ * nodes live in wait_any()'s own frame and are doubly linked, so when any
+ * target becomes ready watchFire() takes the process off every list it is
+ * on in O(k) and readies it. The owners of the lists only ever call
+ * watchWake() or watchFire(); none of them needs to know who is watching.
+ */
+
+/*
+ * Function: watchAdd
+ * ------------------
+ * This function puts a node at the head of a watch list.
+ */
+void watchAdd(struct WaitNode **list, struct WaitNode *node) {
+    node->next = *list;
+    if (node->next != NULL) {
+        node->next->pprev = &node->next;
+    }
+    node->pprev = list;
+    *list = node;
+}
+
+static void watchRemove(struct WaitNode *node) {
+    if (node->pprev == NULL) {
+        return;
+    }
+    *node->pprev = node->next;
+    if (node->next != NULL) {
+        node->next->pprev = node->pprev;
+    }
+    node->next = NULL;
+    node->pprev = NULL;
+}
+
+/*
+ * Function: unwatchAll
+ * --------------------
+ * This function takes a process's nodes off every list they are on.
+ */
+static void unwatchAll(struct PCB *proc, int count) {
+    int i;
+
+    for (i = 0; i < count; i++) {
+        watchRemove(&proc->wait_nodes[i]);
+    }
+    proc->wait_nodes = NULL;
+}
+
+/*
+ * Function: watchFire
+ * -------------------
+ * This function wakes the process a node belongs to, recording the node's
+ * target as the one that woke it. It does not switch.
+ */
+void watchFire(struct WaitNode *node) {
+    struct PCB *proc = node->proc;
+
+    proc->wait_hit = node - proc->wait_nodes;
+    unwatchAll(proc, proc->wait_count);
+    readyProcess(proc);
+}
+
+/*
+ * Function: watchWake
+ * -------------------
+ * This function wakes every process on a watch list.
+ *
+ * @param int preempt: 1 to run the best of them right away if it outranks
+ *                     the caller; 0 if the caller cannot switch here
+ */
+void watchWake(struct WaitNode **list, int preempt) {
+    if (*list == NULL) {
+        return;
+    }
+    while (*list != NULL) {
+        watchFire(*list);
+    }
+    if (preempt) {
+        preemptIfOutranked();
+    }
+}
+
+/*
+ * Function: waitAnyCancel
+ * -----------------------
+ * This function takes a blocked wait_any() caller off every list it is
+ * watching, for cancelWait(). The caller readies it.
+ */
+void waitAnyCancel(struct PCB *proc) {
+    unwatchAll(proc, proc->wait_count);
+}
+
+/*
+ * Function: childReady
+ * --------------------
+ * This function tells whether a WAIT_CHILD target is ready: the child (any
+ * child, for -1) is a zombie, so join() would not come back empty.
+ */
+static int childReady(struct PCB *parent, int pid) {
+    struct PCB *child;
+
+    for (child = parent->first_child; child != NULL; child = child->next_sibling) {
+        if ((pid == -1 || child->pid == pid) && child->run_state == PROC_ZOMBIE) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Function: waitAnyChildQuit
+ * --------------------------
+ * This function wakes the parent of a process that has just become a
+ * zombie, if the parent is watching it; called from quit_phase_1a(). It
+ * does not switch, since the quitting process switches next anyway.
+ */
+void waitAnyChildQuit(struct PCB *child) {
+    struct PCB *parent = child->parent;
+    struct WaitNode *node;
+
+    if (parent == NULL) {
+        return;
+    }
+    for (node = parent->child_watch; node != NULL; node = node->next) {
+        if (node->id == -1 || node->id == child->pid) {
+            watchFire(node);
+            return;
+        }
+    }
+}
+
+/*
+ * Function: wait_any
+ * ------------------
+ * This function blocks until one of several targets is ready and returns
+ * its index. Targets that are ready already are checked in order while the
+ * nodes are put on the watch lists, in the same pass. Readiness is only a
+ * hint to act on: after WAIT_CHILD, join(); after WAIT_MBOX, MboxCondRecv(),
+ * which can still return -2 if another receiver got the message first.
+ *
+ * @param struct WaitTarget *targets: what to wait for; see phase1.h
+ *
+ * @param int count: number of targets, 1..WAIT_MAX
+ *
+ * @return int -1: returned if targets is NULL, count is out of range, or a
+ *                 target is invalid: an unknown type, a pid that is not a
+ *                 child of the caller, -1 when it has no children, a bad
+ *                 mailbox ID or a negative tick count
+ *
+ * @return int -4: returned if kill_group() woke it while blocked
+ *
+ * @return int >=0: index of the target that is ready
+ */
+int wait_any(struct WaitTarget *targets, int count) {
+    checkKernelMode("wait_any");
+
+    struct WaitNode nodes[WAIT_MAX];
+    int i;
+
+    if (targets == NULL || count < 1 || count > WAIT_MAX) {
+        return -1;
+    }
+    curProcess->wait_nodes = nodes;
+    curProcess->wait_count = count;
+    memset(nodes, 0, count * sizeof(struct WaitNode));
+
+    for (i = 0; i < count; i++) {
+        struct WaitNode *node = &nodes[i];
+        int id = targets[i].id;
+        int ready;
+
+        node->proc = curProcess;
+        node->id = id;
+        if (targets[i].type == WAIT_CHILD) {
+            struct PCB *child = pid_lookup(id);
+
+            if ((id == -1 && curProcess->first_child == NULL) ||
+                (id != -1 && (child == NULL || child->parent != curProcess))) {
+                ready = -1;
+            }
+            else {
+                ready = childReady(curProcess, id);
+                if (!ready) {
+                    watchAdd(&curProcess->child_watch, node);
+                }
+            }
+        }
+        else if (targets[i].type == WAIT_MBOX) {
+            ready = mboxWatch(id, node);
+        }
+        else if (targets[i].type == WAIT_TICKS && id >= 0) {
+            ready = id == 0;
+            if (!ready) {
+                tickWatch(node, id);
+            }
+        }
+        else {
+            ready = -1;
+        }
+
+        if (ready != 0) {
+            unwatchAll(curProcess, i);
+            return ready < 0 ? -1 : i;
+        }
+    }
+
+    curProcess->wait_result = 0;
+    blockMe();
+    if (curProcess->wait_result < 0) {
+        return curProcess->wait_result;
+    }
+    return curProcess->wait_hit;
+}